@@ -0,0 +1,67 @@
+#include "ActivityGate.h"
+
+#include <algorithm>
+
+namespace Tracker
+{
+    /********************************************************************
+    ActivityGate
+        Sets up the gate, the first frame is always active
+    Exceptions:
+        None
+    *********************************************************************/
+    ActivityGate::ActivityGate( const ActivityGateSettings& settings )
+        : m_settings( settings ),
+        m_idleFrames( 0 ),
+        m_samples( ),
+        m_previousSamples( ),
+        m_difference( )
+    {
+        m_settings.m_sampleStep = std::max( 1, m_settings.m_sampleStep );
+    }
+
+    /********************************************************************
+    IsActive
+        Samples the frame and counts the samples that changed from the
+        previous frame
+    Exceptions:
+        None
+    *********************************************************************/
+    bool ActivityGate::IsActive( const cv::Mat& frame, const bool maySkip )
+    {
+        const cv::Size sampleSize( std::max( 1, frame.cols / m_settings.m_sampleStep ),
+                                   std::max( 1, frame.rows / m_settings.m_sampleStep ) );
+
+        // nearest neighbour resizing only reads the pixels of the grid
+        cv::resize( frame, m_difference, sampleSize, 0, 0, CV_INTER_NEAREST );
+        if ( m_difference.channels() == 3 )
+        {
+            cv::cvtColor( m_difference, m_samples, CV_BGR2GRAY );
+        }
+        else
+        {
+            m_difference.copyTo( m_samples );
+        }
+
+        bool active = true;
+        if ( m_previousSamples.size() == m_samples.size() )
+        {
+            cv::absdiff( m_samples, m_previousSamples, m_difference );
+            cv::threshold( m_difference, m_difference, m_settings.m_pixelThreshold, 255, cv::THRESH_BINARY );
+
+            const double changedPercent = 100.0 * cv::countNonZero( m_difference ) / m_difference.total();
+            active = changedPercent >= m_settings.m_minChangedPercent;
+        }
+        std::swap( m_samples, m_previousSamples );
+
+        // let a frame through now and then for the background model
+        if ( !active && maySkip && m_idleFrames < m_settings.m_refreshInterval )
+        {
+            m_idleFrames++;
+            return false;
+        }
+
+        m_idleFrames = 0;
+        return true;
+    }
+}
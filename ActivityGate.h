@@ -0,0 +1,59 @@
+#ifndef ACTIVITY_GATE_H
+#define ACTIVITY_GATE_H
+
+#include "OpenCvDefinitions.h"
+#include "CommonMacros.h"
+
+namespace Tracker
+{
+    /*
+    *   Settings of the activity gate.
+    */
+    struct ActivityGateSettings
+    {
+        ActivityGateSettings( )
+            : m_sampleStep( 8 ),
+            m_pixelThreshold( 15 ),
+            m_minChangedPercent( 0.5 ),
+            m_refreshInterval( 25 )
+        {
+        }
+
+        int                 m_sampleStep;           // compare every Nth pixel of every Nth row
+        int                 m_pixelThreshold;       // gray level difference of a changed pixel
+        double              m_minChangedPercent;    // changed samples of an active frame
+        int                 m_refreshInterval;      // idle frames between background updates
+    };
+
+    /*
+    *   Cheap check whether a frame differs from the previous one. The
+    *   frame is sampled on a coarse grid and the gray levels are compared
+    *   with the previous samples, so that frames of an empty scene can
+    *   skip the tracking pipeline. Every m_refreshInterval idle frames
+    *   one is let through, so that the background model keeps adapting.
+    */
+    class ActivityGate
+    {
+    public:
+    // Constructor
+    explicit ActivityGate( const ActivityGateSettings& settings );
+
+    // Whether the frame has to run the pipeline; only frames that may be
+    // skipped, i.e. nothing is tracked, can be idle
+    bool IsActive( const cv::Mat& frame, const bool maySkip );
+
+    // Getters
+    int  GetIdleFrames( ) const     { return m_idleFrames; }
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( ActivityGate );
+
+    ActivityGateSettings            m_settings;
+    int                             m_idleFrames;       // consecutive idle frames
+    cv::Mat                         m_samples;
+    cv::Mat                         m_previousSamples;
+    cv::Mat                         m_difference;
+    };
+}
+#endif
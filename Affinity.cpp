@@ -0,0 +1,298 @@
+#include "Affinity.h"
+
+#include <sstream>
+#include <set>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(WIN32) || defined(WIN64)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#endif
+
+namespace Tracker
+{
+    /********************************************************************
+    GetThreadAffinity
+        Cores the calling thread may run on
+    Exceptions:
+        None
+    *********************************************************************/
+    static bool GetThreadAffinity( CoreSet& cores )
+    {
+        cores.clear();
+#if defined(WIN32) || defined(WIN64)
+        DWORD_PTR processMask, systemMask;
+        if ( !GetProcessAffinityMask( GetCurrentProcess(), &processMask, &systemMask ) )
+        {
+            return false;
+        }
+        for ( int core = 0; core < (int)( sizeof(DWORD_PTR) * 8 ); core++ )
+        {
+            if ( processMask & ( (DWORD_PTR)1 << core ) )
+            {
+                cores.push_back( core );
+            }
+        }
+#else
+        cpu_set_t cpuSet;
+        CPU_ZERO( &cpuSet );
+        if ( pthread_getaffinity_np( pthread_self(), sizeof(cpuSet), &cpuSet ) != 0 )
+        {
+            return false;
+        }
+        for ( int core = 0; core < CPU_SETSIZE; core++ )
+        {
+            if ( CPU_ISSET( core, &cpuSet ) )
+            {
+                cores.push_back( core );
+            }
+        }
+#endif
+        return true;
+    }
+
+    /********************************************************************
+    ParseCoreSet
+        Parses comma separated cores and core ranges
+    Exceptions:
+        None
+    *********************************************************************/
+    bool ParseCoreSet( const std::string&  text,
+                       CoreSet&            cores )
+    {
+        std::set<int> coreSet;
+
+        std::istringstream items( text );
+        std::string item;
+        while ( std::getline( items, item, ',' ) )
+        {
+            int first, last;
+            char separator;
+            std::istringstream range( item );
+            if ( !( range >> first ) || first < 0 )
+            {
+                return false;
+            }
+            if ( range >> separator )
+            {
+                if ( separator != '-' || !( range >> last ) || last < first )
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                last = first;
+            }
+
+            for ( int core = first; core <= last; core++ )
+            {
+                coreSet.insert( core );
+            }
+        }
+
+        cores.assign( coreSet.begin(), coreSet.end() );
+        return true;
+    }
+
+    /********************************************************************
+    FormatCoreSet
+        Formats a core set with ranges, e.g. "0-7,16-23"
+    Exceptions:
+        None
+    *********************************************************************/
+    std::string FormatCoreSet( const CoreSet& cores )
+    {
+        std::ostringstream text;
+        for ( unsigned int i = 0; i < cores.size(); )
+        {
+            unsigned int j = i;
+            while ( j + 1 < cores.size() && cores[j + 1] == cores[j] + 1 )
+            {
+                j++;
+            }
+
+            text << ( i > 0 ? "," : "" ) << cores[i];
+            if ( j > i )
+            {
+                text << '-' << cores[j];
+            }
+            i = j + 1;
+        }
+        return text.str();
+    }
+
+    /********************************************************************
+    SetThreadAffinity
+        Restricts the calling thread to the cores, or lets it run on all
+        cores of the process when the set is empty
+    Exceptions:
+        None
+    *********************************************************************/
+    bool SetThreadAffinity( const CoreSet& cores )
+    {
+#if defined(WIN32) || defined(WIN64)
+        DWORD_PTR mask = 0;
+        if ( cores.empty() )
+        {
+            DWORD_PTR systemMask;
+            GetProcessAffinityMask( GetCurrentProcess(), &mask, &systemMask );
+        }
+        for ( unsigned int i = 0; i < cores.size(); i++ )
+        {
+            if ( cores[i] < (int)( sizeof(DWORD_PTR) * 8 ) )
+            {
+                mask |= (DWORD_PTR)1 << cores[i];
+            }
+        }
+        return mask != 0 && SetThreadAffinityMask( GetCurrentThread(), mask ) != 0;
+#else
+        cpu_set_t cpuSet;
+        CPU_ZERO( &cpuSet );
+        if ( cores.empty() )
+        {
+            if ( sched_getaffinity( 0, sizeof(cpuSet), &cpuSet ) != 0 )
+            {
+                return false;
+            }
+        }
+        for ( unsigned int i = 0; i < cores.size(); i++ )
+        {
+            if ( cores[i] < CPU_SETSIZE )
+            {
+                CPU_SET( cores[i], &cpuSet );
+            }
+        }
+        return pthread_setaffinity_np( pthread_self(), sizeof(cpuSet), &cpuSet ) == 0;
+#endif
+    }
+
+    /********************************************************************
+    GetCoreNode
+        NUMA node of a core
+    Exceptions:
+        None
+    *********************************************************************/
+    int GetCoreNode( const int core )
+    {
+#if defined(WIN32) || defined(WIN64)
+        UCHAR node;
+        if ( core < 256 && GetNumaProcessorNode( (UCHAR)core, &node ) && node != 0xFF )
+        {
+            return node;
+        }
+        return -1;
+#else
+        // the core directory links to its node as node<N>
+        char directoryName[64];
+        sprintf( directoryName, "/sys/devices/system/cpu/cpu%d", core );
+
+        DIR* pDirectory = opendir( directoryName );
+        if ( pDirectory == NULL )
+        {
+            return -1;
+        }
+
+        int node = -1;
+        struct dirent* pEntry;
+        while ( node < 0 && ( pEntry = readdir( pDirectory ) ) != NULL )
+        {
+            if ( sscanf( pEntry->d_name, "node%d", &node ) != 1 )
+            {
+                node = -1;
+            }
+        }
+        closedir( pDirectory );
+        return node;
+#endif
+    }
+
+    /********************************************************************
+    FormatCoreNodes
+        Lists the NUMA nodes of a core set, "?" when unknown
+    Exceptions:
+        None
+    *********************************************************************/
+    std::string FormatCoreNodes( const CoreSet& cores )
+    {
+        std::set<int> nodes;
+        for ( unsigned int i = 0; i < cores.size(); i++ )
+        {
+            nodes.insert( GetCoreNode( cores[i] ) );
+        }
+
+        std::ostringstream text;
+        for ( std::set<int>::const_iterator it = nodes.begin(); it != nodes.end(); ++it )
+        {
+            text << ( it != nodes.begin() ? "," : "" );
+            if ( *it < 0 )
+            {
+                text << '?';
+            }
+            else
+            {
+                text << *it;
+            }
+        }
+        return text.str();
+    }
+
+    /********************************************************************
+    GetMemoryNode
+        Asks the kernel where the page of an address resides
+    Exceptions:
+        None
+    *********************************************************************/
+    int GetMemoryNode( const void* pAddress )
+    {
+#if !defined(WIN32) && !defined(WIN64) && defined(SYS_move_pages)
+        if ( pAddress == NULL )
+        {
+            return -1;
+        }
+
+        const long pageSize = sysconf( _SC_PAGESIZE );
+        void* pPage = (void*)( (size_t)pAddress & ~( (size_t)pageSize - 1 ) );
+        int status = -1;
+
+        // without target nodes move_pages only reports the current node
+        if ( syscall( SYS_move_pages, 0, 1UL, &pPage, NULL, &status, 0 ) != 0 )
+        {
+            return -1;
+        }
+        return status >= 0 ? status : -1;
+#else
+        return -1;
+#endif
+    }
+
+    /********************************************************************
+    ThreadAffinityScope
+        Pins the calling thread, unless the core set is empty
+    Exceptions:
+        None
+    *********************************************************************/
+    ThreadAffinityScope::ThreadAffinityScope( const CoreSet& cores )
+        : m_pinned( false ),
+        m_previousCores( )
+    {
+        if ( !cores.empty() && GetThreadAffinity( m_previousCores ) )
+        {
+            m_pinned = SetThreadAffinity( cores );
+        }
+    }
+
+    ThreadAffinityScope::~ThreadAffinityScope( )
+    {
+        if ( m_pinned )
+        {
+            SetThreadAffinity( m_previousCores );
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <string>
+#include <vector>
+
+namespace Tracker
+{
+    // Logical processors a thread may run on, empty for all of them
+    typedef std::vector<int> CoreSet;
+
+    // Parse a core list such as "0-7,16-23"
+    bool        ParseCoreSet( const std::string&    text,
+                              CoreSet&              cores );
+
+    // Format a core set as a core list
+    std::string FormatCoreSet( const CoreSet& cores );
+
+    // Restrict the calling thread to the cores, all cores when empty
+    bool        SetThreadAffinity( const CoreSet& cores );
+
+    // NUMA node of a core, -1 if unknown
+    int         GetCoreNode( const int core );
+
+    // NUMA nodes of the cores, formatted as a list
+    std::string FormatCoreNodes( const CoreSet& cores );
+
+    // NUMA node of the memory page holding the address, -1 if unknown
+    int         GetMemoryNode( const void* pAddress );
+
+    /*
+    *   Restricts the calling thread to a core set for the lifetime of the
+    *   object. Memory first touched meanwhile is placed by the operating
+    *   system on the NUMA node of those cores, and threads started
+    *   meanwhile inherit the core set.
+    */
+    class ThreadAffinityScope
+    {
+    public:
+    explicit ThreadAffinityScope( const CoreSet& cores );
+    ~ThreadAffinityScope( );
+
+    private:
+
+    ThreadAffinityScope( const ThreadAffinityScope& );
+    ThreadAffinityScope& operator=( const ThreadAffinityScope& );
+
+    bool                            m_pinned;
+    CoreSet                         m_previousCores;
+    };
+}
+#endif
@@ -0,0 +1,141 @@
+#include "BackgroundSubtractorFG.h"
+
+// value of the foreground pixels in the subtractor masks, shadows are lower
+#define FOREGROUND_MASK_VALUE       255
+
+namespace Tracker
+{
+    /********************************************************************
+    BackgroundSubtractorFGDetector
+        Registers the parameters shared by the subtractors
+    Exceptions:
+        None
+    *********************************************************************/
+    BackgroundSubtractorFGDetector::BackgroundSubtractorFGDetector( )
+        : m_history( 500 ),
+        m_detectShadows( 1 ),
+        m_learningRate( -1 ),
+        m_morphologySize( 3 ),
+        m_pSubtractor( ),
+        m_rawMask( ),
+        m_mask( ),
+        m_maskIpl( )
+    {
+        AddParam( "History", &m_history );
+        CommentParam( "History", "Number of frames the background model is learned from" );
+
+        AddParam( "DetectShadows", &m_detectShadows );
+        CommentParam( "DetectShadows", "1 leaves shadows out of the foreground mask" );
+
+        AddParam( "LearningRate", &m_learningRate );
+        CommentParam( "LearningRate", "Model update rate per frame, negative for 1/History" );
+
+        AddParam( "MorphSize", &m_morphologySize );
+        CommentParam( "MorphSize", "Kernel size of the opening removing speckles, 0 for none" );
+    }
+
+    /********************************************************************
+    Default Destructor for class BackgroundSubtractorFGDetector
+    *********************************************************************/
+    BackgroundSubtractorFGDetector::~BackgroundSubtractorFGDetector( )
+    {
+    }
+
+    /********************************************************************
+    ParamUpdate
+        Starts a new model with the current parameters
+    Exceptions:
+        None
+    *********************************************************************/
+    void BackgroundSubtractorFGDetector::ParamUpdate( )
+    {
+        m_pSubtractor = CreateSubtractor( );
+    }
+
+    /********************************************************************
+    Process
+        Updates the model with the frame and extracts the foreground mask
+    Exceptions:
+        None
+    *********************************************************************/
+    void BackgroundSubtractorFGDetector::Process( IplImage* pImg )
+    {
+        if ( m_pSubtractor.empty() )
+        {
+            m_pSubtractor = CreateSubtractor( );
+        }
+
+        const cv::Mat frame( pImg );
+        (*m_pSubtractor)( frame, m_rawMask, m_learningRate );
+
+        // shadows are marked below the foreground value
+        cv::threshold( m_rawMask, m_mask, FOREGROUND_MASK_VALUE - 1, FOREGROUND_MASK_VALUE, cv::THRESH_BINARY );
+
+        if ( m_morphologySize > 1 )
+        {
+            const cv::Mat kernel = cv::getStructuringElement( cv::MORPH_ELLIPSE, cv::Size( m_morphologySize, m_morphologySize ) );
+            cv::morphologyEx( m_mask, m_mask, cv::MORPH_OPEN, kernel );
+        }
+
+        m_maskIpl = m_mask;
+    }
+
+    /********************************************************************
+    GetMask
+        Mask of the last frame, NULL before the first one
+    Exceptions:
+        None
+    *********************************************************************/
+    IplImage* BackgroundSubtractorFGDetector::GetMask( )
+    {
+        return m_mask.empty() ? NULL : &m_maskIpl;
+    }
+
+    /********************************************************************
+    Release
+        Deletes the detector and its model
+    Exceptions:
+        None
+    *********************************************************************/
+    void BackgroundSubtractorFGDetector::Release( )
+    {
+        delete this;
+    }
+
+    /********************************************************************
+    MOG2FGDetector
+        Registers the parameters of the mixture model
+    Exceptions:
+        None
+    *********************************************************************/
+    MOG2FGDetector::MOG2FGDetector( )
+        : m_varThreshold( 16 )
+    {
+        SetModuleName( "MOG2" );
+
+        AddParam( "VarThreshold", &m_varThreshold );
+        CommentParam( "VarThreshold", "Squared Mahalanobis distance below which a pixel matches the background" );
+    }
+
+    /********************************************************************
+    CreateSubtractor
+        Creates the mixture model
+    Exceptions:
+        None
+    *********************************************************************/
+    cv::Ptr<cv::BackgroundSubtractor> MOG2FGDetector::CreateSubtractor( ) const
+    {
+        return cv::Ptr<cv::BackgroundSubtractor>( new cv::BackgroundSubtractorMOG2( m_history, (float)m_varThreshold, m_detectShadows != 0 ) );
+    }
+
+    /********************************************************************
+    CreateFGDetectorMOG2
+        Module constructor for the FG detector table
+    Exceptions:
+        None
+    *********************************************************************/
+    CvFGDetector* CreateFGDetectorMOG2( )
+    {
+        return new MOG2FGDetector( );
+    }
+}
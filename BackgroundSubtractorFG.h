@@ -0,0 +1,80 @@
+#ifndef BACKGROUND_SUBTRACTOR_FG_H
+#define BACKGROUND_SUBTRACTOR_FG_H
+
+#include "OpenCvDefinitions.h"
+#include "CommonMacros.h"
+
+#include "opencv2/video/background_segm.hpp"
+
+namespace Tracker
+{
+    /*
+    *   Foreground detector module running a cv::BackgroundSubtractor.
+    *   Shadows are left out of the mask and small speckles are removed
+    *   with a morphological opening, as the legacy detectors do. The
+    *   parameters are module parameters, so they are set through
+    *   FG_Detection_Params; the subtractor is created again when they
+    *   change.
+    */
+    class BackgroundSubtractorFGDetector : public CvFGDetector
+    {
+    public:
+    // CvFGDetector interface
+    virtual IplImage*   GetMask( );
+    virtual void        Process( IplImage* pImg );
+    virtual void        Release( );
+
+    // Create the subtractor with the current parameters
+    virtual void        ParamUpdate( );
+
+    protected:
+
+    // Constructor
+    BackgroundSubtractorFGDetector( );
+
+    // Destructor, use Release
+    virtual ~BackgroundSubtractorFGDetector( );
+
+    // Create the subtractor of the derived module
+    virtual cv::Ptr<cv::BackgroundSubtractor>   CreateSubtractor( ) const = 0;
+
+    int                                 m_history;          // frames the model is learned from
+    int                                 m_detectShadows;
+    double                              m_learningRate;     // negative for 1 / history
+    int                                 m_morphologySize;   // opening kernel size, 0 for none
+
+    private:
+
+    DISALLOW_EVIL_CONSTRUCTORS( BackgroundSubtractorFGDetector );
+
+    cv::Ptr<cv::BackgroundSubtractor>   m_pSubtractor;
+    cv::Mat                             m_rawMask;
+    cv::Mat                             m_mask;
+    IplImage                            m_maskIpl;
+    };
+
+    /*
+    *   Gaussian mixture background model with an adaptive number of
+    *   components per pixel. Zivkovic, ICPR 2004.
+    */
+    class MOG2FGDetector : public BackgroundSubtractorFGDetector
+    {
+    public:
+    // Constructor
+    MOG2FGDetector( );
+
+    protected:
+
+    virtual cv::Ptr<cv::BackgroundSubtractor>   CreateSubtractor( ) const;
+
+    private:
+
+    DISALLOW_EVIL_CONSTRUCTORS( MOG2FGDetector );
+
+    double                              m_varThreshold;     // squared Mahalanobis distance of a background pixel
+    };
+
+    // Module constructor for the FG detector table
+    CvFGDetector*   CreateFGDetectorMOG2( );
+}
+#endif
@@ -1,7 +1,29 @@
 #include "Camera.h"
 #include "OpenCvUtilities.h"
+#include "BackgroundSubtractorFG.h"
 
 #define DEFAULT_FG_TRAINING_FRAMES  5
+#define DEFAULT_MOTION_BLOCK_SIZE   16
+#define DEFAULT_MOTION_SEARCH_RANGE 8
+#define DEFAULT_LIVE_FRAME_RATE     25.0
+#define DEFAULT_LAG_THRESHOLD       0.2
+#define DEFAULT_MAX_COAST_FRAMES    4
+
+// load shedding levels of the real-time mode
+#define SHED_LEVEL_NONE             0
+#define SHED_LEVEL_EXTRAS           1       // no overlays, display, saved videos or crops
+#define SHED_LEVEL_COAST            2       // frames are dropped and the tracks coast
+
+// frames between memory checks
+#define MEMORY_CHECK_INTERVAL       25
+
+// degradation levels of the memory budget
+#define MEMORY_LEVEL_FULL           0
+#define MEMORY_LEVEL_NO_ANALYSIS    1       // trajectory analysis off
+#define MEMORY_LEVEL_HALF_SCALE     2       // frames processed at half size
+
+// overlap of a box of the checkpoint and a resumed track continuing it
+#define RESUME_MIN_OVERLAP          0.3
 
 // List of foreground detection algorithms
 CvFGDetector* cvCreateFGDetector0      ( ) { return cvCreateFGDetectorBase( CV_BG_MODEL_FGD,        NULL); }
@@ -14,6 +36,7 @@ DefModule_FGDetector FGDetector_Modules[] =
     { cvCreateFGDetector0,          "FG_0",     "Foreground Object Detection from Videos Containing Complex Background. ACM MM2003." },
     { cvCreateFGDetector0Simple,    "FG_0S",    "Simplified version of FG_0" },
     { cvCreateFGDetector1,          "FG_1",     "Adaptive background mixture models for real-time tracking. CVPR1999" },
+    { Tracker::CreateFGDetectorMOG2,"FG_MOG2",  "Improved adaptive Gaussian mixture model for background subtraction. ICPR2004" },
     { NULL,                         NULL,       NULL}
 };
 
@@ -80,10 +103,16 @@ namespace Tracker
         : m_cameraId( 0 ),
         m_videoSourceDirectory( sourceDirectory ),
         m_videoFileName( videoFileName ),
-        m_videoCap( ),
+        m_outputName( GetSourceOutputName( videoFileName ) ),
+        m_rawFrameFormat( ),
+        m_decoderSettings( ),
+        m_pFrameSource( ),
+        m_frameCache( false ),
+        m_frameCacheDownScale( false ),
+        m_sourceScale( 1.0 ),
         m_videoOutputDirectory( ),
         m_saveIntermediateResult( "" ),
-        m_pOutputRecordFileStream( NULL ),
+        m_pRecordWriter( NULL ),
         m_pFGAvi( ),
         m_pBTAvi( ),
         m_displayIntermediateResult( false ),
@@ -92,6 +121,11 @@ namespace Tracker
         m_blobTrackerModName( "" ),
         m_blobAnalyzerModName( "" ),
         m_blobPostProcModName( "" ),
+        m_fgDetectionParams( ),
+        m_blobDetectionParams( ),
+        m_blobTrackerParams( ),
+        m_blobAnalysisParams( ),
+        m_blobPostProcessingParams( ),
         m_downScaleImage ( false ),
         m_fgTrainFrames( DEFAULT_FG_TRAINING_FRAMES ),
         m_initializied( false ),
@@ -99,90 +133,192 @@ namespace Tracker
         m_height( 0 ),
         m_originalFrameMat( ),
         m_frame( ),
-        m_frameIpl( ),
-        m_pFGMaskIpl( ),
+        m_overlayFrame( ),
+        m_fgMask( ),
+        m_trackingEngine( "Native" ),
         m_pTracker( NULL ),
         m_pFGDetector( NULL ),
         m_pBlobDetector( NULL ),
         m_pBlobTracker( NULL ),
         m_pBlobTrackAnalysis( NULL ),
         m_pBlobProcessing( NULL ),
-        m_pTrackerParams( new CvBlobTrackerAutoParam1( ) )
+        m_motionVectorAssist( false ),
+        m_motionBlockSize( DEFAULT_MOTION_BLOCK_SIZE ),
+        m_motionSearchRange( DEFAULT_MOTION_SEARCH_RANGE ),
+        m_pMotionField( NULL ),
+        m_activityGating( false ),
+        m_activityGateSettings( ),
+        m_pActivityGate( NULL ),
+        m_cropExport( false ),
+        m_cropExportSettings( ),
+        m_pCropExporter( NULL ),
+        m_realTimeMode( false ),
+        m_lagThreshold( DEFAULT_LAG_THRESHOLD ),
+        m_maxCoastFrames( DEFAULT_MAX_COAST_FRAMES ),
+        m_liveFrameRate( DEFAULT_LIVE_FRAME_RATE ),
+        m_frameTimestamp( 0 ),
+        m_coastedFrames( 0 ),
+        m_blobMotion( ),
+        m_stats( ),
+        m_pMetrics( ),
+        m_decodeTicks( 0 ),
+        m_memoryBudget( 0 ),
+        m_overBudgetLogged( false ),
+        m_blobFrames( 0 ),
+        m_blobIdOffset( 0 ),
+        m_maxBlobId( -1 ),
+        m_startFrameIndex( 0 ),
+        m_endFrameIndex( -1 ),
+        m_frameNum( 0 ),
+        m_clockStartTicks( 0 ),
+        m_clockStartTimestamp( 0 ),
+        m_clockStarted( false ),
+        m_framePending( false ),
+        m_pendingTimestamp( 0 ),
+        m_frameDueTicks( 0 ),
+        m_checkpointInterval( 0 ),
+        m_resume( false ),
+        m_resumeWarmupFrames( 0 ),
+        m_resumeFrame( -1 ),
+        m_lastCheckpointFrame( 0 ),
+        m_framesEnded( false ),
+        m_resumeTracks( ),
+        m_resumedIds( ),
+        m_scheduleWeight( 1 ),
+        m_maxFrameRate( 0 ),
+        m_coreSet( )
     {
     }
 
     /********************************************************************
-    Default Destructor for class Camera
+    ApplySettings
+        Apply the output and pipeline settings of a configuration
+    Exceptions:
+        None
     *********************************************************************/
-    Camera::~Camera()
+    void Camera::ApplySettings( const InputParameters& settings )
     {
-        try
+        SetVideoOutputDirectory( settings.m_outputVideoDirectory );
+
+        RawFrameFormat rawFrameFormat;
+        rawFrameFormat.m_width  = settings.m_rawFrameWidth;
+        rawFrameFormat.m_height = settings.m_rawFrameHeight;
+        if ( settings.m_rawFrameFormat[0] != '\0' )
         {
-            LOG( "Destroying Camera " );
-            m_videoCap.release();
+            rawFrameFormat.m_format = settings.m_rawFrameFormat;
+        }
+        SetRawFrameFormat( rawFrameFormat );
+
+        m_displayIntermediateResult = settings.m_displayIntermediateResult == 1;
+        m_saveIntermediateResult    = settings.m_saveIntermediateResult == 1;
+        m_downScaleImage            = settings.m_downScaleImage == 1;
+        m_frameCache                = settings.m_frameCache == 1;
+        m_frameCacheDownScale       = settings.m_frameCacheDownScale == 1;
+        m_motionVectorAssist        = settings.m_motionVectorAssist == 1;
+        m_activityGating            = settings.m_activityGate == 1;
+
+        m_decoderSettings.m_ffmpeg      = MY_STRICMP( settings.m_videoDecoder, "FFmpeg" ) == 0;
+        m_decoderSettings.m_threads     = settings.m_decoderThreads;
+        m_decoderSettings.m_threadType  = settings.m_decoderThreadType;
+        m_decoderSettings.m_downScale   = settings.m_decoderDownScale == 1 && m_downScaleImage;
+
+        m_activityGateSettings.m_pixelThreshold     = settings.m_activityGateThreshold;
+        m_activityGateSettings.m_minChangedPercent  = settings.m_activityGateMinChanged;
+        m_activityGateSettings.m_refreshInterval    = settings.m_activityGateRefreshFrames;
+
+        SetMotionBlockSize( settings.m_motionBlockSize );
+        SetMotionSearchRange( settings.m_motionSearchRange );
+        SetFGTrainFrame( settings.m_numberFGTrainFrames );
+        if ( settings.m_trackingEngine[0] != '\0' )
+        {
+            m_trackingEngine = settings.m_trackingEngine;
+        }
+        SetFgDetectionModule( settings.m_fgDetectorMod );
+        SetBlobDetectionModule( settings.m_blobDetectorMod );
+        SetBlobTrackerModule( settings.m_blobTrackerMod );
+        SetBlobAnalysisModule( settings.m_blobAnalysisMod );
+        SetBlobProcessingModule( settings.m_blobProcessingMod );
+
+        m_fgDetectionParams         = settings.m_fgDetectionParams;
+        m_blobDetectionParams       = settings.m_blobDetectionParams;
+        m_blobTrackerParams         = settings.m_blobTrackerParams;
+        m_blobAnalysisParams        = settings.m_blobAnalysisParams;
+        m_blobPostProcessingParams  = settings.m_blobPostProcessingParams;
+
+        m_cropExport                                = settings.m_cropExport == 1;
+        if ( settings.m_cropFormat[0] != '\0' )
+        {
+            m_cropExportSettings.m_format           = settings.m_cropFormat;
+        }
+        m_cropExportSettings.m_sampleInterval       = settings.m_cropSampleInterval;
+        m_cropExportSettings.m_maxCropsPerFrame     = settings.m_cropMaxPerFrame;
+        m_cropExportSettings.m_bufferCount          = settings.m_cropBufferCount;
+        m_cropExportSettings.m_workerThreads        = settings.m_cropWorkerThreads;
+        m_cropExportSettings.m_archiveSize          = settings.m_cropArchiveSize;
 
-            LOG( "Closing output file" );
-            if ( m_pOutputRecordFileStream != NULL )
-            {
-                m_pOutputRecordFileStream->close();
-                delete m_pOutputRecordFileStream;
-            }
+        m_realTimeMode      = settings.m_realTimeMode == 1;
+        m_lagThreshold      = settings.m_realTimeLagThreshold / 1000.0;
+        m_maxCoastFrames    = settings.m_realTimeMaxCoastFrames;
+        m_liveFrameRate     = settings.m_liveFrameRate;
 
-            LOG( "Destroying output windows" );
-            if ( m_displayIntermediateResult )
-            {
-                cv::destroyWindow( m_videoFileName + "_FGMask" );
-                cv::destroyWindow( m_videoFileName + "_Tracking" );
-            }
+        m_memoryBudget      = (size_t)settings.m_memoryBudgetMB * 1024 * 1024;
 
-            LOG( "Releasing foreground mask..." );
-            if ( m_pFGMaskIpl != NULL )
-            {
-                cvReleaseImage( &m_pFGMaskIpl );
-            }
+        m_scheduleWeight    = settings.m_scheduleWeight;
+        m_maxFrameRate      = settings.m_maxFrameRate;
 
-            LOG( "Releasing Auto tracker..." );
-            if ( m_pTracker != NULL )
-            {
-               cvReleaseBlobTrackerAuto( &m_pTracker );
-            }
+        m_checkpointInterval    = settings.m_checkpointInterval;
+        m_resume                = settings.m_resume == 1;
+        m_resumeWarmupFrames    = settings.m_resumeWarmupFrames;
 
-            LOG( "Releasing foreground detector..." );
-            if ( m_pFGDetector != NULL )
-            {
-                cvReleaseFGDetector( &m_pFGDetector );
-            }
+        if ( !ParseCoreSet( settings.m_coreSet, m_coreSet ) )
+        {
+            LOG_FILE( "Invalid Core_Set " << settings.m_coreSet );
+            AbortError( __LINE__, __FILE__, "Invalid Core_Set" );
+        }
+    }
 
-            LOG( "Releasing blob tracker..." );
-            if ( m_pBlobTracker != NULL )
+    /********************************************************************
+    Default Destructor for class Camera
+    *********************************************************************/
+    Camera::~Camera()
+    {
+        LogCameraScope logCamera( m_cameraId );
+
+        try
+        {
+            LOG( "Destroying Camera " );
+            if ( m_pFrameSource )
             {
-                cvReleaseBlobTracker( &m_pBlobTracker );
+                m_pFrameSource->Release();
             }
 
-            LOG( "Releasing blob track analyzer..." );
-            if ( m_pBlobTrackAnalysis != NULL )
+            LOG( "Closing crop exporter" );
+            if ( m_pCropExporter != NULL )
             {
-                cvReleaseBlobTrackAnalysis( &m_pBlobTrackAnalysis );
+                delete m_pCropExporter;
             }
 
-            LOG( "Releasing blob processor..." );
-            if ( m_pBlobProcessing != NULL )
+            if ( m_pActivityGate != NULL )
             {
-                m_pBlobProcessing->Release( );
+                delete m_pActivityGate;
             }
-        
-            LOG( "Releasing blob detector..." );
-            if ( m_pBlobDetector != NULL )
+
+            LOG( "Closing output file" );
+            if ( m_pRecordWriter != NULL )
             {
-                cvReleaseBlobDetector( &m_pBlobDetector );
+                m_pRecordWriter->Close();
+                delete m_pRecordWriter;
             }
 
-            LOG( "Deleting tracking params" );
-            if ( m_pTrackerParams != NULL )
+            LOG( "Destroying output windows" );
+            if ( m_displayIntermediateResult )
             {
-                delete m_pTrackerParams;
+                cv::destroyWindow( m_outputName + "_FGMask" );
+                cv::destroyWindow( m_outputName + "_Tracking" );
             }
 
+            ReleasePipeline( );
+
             LOG( "Successfully Destroyed Camera " );
         }
         EXCEPTION_CATCH_AND_LOG( "Failed to destroy the camera object" );
@@ -204,14 +340,14 @@ namespace Tracker
             }
 
             //initialize the foreground avi
-            m_pFGAvi = VideoWritePtr( new cv::VideoWriter( m_videoOutputDirectory +  "/" +  m_videoFileName + "_FG.avi", ///filename
+            m_pFGAvi = VideoWritePtr( new cv::VideoWriter( GetOutputBaseName() + "_FG.avi", ///filename
                                             CV_FOURCC('x','v','i','d'), //video file format
                                             15,                         //frame rate
                                             m_frame.size(),             //number of frame
                                             1 ) );
 
             //initialize the blob tracker avi
-            m_pBTAvi = VideoWritePtr( new cv::VideoWriter( m_videoOutputDirectory + "/" + m_videoFileName + "_BT.avi",
+            m_pBTAvi = VideoWritePtr( new cv::VideoWriter( GetOutputBaseName() + "_BT.avi",
                                             CV_FOURCC('x','v','i','d'),
                                             15, 
                                             m_frame.size(), 
@@ -238,11 +374,11 @@ namespace Tracker
             if ( m_displayIntermediateResult )
             {
                 //create windows for detector outputs
-                cv::namedWindow( m_videoFileName + "_FGMask", 1 );
-                cv::namedWindow( m_videoFileName + "_Tracking", 1 );
+                cv::namedWindow( m_outputName + "_FGMask", 1 );
+                cv::namedWindow( m_outputName + "_Tracking", 1 );
 
-                cvMoveWindow( (m_videoFileName+"_FGMask").c_str(), 700, 10 );
-                cvMoveWindow( (m_videoFileName+"_Tracking").c_str(), 700, 400 );
+                cvMoveWindow( (m_outputName+"_FGMask").c_str(), 700, 10 );
+                cvMoveWindow( (m_outputName+"_Tracking").c_str(), 700, 400 );
             }
         }
         EXCEPTION_CATCH_AND_ABORT( "Failed to initialize display windows" );
@@ -250,7 +386,7 @@ namespace Tracker
 
     /*************************************************************************
     Initialize
-        Initialize Camera
+        Initialize Camera with the given module parameters
     Exceptions
         None
     *************************************************************************/
@@ -260,25 +396,179 @@ namespace Tracker
                              std::string blobAnalysisParams,
                              std::string blobPostProcessingParams )
     {
+        m_fgDetectionParams         = fgDetectionParams;
+        m_blobDetectionParams       = blobDetectionParams;
+        m_blobTrackerParams         = blobTrackerParams;
+        m_blobAnalysisParams        = blobAnalysisParams;
+        m_blobPostProcessingParams  = blobPostProcessingParams;
+
+        Initialize( );
+    }
+
+    /*************************************************************************
+    Initialize
+        Open the video and read its first frame, with the module parameters
+        of the applied settings. The decoder threads are created on the
+        cores of the camera, so that they are local to them. The modules
+        and output videos are only created on the first processed frame,
+        so that opening many cameras stays cheap and can run in parallel.
+    Exceptions
+        None
+    *************************************************************************/
+    void Camera::Initialize( )
+    {
+        LogCameraScope      logCamera( m_cameraId );
+        ThreadAffinityScope affinity( m_coreSet );
+
         LOG_FILE( "Initialize video " + m_videoSourceDirectory + '/' + m_videoFileName );
-        LOG_FILE( "\t from camera: " + m_cameraId );
+        LOG_FILE( "\t from camera: " << m_cameraId );
 
-        // open input video
-        m_videoCap.open( m_videoSourceDirectory + '/' + m_videoFileName );
-        if ( !m_videoCap.isOpened()) 
+        // open input video or stream
+        if ( m_frameCache && !IsStreamSource( m_videoFileName ) )
+        {
+            m_pFrameSource = CreateCachedFrameSource( m_videoSourceDirectory + '/' + m_videoFileName,
+                                                      m_videoOutputDirectory + '/' + m_outputName + ".framecache",
+                                                      m_frameCacheDownScale && m_downScaleImage,
+                                                      m_decoderSettings );
+        }
+        else
+        {
+            m_pFrameSource = CreateFrameSource( m_videoSourceDirectory, m_videoFileName, m_rawFrameFormat, m_decoderSettings );
+        }
+        if ( !m_pFrameSource->IsOpened()) 
         {
             LOG_FILE( "Unable to open input video file " + m_videoSourceDirectory + '/' + m_videoFileName );
             AbortError( __LINE__, __FILE__, "Unable to open input video file" );
         }
 
-        // open record file 
-        m_pOutputRecordFileStream = new std::ofstream( (m_videoOutputDirectory+"/"+m_videoFileName+"_record.txt").c_str(), std::ios_base::out );
-        if ( !m_pOutputRecordFileStream->is_open( ) )
+        // read first frame and discard it 
+        if ( !m_pFrameSource->Grab() || !m_pFrameSource->Retrieve( m_originalFrameMat ) )
+        {
+            AbortError( __LINE__, __FILE__, "Unable to read the first frame" );
+        }
+        m_sourceScale = m_pFrameSource->GetScale();
+
+        InitializeModules( );
+    }
+
+    /*************************************************************************
+    Initialize
+        Initialize Camera on frames decoded by the caller. The frames are
+        only read, so one decoded frame can be shared by several cameras.
+    Exceptions
+        None
+    *************************************************************************/
+    void Camera::Initialize( const cv::Mat&  firstFrame,
+                             const double    sourceScale,
+                             std::string     fgDetectionParams,
+                             std::string     blobDetectionParams,
+                             std::string     blobTrackerParams,
+                             std::string     blobAnalysisParams,
+                             std::string     blobPostProcessingParams )
+    {
+        LogCameraScope      logCamera( m_cameraId );
+        ThreadAffinityScope affinity( m_coreSet );
+
+        LOG_FILE( "Initialize " + m_outputName + " on shared frames of " + m_videoFileName );
+
+        m_originalFrameMat  = firstFrame;
+        m_sourceScale       = sourceScale;
+
+        m_fgDetectionParams         = fgDetectionParams;
+        m_blobDetectionParams       = blobDetectionParams;
+        m_blobTrackerParams         = blobTrackerParams;
+        m_blobAnalysisParams        = blobAnalysisParams;
+        m_blobPostProcessingParams  = blobPostProcessingParams;
+
+        InitializeModules( );
+    }
+
+    /*************************************************************************
+    InitializeModules
+        Open the record file and register the metrics; the processing
+        modules are created by CreateModules on the first frame
+    Exceptions
+        None
+    *************************************************************************/
+    void Camera::InitializeModules( )
+    {
+        const std::string recordFileName = GetRecordFileName( );
+
+        // continue the record file of an interrupted run after its checkpoint
+        CameraCheckpoint checkpoint;
+        if ( m_resume && ReadCheckpoint( GetCheckpointName( recordFileName ), checkpoint ) )
+        {
+            m_pRecordWriter = new RecordWriter( recordFileName, checkpoint.m_recordOffset );
+
+            m_resumeFrame           = checkpoint.m_frameNumber;
+            m_lastCheckpointFrame   = checkpoint.m_frameNumber;
+            m_framesEnded           = checkpoint.m_complete;
+            m_resumeTracks          = checkpoint.m_tracks;
+            m_maxBlobId             = checkpoint.m_maxBlobId;
+            m_blobIdOffset          = m_maxBlobId + 1;
+
+            LOG( ( m_framesEnded ? "Completed " : "Resuming " ) << m_outputName << " at frame " << m_resumeFrame <<
+                 " with " << m_resumeTracks.size() << " tracks" );
+        }
+        else
+        {
+            m_pRecordWriter = new RecordWriter( recordFileName );
+        }
+
+        // open record file and its index
+        if ( !m_pRecordWriter->IsOpened( ) )
         {
-            LOG_FILE( "Unable to open record file " + m_videoOutputDirectory + '/' + m_videoFileName+"_record.txt" );
+            LOG_FILE( "Unable to open record file " + recordFileName );
             AbortError( __LINE__, __FILE__, "Unable to open record file" );
         }
 
+        m_pMetrics = Metrics::Instance().AddCamera( m_cameraId, m_outputName );
+
+        // Set the flag
+        m_initializied = true;
+    }
+
+    /*************************************************************************
+    CreateModules
+        Create the pipeline, the output videos and the crop encoders for
+        the current frame. Called on the first frame, on the thread and
+        cores that process the camera.
+    Exceptions
+        None
+    *************************************************************************/
+    void Camera::CreateModules( )
+    {
+        const int64 startTicks = cv::getTickCount();
+
+        CreatePipeline( );
+
+        //Initialize Output videos
+        InitializeOutputVideos( );
+
+        if ( m_activityGating )
+        {
+            m_pActivityGate = new ActivityGate( m_activityGateSettings );
+        }
+
+        // start the crop encoders
+        if ( m_cropExport )
+        {
+            m_pCropExporter = new CropExporter( GetOutputBaseName(), m_cropExportSettings );
+        }
+
+        LOG_FILE( "Created the modules in " << ( cv::getTickCount() - startTicks ) / cv::getTickFrequency() << " s" );
+        ReportPlacement( );
+    }
+
+    /*************************************************************************
+    CreatePipeline
+        Create the detection, tracking and analysis modules and the auto
+        tracker running them, sized on the current frame
+    Exceptions
+        None
+    *************************************************************************/
+    void Camera::CreatePipeline( )
+    {
         // a temporary blob params variable
         char tempCharString[STRING_SIZE];
 
@@ -293,9 +583,15 @@ namespace Tracker
         }
         ASSERT_TRUE( pFGModule != NULL );
         m_pFGDetector = (*(pFGModule->create))( );
-        strcpy( tempCharString, fgDetectionParams.c_str() ); 
+        strcpy( tempCharString, m_fgDetectionParams.c_str() ); 
         OpenCvWrapper::Utils::SetParameters( tempCharString, m_pFGDetector, "fg", m_fgDetectorModName.c_str( ) );
 
+        // seed the tracked blobs with the macroblock motion
+        if ( m_motionVectorAssist )
+        {
+            m_pMotionField = new MotionField( m_motionBlockSize, m_motionSearchRange );
+        }
+
         // Initialize blob detection module
         DefModule_BlobDetector*         pBDModule;
         for( pBDModule = BlobDetector_Modules; pBDModule->nickname; ++pBDModule )
@@ -307,7 +603,7 @@ namespace Tracker
         }
         ASSERT_TRUE( pBDModule != NULL );
         m_pBlobDetector = (*(pBDModule->create))( );
-        strcpy( tempCharString, blobDetectionParams.c_str() ); 
+        strcpy( tempCharString, m_blobDetectionParams.c_str() ); 
         OpenCvWrapper::Utils::SetParameters(tempCharString, m_pBlobDetector, "bd", m_blobDetectorModName.c_str());
 
         // Initialize blob tracker module
@@ -321,7 +617,7 @@ namespace Tracker
         }
         ASSERT_TRUE(pBTModule!=NULL);
         m_pBlobTracker = (*(pBTModule->create))(); 
-        strcpy( tempCharString, blobTrackerParams.c_str() ); 
+        strcpy( tempCharString, m_blobTrackerParams.c_str() ); 
         OpenCvWrapper::Utils::SetParameters(tempCharString, m_pBlobTracker, "bt", m_blobTrackerModName.c_str());
 
         // Initialize Blob Analysis Module
@@ -338,7 +634,7 @@ namespace Tracker
         {
             m_pBlobTrackAnalysis = (*(pBAnalysisModule->create))();
 
-            strcpy( tempCharString, blobAnalysisParams.c_str() ); 
+            strcpy( tempCharString, m_blobAnalysisParams.c_str() ); 
             OpenCvWrapper::Utils::SetParameters( tempCharString, 
                                                  m_pBlobTrackAnalysis,
                                                  "bta",
@@ -360,19 +656,15 @@ namespace Tracker
         {
             m_pBlobProcessing = (*(pBlobPostProcModule->create))();
 
-            strcpy( tempCharString, blobAnalysisParams.c_str() ); 
+            strcpy( tempCharString, m_blobAnalysisParams.c_str() ); 
             OpenCvWrapper::Utils::SetParameters( tempCharString, 
                                                 m_pBlobProcessing,
                                                 "btpp",
                                                 m_blobPostProcModName.c_str() );
         }
 
-
-        // read first frame and discard it 
-        m_videoCap >> m_originalFrameMat;
-
-        // resize the image if downscale option is chosen
-        if ( m_downScaleImage )
+        // resize the image if downscale option is chosen and the source has not done it
+        if ( m_downScaleImage && m_sourceScale == 1.0 )
         {
             cv::resize( m_originalFrameMat, m_frame, cv::Size(0,0),0.5,0.5);
         }
@@ -385,37 +677,79 @@ namespace Tracker
         m_width         = m_frame.size().width;
         m_height        = m_frame.size().height;
 
-        //Initialize Output videos
-        InitializeOutputVideos( );
+        // Create the engine running the modules
+        TrackingModules modules;
+        modules.m_fgTrainFrames         = m_fgTrainFrames;
+        modules.m_pBlobDetector         = m_pBlobDetector;
+        modules.m_pBlobTracker          = m_pBlobTracker;
+        modules.m_pBlobTrackAnalysis    = m_pBlobTrackAnalysis;
+        modules.m_pBlobProcessing       = m_pBlobProcessing;
+        modules.m_pFGDetector           = m_pFGDetector;
+        modules.m_fgDetectorName        = m_fgDetectorModName;
+        modules.m_blobDetectorName      = m_blobDetectorModName;
+        modules.m_blobTrackerName       = m_blobTrackerModName;
+        modules.m_blobProcessingName    = m_blobPostProcModName;
+        modules.m_blobTrackAnalysisName = m_blobAnalyzerModName;
+
+        m_pTracker = CreateTrackingEngine( m_trackingEngine, modules );
 
-        // display results
-        if ( m_displayIntermediateResult )
+        ASSERT_TRUE( m_pTracker != NULL );
+
+        m_blobFrames = 0;
+    }
+
+    /*************************************************************************
+    ReleasePipeline
+        Release the auto tracker and its modules
+    Exceptions
+        None
+    *************************************************************************/
+    void Camera::ReleasePipeline( )
+    {
+        LOG( "Releasing tracking engine..." );
+        if ( m_pTracker != NULL )
         {
-            cv::imshow( m_videoFileName + "_Tracking", m_frame );
+            delete m_pTracker;
+            m_pTracker = NULL;
         }
 
-        if ( m_saveIntermediateResult )
+        LOG( "Releasing foreground detector..." );
+        if ( m_pFGDetector != NULL )
         {
-            *m_pFGAvi << cv::Mat::zeros(m_width,m_height,CV_8UC3);
-            *m_pBTAvi << m_frame;
+            cvReleaseFGDetector( &m_pFGDetector );
         }
 
-        // Set the OpenCv Auto Tracker Params
-        ASSERT_TRUE( m_pTrackerParams != NULL );
-        m_pTrackerParams->FGTrainFrames = m_fgTrainFrames;
-        m_pTrackerParams->pBD           = m_pBlobDetector;
-        m_pTrackerParams->pBT           = m_pBlobTracker;
-        m_pTrackerParams->pBTA          = m_pBlobTrackAnalysis;
-        m_pTrackerParams->pBTPP         = m_pBlobProcessing;
-        m_pTrackerParams->pFG           = m_pFGDetector;
-        m_pTrackerParams->UsePPData     = false;
+        LOG( "Releasing blob tracker..." );
+        if ( m_pBlobTracker != NULL )
+        {
+            cvReleaseBlobTracker( &m_pBlobTracker );
+        }
 
-        m_pTracker = cvCreateBlobTrackerAuto1( m_pTrackerParams );
+        LOG( "Releasing blob track analyzer..." );
+        if ( m_pBlobTrackAnalysis != NULL )
+        {
+            cvReleaseBlobTrackAnalysis( &m_pBlobTrackAnalysis );
+        }
 
-        ASSERT_TRUE( m_pTracker != NULL );
+        LOG( "Releasing blob processor..." );
+        if ( m_pBlobProcessing != NULL )
+        {
+            m_pBlobProcessing->Release( );
+            m_pBlobProcessing = NULL;
+        }
+    
+        LOG( "Releasing blob detector..." );
+        if ( m_pBlobDetector != NULL )
+        {
+            cvReleaseBlobDetector( &m_pBlobDetector );
+        }
 
-        // Set the flag
-        m_initializied = true;
+        LOG( "Deleting motion field" );
+        if ( m_pMotionField != NULL )
+        {
+            delete m_pMotionField;
+            m_pMotionField = NULL;
+        }
     }
 
     /*************************************************************************
@@ -427,226 +761,990 @@ namespace Tracker
             4) Blob Post Processing
             5) Blob Analysis
             6) Store the results
+        In the real-time mode each frame is due at its capture time and
+        work is shed as the processing falls behind.
     Exceptions
         None
     *************************************************************************/
     void Camera::Process(const int startFrameIndex, const int endFrameIndex)
     {
-        ASSERT_TRUE ( m_initializied );
-        ASSERT_TRUE ( m_pTracker != NULL );
-
-        InitializeDisplayWindows( );
+        ThreadAffinityScope affinity( m_coreSet );
 
-        LOG_CONSOLE( "Start processing " + m_videoFileName );
+        BeginProcessing( startFrameIndex, endFrameIndex );
 
-        int key, oneFrameProcess=0, frameNum; 
-        for ( frameNum = 1; 
-             m_videoCap.grab() &&
-            ( key = cvWaitKey( oneFrameProcess ? 0 : 1 ) ) != 27 &&
-            ( frameNum <=  endFrameIndex || endFrameIndex < 0 );
-            frameNum++ )
+        int key, oneFrameProcess=0;
+        while ( ( key = cvWaitKey( oneFrameProcess ? 0 : 1 ) ) != 27 &&
+                ProcessNextFrame( ) )
         {
-            if ( frameNum >= startFrameIndex )
-            {
-                std::cout << "frameNum:  " << frameNum << '\r';
+            WaitForFrameDue( );
 
-                // get the video frame
-                m_videoCap.retrieve( m_originalFrameMat );
+            std::cout << "frameNum:  " << m_frameNum << '\r';
 
-                // downscale the image if required
-                if ( m_downScaleImage )
-                {
-                    cv::resize( m_originalFrameMat, m_frame,  m_frame.size() );
-                }
-                else
-                {
-                    m_frame = m_originalFrameMat;
-                }
+            if ( key != -1 )
+            {
+                oneFrameProcess = ( key == 'r' ) ? 0 : 1;
+            }
+        }
 
-                m_frameIpl = m_frame; 
+        EndProcessing( );
+    }
 
-                if ( key != -1 )
-                {
-                    oneFrameProcess = ( key == 'r' ) ? 0 : 1;
-                }
+    /*************************************************************************
+    BeginProcessing
+        Prepare to process the frames from startFrameIndex to endFrameIndex
+        with ProcessNextFrame, a negative endFrameIndex runs to the end
+    Exceptions
+        None
+    *************************************************************************/
+    void Camera::BeginProcessing( const int startFrameIndex, const int endFrameIndex )
+    {
+        ASSERT_TRUE ( m_initializied );
 
-                // Process the current frame
-                m_pTracker->Process( &m_frameIpl, m_pFGMaskIpl);
-                m_fgMask        = m_pTracker->GetFGMask();
+        LogCameraScope logCamera( m_cameraId );
 
+        InitializeDisplayWindows( );
 
-                // Process the current video frame using the blob tracker
-                IplImage fgMaskIpl = m_fgMask;
+        LOG_CONSOLE( "Start processing " + m_videoFileName );
 
+        m_startFrameIndex   = startFrameIndex;
+        m_endFrameIndex     = endFrameIndex;
+        m_frameNum          = 0;
+        m_clockStarted      = false;
+        m_framePending      = false;
 
-                // Save Blob Information in a file
-                for( int i = m_pTracker->GetBlobNum(); i> 0; i-- )
-                {
-                    CvBlob* pBlob = m_pTracker->GetBlob(i-1);
+        // a resumed camera trains its models again on the frames before the checkpoint
+        if ( m_resumeFrame >= 0 && !m_framesEnded )
+        {
+            m_startFrameIndex = std::max( m_startFrameIndex, m_resumeFrame - m_resumeWarmupFrames + 1 );
+            if ( m_startFrameIndex > 1 && m_pFrameSource->Seek( m_startFrameIndex ) )
+            {
+                m_frameNum = m_startFrameIndex - 1;
+            }
+        }
+    }
 
-                    ASSERT_TRUE( pBlob != NULL );
+    /*************************************************************************
+    ProcessNextFrame
+        Grab and process the next frame, false at the end of the video
+    Exceptions
+        None
+    *************************************************************************/
+    bool Camera::ProcessNextFrame( )
+    {
+        LogCameraScope logCamera( m_cameraId );
 
-                    // Save blob record
-                    SaveBlobRecord( pBlob, frameNum );
-                }
+        if ( m_framesEnded )
+        {
+            return false;
+        }
 
-                if ( m_displayIntermediateResult || m_saveIntermediateResult )
-                {
-                    char tempString[128];
-                    std::string textMessage;
-                    //display intermediate result if necessary
-                    CvFont    font; 
-                    CvSize  TextSize;
-                    cvInitFont( &font, CV_FONT_HERSHEY_PLAIN, 0.7, 0.7, 0, 1, CV_AA );
-
-                    sprintf(tempString,"frame # %d", frameNum);
-                    textMessage = tempString;
-                    cv::putText( m_originalFrameMat, textMessage, cv::Point(10,20), CV_FONT_HERSHEY_PLAIN, 1, cv::Scalar((0,255,255)));
-                    cv::putText( m_fgMask,textMessage, cv::Point(10,20), CV_FONT_HERSHEY_PLAIN, 1, cv::Scalar((0,255,255)));
-                    cv::putText( m_frame, textMessage, cv::Point(10,20), CV_FONT_HERSHEY_PLAIN, 1, cv::Scalar((0,255,255)));
-
-                    //drawing blobs if any with green ellipse with m_cvBlob id displayed next to it.
-                    int c = 0; // 0: g; 255: red
-                    for ( int i = m_pTracker->GetBlobNum(); i > 0; i-- )
-                    {
-                        CvBlob* pBlob = m_pTracker->GetBlob(i-1);
-
-                        ASSERT_TRUE( pBlob != NULL );
-
-                        cv::Point blobCorner( cvRound( pBlob->x * 256 ), cvRound( pBlob->y * 256 ) );
-
-                        CvSize  blobSize = cvSize( MAX( 1, cvRound( CV_BLOB_RX(pBlob) * 256 ) ), 
-                                                   MAX( 1, cvRound( CV_BLOB_RY(pBlob) * 256 ) ) );
-
-                        cv::Scalar boundingBoxColor( c, 255-c, 0 );
-
-                        if ( m_pTracker->GetState( CV_BLOB_ID( pBlob ) ) != 0 )
-                        {
-                            boundingBoxColor = cv::Scalar( 255-c, c, 0 );
-                        }
-
-                        cv::ellipse( m_frame, 
-                                    cv::RotatedRect( cv::Point2f( pBlob->x, pBlob->y ), cv::Size2f( pBlob->w, pBlob->h ), 0 ),
-                                    cv::Scalar( c, 255-c, 0 ) );
-                        blobCorner.x >>= 8;      
-                        blobCorner.y >>= 8;
-                        
-                        blobSize.width >>= 8;
-                        blobSize.height >>= 8;
-                        blobCorner.y -= blobSize.height;
-
-                        sprintf( tempString, "BlobId=%03d", CV_BLOB_ID(pBlob) );
-                        cvGetTextSize( tempString, &font, &TextSize, NULL );
-                        
-                        cv::putText( m_frame,
-                                     std::string( tempString ),
-                                     blobCorner,
-                                     CV_FONT_HERSHEY_PLAIN,
-                                     1,
-                                     cv::Scalar( 255, 255, 0, 0 ) );
-                    }
-                }
+        // a frame handed back early is processed now, without grabbing another
+        const bool frameWasPending = m_framePending;
+        m_framePending = false;
 
-                if ( m_displayIntermediateResult )
-                {
-                    cv::imshow(m_videoFileName+"_FGMask", m_fgMask);
-                    cv::imshow(m_videoFileName+"_Tracking", m_frame);
-                }
+        double timestamp = m_pendingTimestamp;
+        if ( !frameWasPending )
+        {
+            const int64 grabStartTicks = cv::getTickCount();
 
-                if ( m_saveIntermediateResult )
+            // skip to the start frame
+            do
+            {
+                if ( ( m_endFrameIndex >= 0 && m_frameNum >= m_endFrameIndex ) ||
+                     !m_pFrameSource->Grab() )
                 {
-                    cv::Mat tmpFrame;
-                    cv::cvtColor( m_fgMask, tmpFrame, CV_GRAY2BGR );
-                    *m_pFGAvi << tmpFrame;             
-                    *m_pBTAvi << m_frame;
+                    m_framesEnded = true;
+                    return false;
                 }
+                m_frameNum++;
             }
-        }
+            while ( m_frameNum < m_startFrameIndex );
 
-        g_logFile << "End of  processing " << m_videoFileName << std::endl;
-        std::cout << "End of processing " << m_videoFileName << std::endl;
-    }
+            m_decodeTicks = cv::getTickCount() - grabStartTicks;
 
+            timestamp = m_pFrameSource->GetTimestamp();
+            if ( timestamp < 0 )
+            {
+                timestamp = ( m_frameNum - 1 ) / m_liveFrameRate;
+            }
+        }
 
-    /********************************************************************
-    SaveBlobAsPngImage
-        Save blob as a PNG image
-    Exceptions:
-        None
-    *********************************************************************/
-    void    Camera::SaveBlobAsPngImage( CvBlob* pB,
-                                        std::string& strName )
-    {
-        //save the particular blob to a PNG file
-        cv::Rect roi;
-        if ( m_downScaleImage )
+        if ( m_realTimeMode )
         {
-            roi = cv::Rect( std::max( 0, (int)floor(pB->x * 2 - pB->w) ),
-                            std::max( 0,(int)floor(pB->y * 2 - pB->h)),
-                            (int)floor(pB->w * 2),
-                            (int)floor(pB->h * 2) ); 
+            const int64 nowTicks = cv::getTickCount();
 
-            if ( roi.x+roi.width  > m_width * 2 ) 
+            // the capture clock is anchored at the first processed frame
+            if ( !m_clockStarted )
             {
-                roi.width = m_width * 2 - roi.x - 1;
+                m_clockStartTicks       = nowTicks;
+                m_clockStartTimestamp   = timestamp;
+                m_clockStarted          = true;
             }
 
-            if ( roi.y+roi.height > m_height * 2 )
-            {
-                roi.height = m_height * 2 - roi.y - 1;
-            }
-        }
-        else
-        {
-            roi = cv::Rect( std::max(0,(int)floor(pB->x - pB->w/2)),
-                            std::max(0, (int)floor(pB->y - pB->h / 2)),
-                            (int)floor(pB->w),
-                            (int)floor(pB->h) );
+            double lag = ( nowTicks - m_clockStartTicks ) / cv::getTickFrequency() -
+                         ( timestamp - m_clockStartTimestamp );
 
-            if ( roi.x+roi.width  > m_width )
+            // replay no faster than the capture rate: the frame is handed back
+            // until its capture time, so the caller waits instead of this thread
+            if ( lag < 0 )
             {
-                roi.width = m_width - roi.x - 1;
+                if ( !frameWasPending )
+                {
+                    m_pendingTimestamp  = timestamp;
+                    m_frameDueTicks     = nowTicks + (int64)( -lag * cv::getTickFrequency() );
+                    m_framePending      = true;
+                    return true;
+                }
+                lag = 0;
             }
 
-            if ( roi.y+roi.height > m_height )
+            UpdateSheddingLevel( lag );
+
+            // skip the frame conversion and detection, but process a frame at least every m_maxCoastFrames
+            if ( m_stats.m_sheddingLevel >= SHED_LEVEL_COAST && m_coastedFrames < m_maxCoastFrames && m_pTracker != NULL )
             {
-                roi.height = m_height - roi.y - 1;
+                m_frameTimestamp = timestamp;
+                CoastFrame( m_frameNum );
+                UpdateCheckpoint( false );
+                return true;
             }
+            m_coastedFrames = 0;
         }
-        
-        cv::imwrite( strName,
-                     m_originalFrameMat(roi) );  
+
+        // get the video frame
+        const int64 retrieveStartTicks = cv::getTickCount();
+        m_pFrameSource->Retrieve( m_originalFrameMat );
+        m_decodeTicks += cv::getTickCount() - retrieveStartTicks;
+
+        ProcessFrame( m_originalFrameMat, m_frameNum, timestamp );
+        UpdateCheckpoint( false );
+        return true;
     }
 
-    /********************************************************************
-    SaveBlobRecord
-        Saves the blob record on to a file
-    Exceptions:
+    /*************************************************************************
+    WaitForFrameDue
+        Sleep until the frame handed back by ProcessNextFrame is due, for
+        callers that process one camera on their own thread
+    Exceptions
         None
-    *********************************************************************/
-    void Camera::SaveBlobRecord( CvBlob* pBlob, int frameNumber )
+    *************************************************************************/
+    void Camera::WaitForFrameDue( ) const
     {
-        ASSERT_TRUE( pBlob != NULL );
-        try
+        if ( !m_framePending )
         {
-            // Stream the frame number
-            *m_pOutputRecordFileStream<< frameNumber << ' ';
-
-            int scale = m_downScaleImage ? 2 : 1;
+            return;
+        }
 
-            // Stream the bounding box
-            *m_pOutputRecordFileStream << std::max( cvRound( pBlob->x ),0 ) * scale << ' ' << std::max( cvRound( pBlob->y ), 0 ) * scale << ' ' <<
-                std::max( cvRound( pBlob->w ), 0 )*scale << ' ' << std::max( cvRound( pBlob->h ), 0 ) * scale << ' ';
+        const int64 waitTicks = m_frameDueTicks - cv::getTickCount();
+        if ( waitTicks > 0 )
+        {
+            boost::this_thread::sleep( boost::posix_time::microseconds( (boost::int64_t)( waitTicks * 1e6 / cv::getTickFrequency() ) ) );
+        }
+    }
 
-            // Stream the blob ID
-            *m_pOutputRecordFileStream<< CV_BLOB_ID( pBlob ) << '\t';
+    /*************************************************************************
+    EndProcessing
+        Log the summary of the processing
+    Exceptions
+        None
+    *************************************************************************/
+    void Camera::EndProcessing( )
+    {
+        LogCameraScope logCamera( m_cameraId );
+
+        if ( m_realTimeMode )
+        {
+            const int frames = m_stats.m_framesProcessed + m_stats.m_framesDropped;
+            LOG( "Processed " << m_stats.m_framesProcessed << " frames, " << m_stats.m_framesShed << " without overlays, dropped " <<
+                 m_stats.m_framesDropped << ", lag mean " << ( frames > 0 ? m_stats.m_totalLagSeconds / frames : 0.0 ) <<
+                 " s, max " << m_stats.m_maxLagSeconds << " s" );
+        }
+
+        if ( m_pActivityGate != NULL )
+        {
+            LOG( "Skipped " << m_stats.m_framesIdle << " idle frames of " << m_stats.m_framesIdle + m_stats.m_framesProcessed );
+        }
+
+        // a camera that has processed all its frames is not resumed again
+        if ( m_framesEnded )
+        {
+            UpdateCheckpoint( true );
+        }
+
+        UpdateMemoryUsage( );
+
+        const MemoryUsage& memory = m_stats.m_memory;
+        LOG( "Memory " << memory.GetTotalBytes() / 1024 << " KB ( frames " << memory.m_frameBytes / 1024 <<
+             ", FG model " << memory.m_fgModelBytes / 1024 << ", tracker " << memory.m_trackerBytes / 1024 <<
+             ", analysis " << memory.m_analysisBytes / 1024 << ", crops " << memory.m_outputBytes / 1024 <<
+             " ), peak " << m_stats.m_peakMemoryBytes / 1024 << " KB, process resident " <<
+             GetProcessResidentBytes() / 1024 << " KB" );
+
+        LOG( "End of processing " + m_videoFileName );
+    }
+
+    /*************************************************************************
+    ReleaseMetrics
+        Unregister the metrics, so that a long job list does not leave
+        the series of every ended camera behind
+    Exceptions
+        None
+    *************************************************************************/
+    void Camera::ReleaseMetrics( )
+    {
+        if ( m_pMetrics )
+        {
+            Metrics::Instance().RemoveCamera( m_pMetrics );
+            m_pMetrics.reset();
+        }
+    }
+
+    /*************************************************************************
+    ProcessFrame
+        Process one decoded frame of the video
+    Exceptions
+        None
+    *************************************************************************/
+    void Camera::ProcessFrame( const cv::Mat& frame, const int frameNum, const double timestamp )
+    {
+        LogCameraScope logCamera( m_cameraId );
+
+        m_originalFrameMat  = frame;
+        m_frameTimestamp    = ( timestamp >= 0 ) ? timestamp : ( frameNum - 1 ) / m_liveFrameRate;
+
+        if ( m_pTracker == NULL )
+        {
+            CreateModules( );
+        }
+
+        // frames of a static scene skip the pipeline while nothing is tracked
+        if ( m_pActivityGate != NULL &&
+             !m_pActivityGate->IsActive( m_originalFrameMat, m_pTracker->GetBlobNum() == 0 && m_stats.m_framesProcessed > m_fgTrainFrames ) )
+        {
+            m_stats.m_framesIdle++;
+            PublishMetrics( frameNum );
+            return;
+        }
+
+        // overlays and crops are the first to go when behind
+        const bool shedExtras = m_stats.m_sheddingLevel >= SHED_LEVEL_EXTRAS;
+
+        m_stats.m_framesProcessed++;
+        if ( shedExtras )
+        {
+            m_stats.m_framesShed++;
+        }
+
+        // account the memory and degrade when over the budget
+        if ( m_stats.m_framesProcessed % MEMORY_CHECK_INTERVAL == 0 )
+        {
+            UpdateMemoryUsage( );
+
+            if ( m_memoryBudget > 0 && m_stats.m_memory.GetTotalBytes() > m_memoryBudget )
+            {
+                ShedMemory( );
+            }
+        }
+
+        // downscale the image if required
+        if ( m_downScaleImage && m_sourceScale == 1.0 )
+        {
+            cv::resize( m_originalFrameMat, m_frame,  m_frame.size() );
+        }
+        else
+        {
+            m_frame = m_originalFrameMat;
+        }
+
+        const int64 trackingStartTicks = cv::getTickCount();
+
+        // Move the tracked blobs along the motion vectors
+        if ( m_pMotionField != NULL )
+        {
+            ApplyMotionVectors( );
+        }
+
+        // Process the current frame
+        m_pTracker->Process( m_frame );
+
+        if ( m_realTimeMode )
+        {
+            UpdateBlobMotion( frameNum );
+        }
 
-            // Stream the timestamp
-            *m_pOutputRecordFileStream << 0;
+        const int64 outputStartTicks = cv::getTickCount();
+        if ( m_pMetrics )
+        {
+            m_pMetrics->m_trackingMicroseconds.fetch_add( (boost::int64_t)( ( outputStartTicks - trackingStartTicks ) * 1e6 / cv::getTickFrequency() ),
+                                                          boost::memory_order_relaxed );
+        }
 
-            // Add a new line
-            *m_pOutputRecordFileStream << std::endl;
+        // the tracks of the checkpoint keep their IDs
+        if ( !m_resumeTracks.empty() && frameNum >= m_resumeFrame )
+        {
+            MatchResumedTracks( frameNum );
+        }
+
+        // the frames before a resumed checkpoint only train the models
+        if ( frameNum <= m_resumeFrame )
+        {
+            PublishMetrics( frameNum );
+            return;
+        }
+
+        // Save Blob Information in a file
+        for( int i = m_pTracker->GetBlobNum(); i> 0; i-- )
+        {
+            CvBlob* pBlob = m_pTracker->GetBlob(i-1);
+
+            ASSERT_TRUE( pBlob != NULL );
+
+            // Save blob record
+            SaveBlobRecord( pBlob, frameNum );
+
+            // Queue the blob crop, before overlays are drawn
+            if ( m_pCropExporter != NULL && !shedExtras )
+            {
+                m_pCropExporter->AddCrop( m_originalFrameMat, GetBlobRegion( pBlob ), GetRecordId( pBlob ), frameNum );
+            }
+        }
+
+        if ( m_pCropExporter != NULL && !shedExtras )
+        {
+            m_pCropExporter->EndFrame( frameNum );
+        }
+
+        if ( !shedExtras )
+        {
+            RenderOutputs( frameNum );
+        }
+
+        if ( m_pMetrics )
+        {
+            m_pMetrics->m_outputMicroseconds.fetch_add( (boost::int64_t)( ( cv::getTickCount() - outputStartTicks ) * 1e6 / cv::getTickFrequency() ),
+                                                        boost::memory_order_relaxed );
+        }
+        PublishMetrics( frameNum );
+    }
+
+    /*************************************************************************
+    RenderOutputs
+        Draw the frame number and the tracked blobs, display and save the
+        intermediate results
+    Exceptions
+        None
+    *************************************************************************/
+    void Camera::RenderOutputs( const int frameNum )
+    {
+        if ( m_displayIntermediateResult || m_saveIntermediateResult )
+        {
+            char tempString[128];
+            std::string textMessage;
+            //display intermediate result if necessary
+            CvFont    font; 
+            CvSize  TextSize;
+            cvInitFont( &font, CV_FONT_HERSHEY_PLAIN, 0.7, 0.7, 0, 1, CV_AA );
+
+            // draw on a copy, the mask belongs to the foreground detector
+            m_pTracker->GetFGMask().copyTo( m_fgMask );
+
+            // and the frame to the source, e.g. a shared memory slot, a read-only
+            // cache mapping or the frame of all sweep variants
+            if ( m_frame.data == m_originalFrameMat.data )
+            {
+                m_originalFrameMat.copyTo( m_overlayFrame );
+                m_frame = m_overlayFrame;
+            }
+
+            sprintf(tempString,"frame # %d", frameNum);
+            textMessage = tempString;
+            cv::putText( m_fgMask,textMessage, cv::Point(10,20), CV_FONT_HERSHEY_PLAIN, 1, cv::Scalar((0,255,255)));
+            cv::putText( m_frame, textMessage, cv::Point(10,20), CV_FONT_HERSHEY_PLAIN, 1, cv::Scalar((0,255,255)));
+
+            //drawing blobs if any with green ellipse with m_cvBlob id displayed next to it.
+            int c = 0; // 0: g; 255: red
+            for ( int i = m_pTracker->GetBlobNum(); i > 0; i-- )
+            {
+                CvBlob* pBlob = m_pTracker->GetBlob(i-1);
+
+                ASSERT_TRUE( pBlob != NULL );
+
+                cv::Point blobCorner( cvRound( pBlob->x * 256 ), cvRound( pBlob->y * 256 ) );
+
+                CvSize  blobSize = cvSize( MAX( 1, cvRound( CV_BLOB_RX(pBlob) * 256 ) ), 
+                                           MAX( 1, cvRound( CV_BLOB_RY(pBlob) * 256 ) ) );
+
+                cv::Scalar boundingBoxColor( c, 255-c, 0 );
+
+                if ( m_pTracker->GetState( CV_BLOB_ID( pBlob ) ) != 0 )
+                {
+                    boundingBoxColor = cv::Scalar( 255-c, c, 0 );
+                }
+
+                cv::ellipse( m_frame, 
+                            cv::RotatedRect( cv::Point2f( pBlob->x, pBlob->y ), cv::Size2f( pBlob->w, pBlob->h ), 0 ),
+                            cv::Scalar( c, 255-c, 0 ) );
+                blobCorner.x >>= 8;      
+                blobCorner.y >>= 8;
+                
+                blobSize.width >>= 8;
+                blobSize.height >>= 8;
+                blobCorner.y -= blobSize.height;
+
+                sprintf( tempString, "BlobId=%03d", CV_BLOB_ID(pBlob) );
+                cvGetTextSize( tempString, &font, &TextSize, NULL );
+                
+                cv::putText( m_frame,
+                             std::string( tempString ),
+                             blobCorner,
+                             CV_FONT_HERSHEY_PLAIN,
+                             1,
+                             cv::Scalar( 255, 255, 0, 0 ) );
+            }
+        }
+
+        if ( m_displayIntermediateResult )
+        {
+            cv::imshow(m_outputName+"_FGMask", m_fgMask);
+            cv::imshow(m_outputName+"_Tracking", m_frame);
+        }
+
+        if ( m_saveIntermediateResult )
+        {
+            cv::Mat tmpFrame;
+            cv::cvtColor( m_fgMask, tmpFrame, CV_GRAY2BGR );
+            *m_pFGAvi << tmpFrame;             
+            *m_pBTAvi << m_frame;
+        }
+    }
+
+
+    /********************************************************************
+    ApplyMotionVectors
+        Estimates the macroblock motion of the current frame and shifts
+        every tracked blob by the median motion under it, so that the
+        tracker search starts close to the new position
+    Exceptions:
+        None
+    *********************************************************************/
+    void Camera::ApplyMotionVectors( )
+    {
+        ASSERT_TRUE( m_pMotionField != NULL );
+        ASSERT_TRUE( m_pBlobTracker != NULL );
+
+        m_pMotionField->Update( m_frame );
+
+        for ( int i = m_pBlobTracker->GetBlobNum(); i > 0; i-- )
+        {
+            CvBlob* pBlob = m_pBlobTracker->GetBlob( i-1 );
+
+            ASSERT_TRUE( pBlob != NULL );
+
+            const cv::Rect region( cvRound( pBlob->x - pBlob->w / 2 ),
+                                   cvRound( pBlob->y - pBlob->h / 2 ),
+                                   cvRound( pBlob->w ),
+                                   cvRound( pBlob->h ) );
+
+            cv::Point2f motion;
+            if ( m_pMotionField->GetRegionMotion( region, motion ) )
+            {
+                pBlob->x += motion.x;
+                pBlob->y += motion.y;
+            }
+        }
+    }
+
+    /********************************************************************
+    ReportPlacement
+        Logs the core set of the camera and the NUMA node holding its
+        working frame
+    Exceptions:
+        None
+    *********************************************************************/
+    void Camera::ReportPlacement( ) const
+    {
+        if ( m_coreSet.empty() )
+        {
+            LOG( "Camera " << m_cameraId << " runs on all cores, frames on node " << GetMemoryNode( m_frame.data ) );
+        }
+        else
+        {
+            LOG( "Camera " << m_cameraId << " runs on cores " << FormatCoreSet( m_coreSet ) << " of node " << FormatCoreNodes( m_coreSet ) <<
+                 ", frames on node " << GetMemoryNode( m_frame.data ) );
+        }
+    }
+
+    /********************************************************************
+    UpdateSheddingLevel
+        Sheds overlays and crops beyond m_lagThreshold of lag, and drops
+        frames beyond twice of it. Levels are only lowered once the lag
+        is well below the threshold, so they do not flap.
+    Exceptions:
+        None
+    *********************************************************************/
+    void Camera::UpdateSheddingLevel( const double lagSeconds )
+    {
+        m_stats.m_lagSeconds        = lagSeconds;
+        m_stats.m_maxLagSeconds     = std::max( m_stats.m_maxLagSeconds, lagSeconds );
+        m_stats.m_totalLagSeconds   += lagSeconds;
+
+        int level = m_stats.m_sheddingLevel;
+        if ( lagSeconds > 2 * m_lagThreshold )
+        {
+            level = SHED_LEVEL_COAST;
+        }
+        else if ( lagSeconds > m_lagThreshold )
+        {
+            level = std::max( level, SHED_LEVEL_EXTRAS );
+        }
+        else if ( lagSeconds > m_lagThreshold / 2 )
+        {
+            level = std::min( level, SHED_LEVEL_EXTRAS );
+        }
+        else
+        {
+            level = SHED_LEVEL_NONE;
+        }
+
+        if ( level != m_stats.m_sheddingLevel )
+        {
+            LOG_WARNING( "Lag of " << lagSeconds << " s, shedding level " << m_stats.m_sheddingLevel << " -> " << level );
+            m_stats.m_sheddingLevel = level;
+        }
+    }
+
+    /********************************************************************
+    UpdateBlobMotion
+        Keeps the position and per-frame velocity of each tracked blob
+        for predicting it over dropped frames
+    Exceptions:
+        None
+    *********************************************************************/
+    void Camera::UpdateBlobMotion( const int frameNum )
+    {
+        std::map<int, BlobMotion> blobMotion;
+
+        for ( int i = m_pTracker->GetBlobNum(); i > 0; i-- )
+        {
+            CvBlob* pBlob = m_pTracker->GetBlob( i-1 );
+
+            ASSERT_TRUE( pBlob != NULL );
+
+            BlobMotion motion;
+            motion.m_position   = cv::Point2f( pBlob->x, pBlob->y );
+            motion.m_velocity   = cv::Point2f( 0, 0 );
+            motion.m_frameNum   = frameNum;
+
+            std::map<int, BlobMotion>::const_iterator previousIt = m_blobMotion.find( CV_BLOB_ID( pBlob ) );
+            if ( previousIt != m_blobMotion.end() && previousIt->second.m_frameNum < frameNum )
+            {
+                const float frames = (float)( frameNum - previousIt->second.m_frameNum );
+                motion.m_velocity = cv::Point2f( ( motion.m_position.x - previousIt->second.m_position.x ) / frames,
+                                                 ( motion.m_position.y - previousIt->second.m_position.y ) / frames );
+            }
+
+            blobMotion[CV_BLOB_ID( pBlob )] = motion;
+        }
+
+        m_blobMotion.swap( blobMotion );
+    }
+
+    /********************************************************************
+    CoastFrame
+        Records the blobs of the last processed frame moved along their
+        velocity, without decoding the frame or running the tracker
+    Exceptions:
+        None
+    *********************************************************************/
+    void Camera::CoastFrame( const int frameNum )
+    {
+        for ( int i = m_pTracker->GetBlobNum(); i > 0; i-- )
+        {
+            CvBlob blob = *m_pTracker->GetBlob( i-1 );
+
+            std::map<int, BlobMotion>::const_iterator motionIt = m_blobMotion.find( CV_BLOB_ID( &blob ) );
+            if ( motionIt != m_blobMotion.end() )
+            {
+                const float frames = (float)( frameNum - motionIt->second.m_frameNum );
+                blob.x = motionIt->second.m_position.x + motionIt->second.m_velocity.x * frames;
+                blob.y = motionIt->second.m_position.y + motionIt->second.m_velocity.y * frames;
+            }
+
+            if ( frameNum > m_resumeFrame )
+            {
+                SaveBlobRecord( &blob, frameNum );
+            }
+        }
+
+        m_stats.m_framesDropped++;
+        m_coastedFrames++;
+
+        PublishMetrics( frameNum );
+    }
+
+    /********************************************************************
+    PublishMetrics
+        Stores the counters into the live metrics; the metrics thread
+        reads them without locking
+    Exceptions:
+        None
+    *********************************************************************/
+    void Camera::PublishMetrics( const int frameNum )
+    {
+        if ( !m_pMetrics )
+        {
+            return;
+        }
+
+        CameraMetrics& metrics = *m_pMetrics;
+
+        metrics.m_frameNumber.store( frameNum, boost::memory_order_relaxed );
+        metrics.m_framesProcessed.store( m_stats.m_framesProcessed, boost::memory_order_relaxed );
+        metrics.m_framesShed.store( m_stats.m_framesShed, boost::memory_order_relaxed );
+        metrics.m_framesDropped.store( m_stats.m_framesDropped, boost::memory_order_relaxed );
+        metrics.m_framesIdle.store( m_stats.m_framesIdle, boost::memory_order_relaxed );
+        metrics.m_activeBlobs.store( m_pTracker != NULL ? m_pTracker->GetBlobNum() : 0, boost::memory_order_relaxed );
+        metrics.m_cropQueueDepth.store( m_pCropExporter != NULL ? m_pCropExporter->GetQueueDepth() : 0, boost::memory_order_relaxed );
+        metrics.m_lagMicroseconds.store( (boost::int64_t)( m_stats.m_lagSeconds * 1e6 ), boost::memory_order_relaxed );
+        metrics.m_memoryBytes.store( (boost::int64_t)m_stats.m_memory.GetTotalBytes(), boost::memory_order_relaxed );
+        metrics.m_sheddingLevel.store( m_stats.m_sheddingLevel, boost::memory_order_relaxed );
+        metrics.m_memoryLevel.store( m_stats.m_memoryLevel, boost::memory_order_relaxed );
+
+        // decoding was timed by ProcessNextFrame, frames decoded by the caller have none
+        metrics.m_decodeMicroseconds.fetch_add( (boost::int64_t)( m_decodeTicks * 1e6 / cv::getTickFrequency() ), boost::memory_order_relaxed );
+        m_decodeTicks = 0;
+    }
+
+    /********************************************************************
+    UpdateMemoryUsage
+        Accounts the memory of the camera by module. Images and crop
+        buffers are measured, the legacy modules are estimated.
+    Exceptions:
+        None
+    *********************************************************************/
+    void Camera::UpdateMemoryUsage( )
+    {
+        MemoryUsage& memory = m_stats.m_memory;
+
+        memory.m_frameBytes = GetMatBytes( m_originalFrameMat ) + GetMatBytes( m_fgMask );
+        if ( m_frame.data != m_originalFrameMat.data )
+        {
+            memory.m_frameBytes += GetMatBytes( m_frame );
+        }
+        if ( m_pMotionField != NULL )
+        {
+            memory.m_frameBytes += m_pMotionField->GetMemoryBytes();
+        }
+
+        memory.m_fgModelBytes   = EstimateFGModelBytes( m_fgDetectorModName, m_width, m_height );
+        memory.m_trackerBytes   = EstimateTrackerBytes( m_blobTrackerModName, m_pTracker != NULL ? m_pTracker->GetBlobNum() : 0 );
+        memory.m_analysisBytes  = EstimateAnalysisBytes( m_blobAnalyzerModName, m_blobFrames );
+        memory.m_outputBytes    = m_pCropExporter != NULL ? m_pCropExporter->GetBufferBytes() : 0;
+
+        m_stats.m_peakMemoryBytes = std::max( m_stats.m_peakMemoryBytes, memory.GetTotalBytes() );
+    }
+
+    /********************************************************************
+    ShedMemory
+        Rebuilds the pipeline one level down: without the trajectory
+        analysis first, then at half the frame size. The background is
+        trained again and the tracks restart with new IDs.
+    Exceptions:
+        None
+    *********************************************************************/
+    void Camera::ShedMemory( )
+    {
+        int level = m_stats.m_memoryLevel;
+        if ( level < MEMORY_LEVEL_NO_ANALYSIS && m_blobAnalyzerModName.compare( "None" ) != 0 )
+        {
+            level = MEMORY_LEVEL_NO_ANALYSIS;
+        }
+        else if ( level < MEMORY_LEVEL_HALF_SCALE && !m_downScaleImage && m_sourceScale == 1.0 )
+        {
+            level = MEMORY_LEVEL_HALF_SCALE;
+        }
+        else
+        {
+            if ( !m_overBudgetLogged )
+            {
+                LOG_WARNING( "Memory of " << m_stats.m_memory.GetTotalBytes() / 1024 << " KB over the budget of " <<
+                             m_memoryBudget / 1024 << " KB, nothing left to shed" );
+                m_overBudgetLogged = true;
+            }
+            return;
+        }
+
+        LOG_WARNING( "Memory of " << m_stats.m_memory.GetTotalBytes() / 1024 << " KB over the budget of " <<
+                     m_memoryBudget / 1024 << " KB, memory level " << m_stats.m_memoryLevel << " -> " << level );
+        m_stats.m_memoryLevel = level;
+
+        if ( level == MEMORY_LEVEL_NO_ANALYSIS )
+        {
+            m_blobAnalyzerModName = "None";
+        }
+        else
+        {
+            m_downScaleImage = true;
+
+            // the saved videos cannot change their frame size
+            if ( m_saveIntermediateResult )
+            {
+                delete m_pFGAvi;
+                delete m_pBTAvi;
+                m_pFGAvi = NULL;
+                m_pBTAvi = NULL;
+                m_saveIntermediateResult = false;
+            }
+        }
+
+        // tracks of the new pipeline must not reuse the IDs of the old one
+        m_blobIdOffset = m_maxBlobId + 1;
+        m_blobMotion.clear();
+        m_resumedIds.clear();
+
+        ReleasePipeline( );
+        CreatePipeline( );
+        UpdateMemoryUsage( );
+    }
+
+    /********************************************************************
+    SaveBlobAsPngImage
+        Save blob as a PNG image
+    Exceptions:
+        None
+    *********************************************************************/
+    void    Camera::SaveBlobAsPngImage( CvBlob* pB,
+                                        std::string& strName )
+    {
+        //save the particular blob to a PNG file
+        cv::imwrite( strName,
+                     m_originalFrameMat( GetBlobRegion( pB ) ) );  
+    }
+
+    /*************************************************************************
+    GetBlobRegion
+        Bounding box of a blob in the original frame
+    Exceptions
+        None
+    *************************************************************************/
+    cv::Rect Camera::GetBlobRegion( CvBlob* pB ) const
+    {
+        cv::Rect roi;
+        if ( m_downScaleImage && m_sourceScale == 1.0 )
+        {
+            roi = cv::Rect( std::max( 0, (int)floor(pB->x * 2 - pB->w) ),
+                            std::max( 0,(int)floor(pB->y * 2 - pB->h)),
+                            (int)floor(pB->w * 2),
+                            (int)floor(pB->h * 2) ); 
+
+            if ( roi.x+roi.width  > m_width * 2 ) 
+            {
+                roi.width = m_width * 2 - roi.x - 1;
+            }
+
+            if ( roi.y+roi.height > m_height * 2 )
+            {
+                roi.height = m_height * 2 - roi.y - 1;
+            }
+        }
+        else
+        {
+            roi = cv::Rect( std::max(0,(int)floor(pB->x - pB->w/2)),
+                            std::max(0, (int)floor(pB->y - pB->h / 2)),
+                            (int)floor(pB->w),
+                            (int)floor(pB->h) );
+
+            if ( roi.x+roi.width  > m_width )
+            {
+                roi.width = m_width - roi.x - 1;
+            }
+
+            if ( roi.y+roi.height > m_height )
+            {
+                roi.height = m_height - roi.y - 1;
+            }
+        }
+
+        return roi;
+    }
+
+    /********************************************************************
+    SaveBlobRecord
+        Saves the blob record on to a file
+    Exceptions:
+        None
+    *********************************************************************/
+    void Camera::SaveBlobRecord( CvBlob* pBlob, int frameNumber )
+    {
+        ASSERT_TRUE( pBlob != NULL );
+        try
+        {
+            const BlobRecord record = MakeBlobRecord( pBlob, frameNumber );
+
+            m_maxBlobId = std::max( m_maxBlobId, record.m_id );
+            m_blobFrames++;
+
+            m_pRecordWriter->Write( record );
         }
         EXCEPTION_CATCH_AND_ABORT( "Failed to save blob information" );
     }
+
+    /********************************************************************
+    MakeBlobRecord
+        Record of a blob in the original frame
+    Exceptions:
+        None
+    *********************************************************************/
+    BlobRecord Camera::MakeBlobRecord( CvBlob* pBlob, const int frameNumber ) const
+    {
+        BlobRecord record;
+        record.m_frameNumber = frameNumber;
+
+        int scale = m_downScaleImage ? 2 : 1;
+
+        // the bounding box
+        record.m_x      = std::max( cvRound( pBlob->x ), 0 ) * scale;
+        record.m_y      = std::max( cvRound( pBlob->y ), 0 ) * scale;
+        record.m_width  = std::max( cvRound( pBlob->w ), 0 ) * scale;
+        record.m_height = std::max( cvRound( pBlob->h ), 0 ) * scale;
+
+        // the blob ID, unique over pipeline rebuilds
+        record.m_id = GetRecordId( pBlob );
+
+        // the timestamp
+        record.m_timestamp = m_frameTimestamp;
+
+        return record;
+    }
+
+    /********************************************************************
+    GetRecordId
+        Record ID of a blob: the ID of the checkpoint track it continues,
+        or its tracker ID past the IDs of earlier pipelines
+    Exceptions:
+        None
+    *********************************************************************/
+    int Camera::GetRecordId( CvBlob* pBlob ) const
+    {
+        std::map<int, int>::const_iterator resumedIt = m_resumedIds.find( CV_BLOB_ID( pBlob ) );
+        if ( resumedIt != m_resumedIds.end() )
+        {
+            return resumedIt->second;
+        }
+
+        return m_blobIdOffset + CV_BLOB_ID( pBlob );
+    }
+
+    /********************************************************************
+    GetRecordFileName / GetOutputBaseName
+        Names of the outputs of the camera
+    Exceptions:
+        None
+    *********************************************************************/
+    std::string Camera::GetRecordFileName( ) const
+    {
+        return m_videoOutputDirectory + "/" + m_outputName + "_record.txt";
+    }
+
+    std::string Camera::GetOutputBaseName( ) const
+    {
+        if ( m_resumeFrame < 0 )
+        {
+            return m_videoOutputDirectory + "/" + m_outputName;
+        }
+
+        std::ostringstream baseName;
+        baseName << m_videoOutputDirectory << "/" << m_outputName << "_from" << m_resumeFrame + 1;
+        return baseName.str();
+    }
+
+    /********************************************************************
+    UpdateCheckpoint
+        Writes a checkpoint every m_checkpointInterval frames, and a
+        complete one at the end. The records of the frame are flushed
+        first, so the record file never ends before its checkpoint.
+    Exceptions:
+        None
+    *********************************************************************/
+    void Camera::UpdateCheckpoint( const bool complete )
+    {
+        if ( m_checkpointInterval <= 0 || m_pRecordWriter == NULL || m_frameNum <= m_resumeFrame )
+        {
+            return;
+        }
+
+        if ( !complete && m_frameNum < m_lastCheckpointFrame + m_checkpointInterval )
+        {
+            return;
+        }
+
+        m_pRecordWriter->Flush( );
+
+        CameraCheckpoint checkpoint;
+        checkpoint.m_frameNumber    = m_frameNum;
+        checkpoint.m_recordOffset   = m_pRecordWriter->GetOffset();
+        checkpoint.m_maxBlobId      = m_maxBlobId;
+        checkpoint.m_complete       = complete;
+
+        if ( m_pTracker != NULL )
+        {
+            for ( int i = 0; i < m_pTracker->GetBlobNum(); i++ )
+            {
+                checkpoint.m_tracks.push_back( MakeBlobRecord( m_pTracker->GetBlob( i ), m_frameNum ) );
+            }
+        }
+
+        if ( !WriteCheckpoint( GetCheckpointName( GetRecordFileName() ), checkpoint ) )
+        {
+            LOG_WARNING( "Unable to write the checkpoint of " << m_outputName );
+        }
+        m_lastCheckpointFrame = m_frameNum;
+    }
+
+    /********************************************************************
+    MatchResumedTracks
+        Continues each track of the checkpoint with the tracked blob
+        overlapping it most, once the tracker has run on the frames
+        before the checkpoint
+    Exceptions:
+        None
+    *********************************************************************/
+    void Camera::MatchResumedTracks( const int frameNum )
+    {
+        std::vector<bool> matched( m_pTracker->GetBlobNum(), false );
+
+        for ( unsigned int t = 0; t < m_resumeTracks.size(); t++ )
+        {
+            const cv::Rect  trackBox    = GetRecordBox( m_resumeTracks[t] );
+            int             bestBlob    = -1;
+            double          bestOverlap = RESUME_MIN_OVERLAP;
+
+            for ( int i = 0; i < m_pTracker->GetBlobNum(); i++ )
+            {
+                if ( matched[i] )
+                {
+                    continue;
+                }
+
+                const cv::Rect  blobBox         = GetRecordBox( MakeBlobRecord( m_pTracker->GetBlob( i ), frameNum ) );
+                const double    intersection    = ( trackBox & blobBox ).area();
+                const double    unionArea       = trackBox.area() + blobBox.area() - intersection;
+                const double    overlap         = unionArea > 0 ? intersection / unionArea : 0.0;
+                if ( overlap >= bestOverlap )
+                {
+                    bestBlob    = i;
+                    bestOverlap = overlap;
+                }
+            }
+
+            if ( bestBlob >= 0 )
+            {
+                matched[bestBlob] = true;
+                m_resumedIds[CV_BLOB_ID( m_pTracker->GetBlob( bestBlob ) )] = m_resumeTracks[t].m_id;
+            }
+        }
+
+        LOG_FILE( "Continued " << m_resumedIds.size() << " of the " << m_resumeTracks.size() << " tracks of the checkpoint" );
+        m_resumeTracks.clear();
+    }
 }
\ No newline at end of file
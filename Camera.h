@@ -3,11 +3,23 @@
 
 #include "OpenCvDefinitions.h"
 #include "CommonMacros.h"
+#include "MotionField.h"
+#include "FrameSource.h"
+#include "FrameCache.h"
+#include "CropExporter.h"
+#include "RecordIndex.h"
+#include "Affinity.h"
+#include "MemoryUsage.h"
+#include "Metrics.h"
+#include "TrackingEngine.h"
+#include "ActivityGate.h"
+#include "Checkpoint.h"
 
 #include <boost/shared_ptr.hpp>
 
 #include <iostream>
 #include <fstream>
+#include <map>
 #include <vector>
 #include <string.h>
 
@@ -16,6 +28,41 @@ namespace Tracker
     // typedef for video writer
     typedef cv::VideoWriter* VideoWritePtr;
 
+    /*
+    *   Processing counters of a camera. Lag is measured against the
+    *   capture clock of the source in the real-time mode, memory every
+    *   MEMORY_CHECK_INTERVAL frames.
+    */
+    struct CameraStats
+    {
+        CameraStats( )
+            : m_framesProcessed( 0 ),
+            m_framesShed( 0 ),
+            m_framesDropped( 0 ),
+            m_framesIdle( 0 ),
+            m_sheddingLevel( 0 ),
+            m_lagSeconds( 0 ),
+            m_maxLagSeconds( 0 ),
+            m_totalLagSeconds( 0 ),
+            m_memory( ),
+            m_peakMemoryBytes( 0 ),
+            m_memoryLevel( 0 )
+        {
+        }
+
+        int                 m_framesProcessed;  // frames run through the tracker
+        int                 m_framesShed;       // processed without overlays and crops
+        int                 m_framesDropped;    // not decoded, the tracks coasted
+        int                 m_framesIdle;       // static scene, skipped the tracker
+        int                 m_sheddingLevel;    // 0: full, 1: no overlays and crops, 2: coasting
+        double              m_lagSeconds;       // at the last frame
+        double              m_maxLagSeconds;
+        double              m_totalLagSeconds;  // over processed and dropped frames
+        MemoryUsage         m_memory;           // at the last check
+        size_t              m_peakMemoryBytes;
+        int                 m_memoryLevel;      // 0: full, 1: no analysis, 2: half frame size
+    };
+
     /*
     *   Performs camera level processing.
     */
@@ -33,6 +80,19 @@ namespace Tracker
     void Process( const int startFrameIndex,
                   const int endFrameIndex );
 
+    // Process step by step: BeginProcessing, ProcessNextFrame until it
+    // returns false, EndProcessing. In the real-time mode a frame grabbed
+    // before its capture time is handed back: call ProcessNextFrame again
+    // once GetFrameDueTicks has passed, or after WaitForFrameDue
+    void BeginProcessing( const int startFrameIndex,
+                          const int endFrameIndex );
+    bool ProcessNextFrame( );
+    void WaitForFrameDue( ) const;
+    void EndProcessing( );
+
+    // Unregister the metrics of a camera that has ended
+    void ReleaseMetrics( );
+
     // Initialize various modules - detection, tracking
     void Initialize( std::string fgDetectionParams,
                      std::string blobDetectionParams,
@@ -40,8 +100,30 @@ namespace Tracker
                      std::string blobAnalysisParams,
                      std::string blobPostProcessingParams );
 
+    // Initialize with the module parameters of the applied settings
+    void Initialize( );
+
+    // Initialize the modules for frames decoded by the caller
+    void Initialize( const cv::Mat&  firstFrame,
+                     const double    sourceScale,
+                     std::string     fgDetectionParams,
+                     std::string     blobDetectionParams,
+                     std::string     blobTrackerParams,
+                     std::string     blobAnalysisParams,
+                     std::string     blobPostProcessingParams );
+
+    // Process one decoded frame captured at the timestamp in seconds,
+    // -1 derives it from the frame number and the live frame rate
+    void ProcessFrame( const cv::Mat& frame,
+                       const int      frameNum,
+                       const double   timestamp = -1.0 );
+
+    // Apply the output and pipeline settings of a configuration
+    void ApplySettings( const InputParameters& settings );
+
     // Setters related to camera, output, input and region
     void SetCameraId( const int id )                            { m_cameraId                = id; }
+    void SetOutputName( const std::string& name )               { m_outputName              = name; }
     void SetVideoOutputDirectory( const char * directoryName )  { m_videoOutputDirectory    = directoryName;}
     void SetFGTrainFrame(const int num)                         { m_fgTrainFrames           = num; }
     void SetFgDetectionModule( const char* fgname )             { m_fgDetectorModName       = fgname; }
@@ -49,11 +131,33 @@ namespace Tracker
     void SetBlobTrackerModule( const char* btname )             { m_blobTrackerModName      = btname; }
     void SetBlobAnalysisModule ( const char* baname  )          { m_blobAnalyzerModName     = baname; }
     void SetBlobProcessingModule ( const char* bpname  )        { m_blobPostProcModName     = bpname; }
+    void SetRawFrameFormat( const RawFrameFormat& format )      { m_rawFrameFormat          = format; }
+
+    int  GetCameraId( ) const                                   { return m_cameraId; }
+    bool IsInitialized( ) const                                 { return m_initializied; }
+    const CameraStats& GetStats( ) const                        { return m_stats; }
+    int  GetFrameNumber( ) const                                { return m_frameNum; }
+    int64 GetFrameDueTicks( ) const                             { return m_framePending ? m_frameDueTicks : 0; }
+    const std::string& GetOutputName( ) const                   { return m_outputName; }
+
+    // Share of the scheduler workers and frame rate cap, 0 for none
+    int    GetScheduleWeight( ) const                           { return m_scheduleWeight; }
+    double GetMaxFrameRate( ) const                             { return m_maxFrameRate; }
+
+    // Cores the decoding, tracking and encoding of the camera run on, empty for all
+    const CoreSet& GetCoreSet( ) const                          { return m_coreSet; }
    
     // Enable Methods
     void EnableDisplayIntermediateResult( ) { m_displayIntermediateResult   = true; }
     void EnableSaveIntermediateResult( )    { m_saveIntermediateResult      = true; }
     void EnableOriginalImageDownScale( )    { m_downScaleImage              = true; }
+    void EnableMotionVectorAssist( )        { m_motionVectorAssist          = true; }
+    void EnableFrameCache( )                { m_frameCache                  = true; }
+    void EnableFrameCacheDownScale( )       { m_frameCacheDownScale         = true; }
+
+    // Motion vector settings
+    void SetMotionBlockSize( const int size )                   { m_motionBlockSize         = size; }
+    void SetMotionSearchRange( const int range )                { m_motionSearchRange       = range; }
     
     private:
 
@@ -62,22 +166,80 @@ namespace Tracker
     // Initialization methods
     void    InitializeOutputVideos( );
     void    InitializeDisplayWindows( );
+    void    InitializeModules( );
+
+    // Create the pipeline and the outputs on the first frame
+    void    CreateModules( );
+
+    // Create and release the detection, tracking and analysis modules
+    void    CreatePipeline( );
+    void    ReleasePipeline( );
+
+    // Account the memory of the modules
+    void    UpdateMemoryUsage( );
+
+    // Degrade the pipeline one level to get under the memory budget
+    void    ShedMemory( );
 
     // Save methods
     void    SaveBlobRecord( CvBlob* pBlob, int frameNumber );
+    BlobRecord MakeBlobRecord( CvBlob* pBlob, const int frameNumber ) const;
+
+    // ID of a tracked blob in the records
+    int     GetRecordId( CvBlob* pBlob ) const;
+
+    // Record file, and base name of the other outputs; those of a resumed
+    // run are named after the checkpoint, so the earlier ones are kept
+    std::string GetRecordFileName( ) const;
+    std::string GetOutputBaseName( ) const;
+
+    // Checkpoints: write one when due, and give the tracks of a resumed
+    // checkpoint their IDs back
+    void    UpdateCheckpoint( const bool complete );
+    void    MatchResumedTracks( const int frameNum );
     void    SaveBlobAsPngImage( CvBlob* pB, std::string& strName );
 
+    // Region of a blob in the original frame
+    cv::Rect GetBlobRegion( CvBlob* pB ) const;
+
+    // Seed the tracked blobs with the motion of the current frame
+    void    ApplyMotionVectors( );
+
+    // Draw the overlays, display and save the intermediate results
+    void    RenderOutputs( const int frameNum );
+
+    // Store the counters of the frame into the live metrics
+    void    PublishMetrics( const int frameNum );
+
+    // Log the cores and NUMA nodes the camera runs and keeps its frames on
+    void    ReportPlacement( ) const;
+
+    // Real-time mode: pick the shedding level for the lag of a frame
+    void    UpdateSheddingLevel( const double lagSeconds );
+
+    // Real-time mode: remember the velocity of the tracked blobs
+    void    UpdateBlobMotion( const int frameNum );
+
+    // Real-time mode: record the predicted blobs of an undecoded frame
+    void    CoastFrame( const int frameNum );
+
     // input related - camera
     int                             m_cameraId; 
     std::string                     m_videoSourceDirectory;
     std::string                     m_videoFileName;
-    cv::VideoCapture                m_videoCap;
+    std::string                     m_outputName;
+    RawFrameFormat                  m_rawFrameFormat;
+    DecoderSettings                 m_decoderSettings;
+    FrameSourcePtr                  m_pFrameSource;
+    bool                            m_frameCache;
+    bool                            m_frameCacheDownScale;
+    double                          m_sourceScale;
 
     // output related variable
     bool                            m_displayIntermediateResult;
     bool                            m_saveIntermediateResult; 
     std::string                     m_videoOutputDirectory;
-    std::ofstream*                  m_pOutputRecordFileStream;
+    RecordWriter*                   m_pRecordWriter;
     VideoWritePtr                   m_pFGAvi;
     VideoWritePtr                   m_pBTAvi;
 
@@ -87,6 +249,11 @@ namespace Tracker
     std::string                     m_blobTrackerModName;
     std::string                     m_blobAnalyzerModName;
     std::string                     m_blobPostProcModName;
+    std::string                     m_fgDetectionParams;
+    std::string                     m_blobDetectionParams;
+    std::string                     m_blobTrackerParams;
+    std::string                     m_blobAnalysisParams;
+    std::string                     m_blobPostProcessingParams;
 
     bool                            m_downScaleImage;
     bool                            m_initializied;
@@ -95,17 +262,86 @@ namespace Tracker
     int                             m_height;
     cv::Mat                         m_originalFrameMat;
     cv::Mat                         m_frame;
+    cv::Mat                         m_overlayFrame;         // own copy of a frame of the source to draw on
     cv::Mat                         m_fgMask;
-    IplImage                        m_frameIpl;
-    IplImage*                       m_pFGMaskIpl;
 
-    CvBlobTrackerAuto*              m_pTracker;
+    std::string                     m_trackingEngine;
+    TrackingEngine*                 m_pTracker;
     CvFGDetector*                   m_pFGDetector; 
     CvBlobDetector*                 m_pBlobDetector;
     CvBlobTracker *                 m_pBlobTracker;
     CvBlobTrackAnalysis*            m_pBlobTrackAnalysis;
     CvBlobTrackPostProc*            m_pBlobProcessing;
-    CvBlobTrackerAutoParam1*        m_pTrackerParams;
+
+    // motion vector assistance
+    bool                            m_motionVectorAssist;
+    int                             m_motionBlockSize;
+    int                             m_motionSearchRange;
+    MotionField*                    m_pMotionField;
+
+    // activity gating
+    bool                            m_activityGating;
+    ActivityGateSettings            m_activityGateSettings;
+    ActivityGate*                   m_pActivityGate;
+
+    // blob crop export
+    bool                            m_cropExport;
+    CropExportSettings              m_cropExportSettings;
+    CropExporter*                   m_pCropExporter;
+
+    // real-time load shedding
+    struct BlobMotion
+    {
+        cv::Point2f         m_position;
+        cv::Point2f         m_velocity;         // pixels per frame
+        int                 m_frameNum;
+    };
+
+    bool                            m_realTimeMode;
+    double                          m_lagThreshold;         // seconds
+    int                             m_maxCoastFrames;
+    double                          m_liveFrameRate;
+    double                          m_frameTimestamp;
+    int                             m_coastedFrames;        // since the last processed frame
+    std::map<int, BlobMotion>       m_blobMotion;
+    CameraStats                     m_stats;
+
+    // live metrics
+    CameraMetricsPtr                m_pMetrics;
+    int64                           m_decodeTicks;          // of the frame being processed
+
+    // memory budget
+    size_t                          m_memoryBudget;         // bytes, 0 for none
+    bool                            m_overBudgetLogged;
+    int                             m_blobFrames;           // blobs recorded by the current pipeline
+    int                             m_blobIdOffset;         // keeps the IDs unique over pipeline rebuilds
+    int                             m_maxBlobId;
+
+    // frame by frame processing
+    int                             m_startFrameIndex;
+    int                             m_endFrameIndex;
+    int                             m_frameNum;
+    int64                           m_clockStartTicks;
+    double                          m_clockStartTimestamp;
+    bool                            m_clockStarted;
+    bool                            m_framePending;         // grabbed before its capture time
+    double                          m_pendingTimestamp;
+    int64                           m_frameDueTicks;        // capture time of the pending frame
+
+    // checkpoints
+    int                             m_checkpointInterval;   // frames between checkpoints, 0 for none
+    bool                            m_resume;
+    int                             m_resumeWarmupFrames;
+    int                             m_resumeFrame;          // frames up to it only train the models, -1 for none
+    int                             m_lastCheckpointFrame;
+    bool                            m_framesEnded;          // all frames of the range are processed
+    std::vector<BlobRecord>         m_resumeTracks;         // tracks of the checkpoint, until matched
+    std::map<int, int>              m_resumedIds;           // record IDs of the tracks continued by the tracker IDs
+
+    // scheduling
+    int                             m_scheduleWeight;
+    double                          m_maxFrameRate;
+    CoreSet                         m_coreSet;
     };
 
     // declaration for shared pointer
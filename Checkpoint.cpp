@@ -0,0 +1,129 @@
+#include "Checkpoint.h"
+
+#include <fstream>
+#include <sstream>
+
+#if defined(WIN32) || defined(WIN64)
+#include <windows.h>
+#endif
+
+// first line of a checkpoint file
+#define CHECKPOINT_HEADER           "BlobTracker checkpoint 1"
+
+namespace Tracker
+{
+    /********************************************************************
+    GetCheckpointName
+        The checkpoint is stored next to the record file
+    Exceptions:
+        None
+    *********************************************************************/
+    std::string GetCheckpointName( const std::string& recordFileName )
+    {
+        return recordFileName + ".checkpoint";
+    }
+
+    /********************************************************************
+    ReadCheckpoint
+        Reads the keyed lines of a checkpoint file
+    Exceptions:
+        None
+    *********************************************************************/
+    bool ReadCheckpoint( const std::string&  fileName,
+                         CameraCheckpoint&   checkpoint )
+    {
+        std::ifstream checkpointFile( fileName.c_str() );
+        std::string line;
+        if ( !std::getline( checkpointFile, line ) || line != CHECKPOINT_HEADER )
+        {
+            return false;
+        }
+
+        checkpoint = CameraCheckpoint( );
+
+        bool hasFrame   = false;
+        bool hasOffset  = false;
+        while ( std::getline( checkpointFile, line ) )
+        {
+            std::istringstream fields( line );
+            std::string key;
+            fields >> key;
+
+            if ( key == "frame" )
+            {
+                hasFrame = !!( fields >> checkpoint.m_frameNumber );
+            }
+            else if ( key == "record_offset" )
+            {
+                hasOffset = !!( fields >> checkpoint.m_recordOffset );
+            }
+            else if ( key == "max_blob_id" )
+            {
+                fields >> checkpoint.m_maxBlobId;
+            }
+            else if ( key == "complete" )
+            {
+                int complete = 0;
+                fields >> complete;
+                checkpoint.m_complete = complete != 0;
+            }
+            else if ( key == "track" )
+            {
+                BlobRecord track;
+                track.m_frameNumber = checkpoint.m_frameNumber;
+                track.m_timestamp   = 0;
+                if ( fields >> track.m_id >> track.m_x >> track.m_y >> track.m_width >> track.m_height )
+                {
+                    checkpoint.m_tracks.push_back( track );
+                }
+            }
+        }
+
+        return hasFrame && hasOffset;
+    }
+
+    /********************************************************************
+    WriteCheckpoint
+        Writes a temporary file and renames it over the checkpoint, so
+        that an interruption leaves the previous checkpoint intact
+    Exceptions:
+        None
+    *********************************************************************/
+    bool WriteCheckpoint( const std::string&         fileName,
+                          const CameraCheckpoint&    checkpoint )
+    {
+        std::ostringstream text;
+        text << CHECKPOINT_HEADER << '\n';
+        text << "frame " << checkpoint.m_frameNumber << '\n';
+        text << "record_offset " << checkpoint.m_recordOffset << '\n';
+        text << "max_blob_id " << checkpoint.m_maxBlobId << '\n';
+        text << "complete " << ( checkpoint.m_complete ? 1 : 0 ) << '\n';
+        for ( unsigned int i = 0; i < checkpoint.m_tracks.size(); i++ )
+        {
+            const BlobRecord& track = checkpoint.m_tracks[i];
+            text << "track " << track.m_id << ' ' << track.m_x << ' ' << track.m_y << ' ' <<
+                    track.m_width << ' ' << track.m_height << '\n';
+        }
+
+        const std::string temporaryName = fileName + ".tmp";
+        const std::string content       = text.str();
+
+        FILE* pFile = fopen( temporaryName.c_str(), "wb" );
+        if ( pFile == NULL )
+        {
+            return false;
+        }
+
+        const bool written = fwrite( content.data(), content.size(), 1, pFile ) == 1;
+        if ( fclose( pFile ) != 0 || !written )
+        {
+            return false;
+        }
+
+#if defined(WIN32) || defined(WIN64)
+        return MoveFileExA( temporaryName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING ) != 0;
+#else
+        return rename( temporaryName.c_str(), fileName.c_str() ) == 0;
+#endif
+    }
+}
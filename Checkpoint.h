@@ -0,0 +1,47 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "RecordIndex.h"
+
+#include <string>
+#include <vector>
+
+namespace Tracker
+{
+    /*
+    *   Position of a camera in its video and record file, written every
+    *   few frames so that an interrupted run can continue. The models
+    *   of the modules are not part of it, a resumed camera trains them
+    *   again on the frames before the checkpoint; the tracks of the
+    *   checkpoint frame let it keep their IDs.
+    */
+    struct CameraCheckpoint
+    {
+        CameraCheckpoint( )
+            : m_frameNumber( 0 ),
+            m_recordOffset( 0 ),
+            m_maxBlobId( -1 ),
+            m_complete( false ),
+            m_tracks( )
+        {
+        }
+
+        int                         m_frameNumber;      // last frame whose records are written
+        boost::uint64_t             m_recordOffset;     // size of the record file after that frame
+        int                         m_maxBlobId;
+        bool                        m_complete;         // the camera has processed all its frames
+        std::vector<BlobRecord>     m_tracks;           // tracked blobs of the checkpoint frame
+    };
+
+    // The checkpoint is stored next to the record file
+    std::string GetCheckpointName( const std::string& recordFileName );
+
+    // Read a checkpoint, false when there is none or it is unreadable
+    bool        ReadCheckpoint( const std::string&  fileName,
+                                CameraCheckpoint&   checkpoint );
+
+    // Replace the checkpoint file by a complete new one
+    bool        WriteCheckpoint( const std::string&         fileName,
+                                 const CameraCheckpoint&    checkpoint );
+}
+#endif
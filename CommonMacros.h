@@ -2,6 +2,7 @@
 #define COMMON_MACROS_H
 
 #include "Config.h"
+#include "Logger.h"
 
 #include <iostream>
 // ABORT ERROR
@@ -12,17 +13,18 @@ static void AbortError( const int   line,
     if ( msg == NULL )
     {    
         fprintf(stderr, "%s %d: ERROR\n", file, line );
-        g_logFile << file << line << " ERROR\n";
+        LOG_MESSAGE( LOG_LEVEL_ERROR, LOG_TARGET_FILE, file << line << " ERROR" );
     }
     else
     {
         fprintf(stderr, "%s %d: ERROR: %s\n", file, line, msg );
-        g_logFile << file << line << " ERROR: " << msg << '\n';
+        LOG_MESSAGE( LOG_LEVEL_ERROR, LOG_TARGET_FILE, file << line << " ERROR: " << msg );
     }
 
-    g_logFile.flush();
+    Tracker::Logger::Instance().Flush();
 
-    exit(0);
+    // a failed run must not look like a successful one
+    exit(EXIT_FAILURE);
 }
 
 //Template function to Check if the parameter is valid
@@ -51,7 +53,7 @@ catch( std::exception& ex )                         \
 #define EXCEPTION_CATCH_AND_LOG(context)            \
 catch( std::exception& ex )                         \
 {                                                   \
-    g_logFile << "Context: " << context <<    " Error Message:"     << ex.what() << std::endl;    \
+    LOG_MESSAGE( LOG_LEVEL_ERROR, LOG_TARGET_FILE, "Context: " << context <<    " Error Message:"     << ex.what() );    \
 }
 
 //ASSERT TRUE
@@ -87,14 +89,23 @@ DISALLOW_EVIL_CONSTRUCTORS(TypeName)
 
 //LOG_FILE
 #define LOG_FILE( context )        \
-g_logFile << context << std::endl;        
+LOG_MESSAGE( LOG_LEVEL_INFO, LOG_TARGET_FILE, context )
 
 //LOG CONSOLE
 #define LOG_CONSOLE( context )    \
-std::cout << context << std::endl
+LOG_MESSAGE( LOG_LEVEL_INFO, LOG_TARGET_CONSOLE, context )
 
 // LOG Both file and Console
 #define LOG( context )         \
-LOG_FILE(context)              \
-LOG_CONSOLE(context)
+LOG_MESSAGE( LOG_LEVEL_INFO, LOG_TARGET_FILE | LOG_TARGET_CONSOLE, context )
+
+// LOG at other severities, to the file
+#define LOG_DEBUG( context )    \
+LOG_MESSAGE( LOG_LEVEL_DEBUG, LOG_TARGET_FILE, context )
+
+#define LOG_WARNING( context )  \
+LOG_MESSAGE( LOG_LEVEL_WARNING, LOG_TARGET_FILE, context )
+
+#define LOG_ERROR( context )    \
+LOG_MESSAGE( LOG_LEVEL_ERROR, LOG_TARGET_FILE | LOG_TARGET_CONSOLE, context )
 #endif
\ No newline at end of file
@@ -5,7 +5,6 @@
 #include "Config.h"
 
 InputParameters  g_configInput;
-std::ofstream    g_logFile;
 
 // Mapping_Map Syntax:
 // {NAMEinConfigFile,  &ConfigInput.VariableName,  m_type,  InitialValue,LimitType,  MinLimit,  MaxLimit}
@@ -21,6 +20,10 @@ InputMapping Map[] = {
     {"Number_Of_Frames",                &g_configInput.m_numberOfFramesToProcess,           0,        0.0,        2,            0.0,    0.0},
     {"OutPut_Video_Directory",          &g_configInput.m_outputVideoDirectory,              1,        0.0,        0,            0.0,    0.0},
     {"Log_File_Name",                   &g_configInput.m_logFileName,                       1,        0.0,        0,            0.0,    0.0},
+    {"Log_Level",                       &g_configInput.m_logLevel,                          0,        1.0,        1,            0.0,    3.0},
+    {"Metrics_Port",                    &g_configInput.m_metricsPort,                       0,        0.0,        1,            0.0,65535.0},
+    {"Metrics_File",                    &g_configInput.m_metricsFileName,                   1,        0.0,        0,            0.0,    0.0},
+    {"Metrics_Interval_MS",             &g_configInput.m_metricsIntervalMs,                 0,     1000.0,        1,          100.0,60000.0},
     {"Display_Intermediate_Result",     &g_configInput.m_displayIntermediateResult,         0,        0.0,        1,            0.0,    1.0},
     {"Save_Intermediate_Result",        &g_configInput.m_saveIntermediateResult,            0,        0.0,        1,            0.0,    1.0},
     {"Down_Scale_Image",                &g_configInput.m_downScaleImage,                    0,        0.0,        1,            0.0,    1.0},
@@ -30,17 +33,72 @@ InputMapping Map[] = {
     {"Blob_Processing_Module",          &g_configInput.m_blobProcessingMod,                 1,        0.0,        0,            0.0,    0.0},
     {"Blob_Analysis_Module",            &g_configInput.m_blobAnalysisMod,                   1,        0.0,        0,            0.0,    0.0},
     {"FG_Train_Frames",                 &g_configInput.m_numberFGTrainFrames,               0,        2.0,        2,            1.0,    0.0},
+    {"Tracking_Engine",                 &g_configInput.m_trackingEngine,                    1,        0.0,        0,            0.0,    0.0},
     {"FG_Detection_Params",             &g_configInput.m_fgDetectionParams,                 1,        0.0,        0,            0.0,    0.0},
     {"Blob_Detection_Params",           &g_configInput.m_blobDetectionParams,               1,        0.0,        0,            0.0,    0.0},
     {"Blob_Tracker_Params",             &g_configInput.m_blobTrackerParams,                 1,        0.0,        0,            0.0,    0.0},
     {"Blob_Analysis_Params",            &g_configInput.m_blobAnalysisParams,                1,        0.0,        0,            0.0,    0.0},
     {"Blob_PostProc_Params",            &g_configInput.m_blobPostProcessingParams,          1,        0.0,        0,            0.0,    0.0},
+    {"Motion_Vector_Assist",            &g_configInput.m_motionVectorAssist,                0,        0.0,        1,            0.0,    1.0},
+    {"Motion_Block_Size",               &g_configInput.m_motionBlockSize,                   0,       16.0,        1,            4.0,   64.0},
+    {"Motion_Search_Range",             &g_configInput.m_motionSearchRange,                 0,        8.0,        1,            1.0,   32.0},
+    {"Activity_Gate",                   &g_configInput.m_activityGate,                      0,        0.0,        1,            0.0,    1.0},
+    {"Activity_Gate_Threshold",         &g_configInput.m_activityGateThreshold,             0,       15.0,        1,            0.0,  255.0},
+    {"Activity_Gate_Min_Changed",       &g_configInput.m_activityGateMinChanged,            2,        0.5,        1,            0.0,  100.0},
+    {"Activity_Gate_Refresh_Frames",    &g_configInput.m_activityGateRefreshFrames,         0,       25.0,        2,            0.0,    0.0},
+    {"Raw_Frame_Width",                 &g_configInput.m_rawFrameWidth,                     0,        0.0,        2,            0.0,    0.0},
+    {"Raw_Frame_Height",                &g_configInput.m_rawFrameHeight,                    0,        0.0,        2,            0.0,    0.0},
+    {"Raw_Frame_Format",                &g_configInput.m_rawFrameFormat,                    1,        0.0,        0,            0.0,    0.0},
+    {"Video_Decoder",                   &g_configInput.m_videoDecoder,                      1,        0.0,        0,            0.0,    0.0},
+    {"Decoder_Threads",                 &g_configInput.m_decoderThreads,                    0,        0.0,        1,            0.0,   64.0},
+    {"Decoder_Thread_Type",             &g_configInput.m_decoderThreadType,                 1,        0.0,        0,            0.0,    0.0},
+    {"Decoder_Down_Scale",              &g_configInput.m_decoderDownScale,                  0,        0.0,        1,            0.0,    1.0},
+    {"Frame_Cache",                     &g_configInput.m_frameCache,                        0,        0.0,        1,            0.0,    1.0},
+    {"Frame_Cache_Down_Scale",          &g_configInput.m_frameCacheDownScale,               0,        0.0,        1,            0.0,    1.0},
+    {"Sweep_File",                      &g_configInput.m_sweepFileName,                     1,        0.0,        0,            0.0,    0.0},
+    {"Profile_File",                    &g_configInput.m_profileFileName,                   1,        0.0,        0,            0.0,    0.0},
+    {"Camera_Profiles",                 &g_configInput.m_cameraProfiles,                    1,        0.0,        0,            0.0,    0.0},
+    {"Segment_Count",                   &g_configInput.m_segmentCount,                      0,        1.0,        1,            1.0,  256.0},
+    {"Segment_Warmup_Frames",           &g_configInput.m_segmentWarmupFrames,               0,      250.0,        2,            0.0,    0.0},
+    {"Two_Pass",                        &g_configInput.m_twoPass,                           0,        0.0,        1,            0.0,    1.0},
+    {"Two_Pass_Scan_Step",              &g_configInput.m_twoPassScanStep,                   0,        5.0,        2,            1.0,    0.0},
+    {"Two_Pass_Post_Roll",              &g_configInput.m_twoPassPostRoll,                   0,       50.0,        2,            0.0,    0.0},
+    {"Crop_Export",                     &g_configInput.m_cropExport,                        0,        0.0,        1,            0.0,    1.0},
+    {"Crop_Format",                     &g_configInput.m_cropFormat,                        1,        0.0,        0,            0.0,    0.0},
+    {"Crop_Sample_Interval",            &g_configInput.m_cropSampleInterval,                0,       10.0,        2,            0.0,    0.0},
+    {"Crop_Max_Per_Frame",              &g_configInput.m_cropMaxPerFrame,                   0,       16.0,        2,            1.0,    0.0},
+    {"Crop_Buffer_Count",               &g_configInput.m_cropBufferCount,                   0,      256.0,        2,            1.0,    0.0},
+    {"Crop_Worker_Threads",             &g_configInput.m_cropWorkerThreads,                 0,        2.0,        1,            1.0,   64.0},
+    {"Crop_Archive_Size",               &g_configInput.m_cropArchiveSize,                   0,     1000.0,        2,            1.0,    0.0},
+    {"Real_Time_Mode",                  &g_configInput.m_realTimeMode,                      0,        0.0,        1,            0.0,    1.0},
+    {"Real_Time_Lag_Threshold",         &g_configInput.m_realTimeLagThreshold,              0,      200.0,        2,            1.0,    0.0},
+    {"Real_Time_Max_Coast_Frames",      &g_configInput.m_realTimeMaxCoastFrames,            0,        4.0,        2,            0.0,    0.0},
+    {"Live_Frame_Rate",                 &g_configInput.m_liveFrameRate,                     2,       25.0,        2,            1.0,    0.0},
+    {"Scheduler_Threads",               &g_configInput.m_schedulerThreads,                  0,        0.0,        1,            0.0,  256.0},
+    {"Schedule_Weight",                 &g_configInput.m_scheduleWeight,                    0,        1.0,        1,            1.0, 1000.0},
+    {"Max_Frame_Rate",                  &g_configInput.m_maxFrameRate,                      2,        0.0,        2,            0.0,    0.0},
+    {"Core_Set",                        &g_configInput.m_coreSet,                           1,        0.0,        0,            0.0,    0.0},
+    {"Memory_Budget_MB",                &g_configInput.m_memoryBudgetMB,                    0,        0.0,        2,            0.0,    0.0},
+    {"Job_Manifest",                    &g_configInput.m_jobManifest,                       1,        0.0,        0,            0.0,    0.0},
+    {"Job_Max_Active_Cameras",          &g_configInput.m_jobMaxActiveCameras,               0,        0.0,        2,            0.0,    0.0},
+    {"Coordinator_Workers",             &g_configInput.m_coordinatorWorkers,                0,        0.0,        1,            0.0,  256.0},
+    {"Coordinator_Max_Retries",         &g_configInput.m_coordinatorMaxRetries,             0,        1.0,        2,            0.0,    0.0},
+    {"Checkpoint_Interval",             &g_configInput.m_checkpointInterval,                0,        0.0,        2,            0.0,    0.0},
+    {"Resume",                          &g_configInput.m_resume,                            0,        0.0,        1,            0.0,    1.0},
+    {"Resume_Warmup_Frames",            &g_configInput.m_resumeWarmupFrames,                0,      250.0,        2,            1.0,    0.0},
+    {"Regression_Min_MOTA",             &g_configInput.m_regressionMinMota,                 2,       0.99,        1,            0.0,    1.0},
+    {"Regression_Max_Position_Error",   &g_configInput.m_regressionMaxPositionError,        2,        1.0,        2,            0.0,    0.0},
+    {"Regression_Fps_Tolerance",        &g_configInput.m_regressionFpsTolerance,            0,       20.0,        1,            0.0,  100.0},
+    {"Regression_Memory_Tolerance",     &g_configInput.m_regressionMemoryTolerance,         0,       10.0,        2,            0.0,    0.0},
     {NULL,                              NULL,                                              -1,        0.0,        0,            0.0,    0.0}
 };
 
 static void Usage(void)
 {
      fprintf( stderr, "\n   BlobTracker [-h] or BlobTracker -d config.cfg [-p xxx=xxx xxxx=xxxx]");
+     fprintf( stderr, "\n   BlobTracker -q record.txt [id=N] [frames=first:last] [box=x,y,width,height]");
+     fprintf( stderr, "\n   BlobTracker -r suite.txt [update] -d config.cfg [-p xxx=xxx xxxx=xxxx]");
+     fprintf( stderr, "\n   BlobTracker -j \"<job line>\" -d config.cfg [-p xxx=xxx xxxx=xxxx]");
 }
 
  /***********************************************************************
@@ -384,6 +442,46 @@ static char* getNumber(char* src, char* bufEnd, double* data)
  *    0: success
  *    non-zero: fail
  */
+/*!
+ ***********************************************************************
+ * \brief
+ *    Apply config file style settings on top of a parameter set.
+ *    Map[] points into g_configInput, so the settings are parsed there
+ *    and g_configInput is restored afterwards.
+ * \param pContent
+ *    settings in the config file syntax
+ * \param pParams
+ *    parameters to be updated
+ * \return
+ *    0: success
+ *    non-zero: fail
+ ***********************************************************************
+ */
+int ParseConfigOverride (const char* pContent, InputParameters* pParams)
+{
+  InputParameters savedInput;
+  char* content;
+  int result;
+
+  if ((content = (char*) malloc (strlen (pContent) + 1)) == NULL)
+  {
+    printf("Mem error, ParseConfigOverride: content");
+    return -1;
+  }
+  strcpy (content, pContent);
+
+  memcpy (&savedInput, &g_configInput, sizeof (InputParameters));
+  memcpy (&g_configInput, pParams, sizeof (InputParameters));
+
+  result = ParseContent (content, (int) strlen (content));
+
+  memcpy (pParams, &g_configInput, sizeof (InputParameters));
+  memcpy (&g_configInput, &savedInput, sizeof (InputParameters));
+
+  free (content);
+  return result;
+}
+
 int CheckParams()
 {
 
@@ -41,6 +41,7 @@ typedef struct
     //general setting
     int        m_downScaleImage;                           //should downscale image?
     int        m_numberFGTrainFrames;                      //number of frames for foreground training
+    char       m_trackingEngine[STRING_SIZE];              //Native or Legacy tracking pipeline
     char       m_fgDetectorMod[STRING_SIZE];               //FG detection Module
     char       m_blobDetectorMod[STRING_SIZE];             //blob detection module
     char       m_blobTrackerMod[STRING_SIZE];              //blob tracker module
@@ -52,6 +53,93 @@ typedef struct
     char       m_blobAnalysisParams[STRING_SIZE];          //blob analysis params
     char       m_blobPostProcessingParams[STRING_SIZE];    //blob post processing params
     char       m_logFileName[STRING_SIZE];                 //name of the log file
+    int        m_logLevel;                                 //0: debug, 1: info, 2: warning, 3: error
+
+    //live metrics
+    int        m_metricsPort;                              //localhost port serving the metrics, 0 for none
+    char       m_metricsFileName[STRING_SIZE];             //file in the output folder rewritten with the metrics, empty for none
+    int        m_metricsIntervalMs;                        //interval at which the metrics are sampled
+
+    //motion vector assistance
+    int        m_motionVectorAssist;                       //seed tracking with macroblock motion
+    int        m_motionBlockSize;                          //macroblock size in pixels
+    int        m_motionSearchRange;                        //motion search range in pixels
+
+    //activity gating
+    int        m_activityGate;                             //skip the pipeline on static frames without tracks
+    int        m_activityGateThreshold;                    //gray level difference of a changed pixel
+    double     m_activityGateMinChanged;                   //percent of changed pixels of an active frame
+    int        m_activityGateRefreshFrames;                //idle frames between background updates
+
+    //stream input
+    int        m_rawFrameWidth;                            //width of raw input frames
+    int        m_rawFrameHeight;                           //height of raw input frames
+    char       m_rawFrameFormat[STRING_SIZE];              //pixel format of raw input frames
+
+    //video file decoding
+    char       m_videoDecoder[STRING_SIZE];                //OpenCV or FFmpeg
+    int        m_decoderThreads;                           //FFmpeg decoder threads, 0 for one per core
+    char       m_decoderThreadType[STRING_SIZE];           //frame, slice or frame+slice threading
+    int        m_decoderDownScale;                         //decode at half resolution with Down_Scale_Image
+
+    //decoded frame cache
+    int        m_frameCache;                               //cache decoded frames next to the output
+    int        m_frameCacheDownScale;                      //cache frames at the downscaled resolution
+
+    //parameter sweep
+    char       m_sweepFileName[STRING_SIZE];               //file listing the parameter variants of a sweep
+
+    //per-camera pipeline profiles
+    char       m_profileFileName[STRING_SIZE];             //file defining named pipeline profiles
+    char       m_cameraProfiles[STRING_SIZE];              //camera ID to profile name assignments
+
+    //time sharded processing
+    int        m_segmentCount;                             //number of time segments processed in parallel
+    int        m_segmentWarmupFrames;                      //frames processed before each segment to train the models
+    int        m_twoPass;                                  //track only the active intervals found by a scan
+    int        m_twoPassScanStep;                          //frames between the frames compared by the scan
+    int        m_twoPassPostRoll;                          //frames tracked after the last activity of an interval
+
+    //blob crop export
+    int        m_cropExport;                               //export crops of the tracked blobs
+    char       m_cropFormat[STRING_SIZE];                  //image format of the crops, jpg or png
+    int        m_cropSampleInterval;                       //export every Nth crop of a track, 0 for the largest one
+    int        m_cropMaxPerFrame;                          //crops taken from one frame at most
+    int        m_cropBufferCount;                          //crops waiting for the encoders at most
+    int        m_cropWorkerThreads;                        //number of crop encoder threads
+    int        m_cropArchiveSize;                          //crops per archive file
+
+    //real-time load shedding
+    int        m_realTimeMode;                             //process frames against their capture time
+    int        m_realTimeLagThreshold;                     //lag in milliseconds at which work is shed
+    int        m_realTimeMaxCoastFrames;                   //frames dropped at most between processed frames
+    double     m_liveFrameRate;                            //frame rate of sources without timestamps
+
+    //camera scheduling
+    int        m_schedulerThreads;                         //worker threads shared by the cameras, 0 for one camera at a time
+    int        m_scheduleWeight;                           //share of the workers relative to other cameras
+    double     m_maxFrameRate;                             //frames per second processed at most, 0 for no cap
+    char       m_coreSet[STRING_SIZE];                     //cores the camera threads run on, empty for all
+
+    //memory budget
+    int        m_memoryBudgetMB;                           //memory a camera may use before it degrades, 0 for no budget
+
+    //job manifest
+    char       m_jobManifest[STRING_SIZE];                 //file listing the jobs, one per line, instead of the video list
+    int        m_jobMaxActiveCameras;                      //jobs the scheduler keeps open at once, 0 for twice the workers
+    int        m_coordinatorWorkers;                       //worker processes running the jobs, 0 to run them in this process
+    int        m_coordinatorMaxRetries;                    //reruns of a failed job before it is quarantined
+
+    //checkpoints
+    int        m_checkpointInterval;                       //frames between checkpoints of a camera, 0 for none
+    int        m_resume;                                   //continue each camera after its checkpoint
+    int        m_resumeWarmupFrames;                       //frames before the checkpoint processed again to train the models
+
+    //regression suite gates
+    double     m_regressionMinMota;                        //lowest MOTA against the golden records
+    double     m_regressionMaxPositionError;               //largest mean position error against the golden records in pixels
+    int        m_regressionFpsTolerance;                   //percent the frame rate may drop below the baseline
+    int        m_regressionMemoryTolerance;                //percent the peak memory may rise above the baseline
 } InputParameters;
 
 //InputMapping
@@ -67,11 +155,13 @@ typedef struct
 } InputMapping;
 
 // define the global constants
-extern std::ofstream        g_logFile;
 extern InputParameters      g_configInput;
 extern InputMapping         Map[];
 
 // configures the input parameters by reading from the .cfg file
 int  Configure ( int ac, char *av[] );
 
+// applies "Name = value" settings on top of the given parameters
+int  ParseConfigOverride ( const char* pContent, InputParameters* pParams );
+
 #endif
\ No newline at end of file
@@ -0,0 +1,410 @@
+#include "Coordinator.h"
+
+#include <fstream>
+#include <sstream>
+#include <errno.h>
+
+#if !defined(WIN32) && !defined(WIN64)
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// file in the output directory listing the quarantined jobs
+#define QUARANTINE_FILE_NAME        "quarantine_jobs.txt"
+
+// suffix of the log file of a job after its output name
+#define JOB_LOG_SUFFIX              "_job.log"
+
+// log line of a worker carrying the statistics of its job
+#define JOB_STATS_TAG               "Job statistics:"
+
+// exit code of a worker that could not run the executable
+#define WORKER_EXEC_FAILED          127
+
+namespace Tracker
+{
+    /********************************************************************
+    GetJobLogFileName
+        Log file of a job, named after its outputs
+    Exceptions:
+        None
+    *********************************************************************/
+    static std::string GetJobLogFileName( const std::string&  outputDirectory,
+                                          const CameraJob&    job )
+    {
+        return outputDirectory + "/" + job.m_outputName + JOB_LOG_SUFFIX;
+    }
+
+    /********************************************************************
+    GetSeconds
+        Seconds of the tick counter
+    Exceptions:
+        None
+    *********************************************************************/
+    static double GetSeconds( )
+    {
+        return cv::getTickCount() / cv::getTickFrequency();
+    }
+
+    /********************************************************************
+    Constructor for class JobCoordinator
+    *********************************************************************/
+    JobCoordinator::JobCoordinator( const std::string&                executable,
+                                    const std::vector<std::string>&   workerArguments )
+        : m_executable( executable ),
+        m_workerArguments( workerArguments ),
+        m_workerCount( 1 ),
+        m_maxRetries( 0 ),
+        m_outputDirectory( ),
+        m_pManifest( NULL ),
+        m_pendingJobs( ),
+        m_runningJobs( ),
+        m_startSeconds( 0 ),
+        m_jobsDone( 0 ),
+        m_jobsRetried( 0 ),
+        m_jobsQuarantined( 0 ),
+        m_workersStarted( 0 ),
+        m_framesProcessed( 0 ),
+        m_framesIdle( 0 ),
+        m_framesDropped( 0 )
+    {
+    }
+
+    /********************************************************************
+    Destructor for class JobCoordinator
+    *********************************************************************/
+    JobCoordinator::~JobCoordinator( )
+    {
+        delete m_pManifest;
+    }
+
+    /*************************************************************************
+    Initialize
+        Open the job manifest, or turn the video and camera ID lists into
+        jobs
+    Exceptions
+        None
+    *************************************************************************/
+    void JobCoordinator::Initialize( const InputParameters&  settings,
+                                     const int               startFrameIndex,
+                                     const int               endFrameIndex )
+    {
+        m_workerCount       = std::max( 1, settings.m_coordinatorWorkers );
+        m_maxRetries        = settings.m_coordinatorMaxRetries;
+        m_outputDirectory   = settings.m_outputVideoDirectory;
+
+        m_pManifest = new JobManifest( settings.m_inputVideoDirectory, startFrameIndex, endFrameIndex );
+
+        if ( settings.m_jobManifest[0] != '\0' )
+        {
+            m_pManifest->Open( settings.m_jobManifest );
+            return;
+        }
+
+        // the lists are short, their jobs are queued at once
+        std::istringstream videoNames( settings.m_inputVideoListCStr );
+        std::istringstream cameraIds( settings.m_inputVideoCameraIDListCStr );
+        std::string videoName;
+        std::string cameraId;
+        while ( std::getline( videoNames, videoName, ',' ) )
+        {
+            ASSERT_TRUE( std::getline( cameraIds, cameraId, ',' ) );
+
+            WorkerJob workerJob;
+            m_pManifest->ParseJob( "\"" + videoName + "\" " + cameraId, workerJob.m_job );
+            workerJob.m_job.m_lineNumber    = (int)m_pendingJobs.size() + 1;
+            workerJob.m_attempts            = 0;
+            workerJob.m_startSeconds        = 0;
+            m_pendingJobs.push_back( workerJob );
+        }
+
+        delete m_pManifest;
+        m_pManifest = NULL;
+    }
+
+    /*************************************************************************
+    Run
+        Keep the workers busy until every job has succeeded or is
+        quarantined
+    Exceptions
+        None
+    *************************************************************************/
+    int JobCoordinator::Run( )
+    {
+#if defined(WIN32) || defined(WIN64)
+        AbortError( __LINE__, __FILE__, "Coordinator_Workers needs fork, which this platform does not have" );
+        return 0;
+#else
+        LOG( "Running the jobs on " << m_workerCount << " worker processes" );
+        m_startSeconds = GetSeconds();
+
+        for ( ;; )
+        {
+            WorkerJob workerJob;
+            while ( (int)m_runningJobs.size() < m_workerCount && NextJob( workerJob ) )
+            {
+                StartWorker( workerJob );
+            }
+
+            if ( m_runningJobs.empty() )
+            {
+                break;
+            }
+
+            int status;
+            const pid_t pid = waitpid( -1, &status, 0 );
+            if ( pid < 0 )
+            {
+                if ( errno == EINTR )
+                {
+                    continue;
+                }
+                AbortError( __LINE__, __FILE__, "Unable to wait for the worker processes" );
+            }
+
+            std::map<int, WorkerJob>::iterator jobIt = m_runningJobs.find( (int)pid );
+            if ( jobIt == m_runningJobs.end() )
+            {
+                continue;
+            }
+
+            workerJob = jobIt->second;
+            m_runningJobs.erase( jobIt );
+
+            CollectWorker( workerJob, status );
+        }
+
+        const double elapsedSeconds = GetSeconds() - m_startSeconds;
+        LOG( "Ran " << m_jobsDone << " jobs in " << elapsedSeconds << " s on " << m_workersStarted << " worker processes, " <<
+             m_jobsRetried << " retries, " << m_jobsQuarantined << " jobs quarantined" );
+        LOG( "Processed " << m_framesProcessed << " frames, " << m_framesIdle << " idle, " << m_framesDropped << " dropped, " <<
+             ( elapsedSeconds > 0 ? ( m_framesProcessed + m_framesIdle ) / elapsedSeconds : 0.0 ) << " frames/s" );
+
+        if ( m_jobsQuarantined > 0 )
+        {
+            LOG_ERROR( m_jobsQuarantined << " jobs failed, see " << m_outputDirectory << "/" << QUARANTINE_FILE_NAME );
+        }
+
+        return m_jobsQuarantined;
+#endif
+    }
+
+    /*************************************************************************
+    NextJob
+        Retries and the jobs of the video list come first, then the next
+        line of the manifest
+    Exceptions
+        None
+    *************************************************************************/
+    bool JobCoordinator::NextJob( WorkerJob& workerJob )
+    {
+        if ( !m_pendingJobs.empty() )
+        {
+            workerJob = m_pendingJobs.front();
+            m_pendingJobs.pop_front();
+            return true;
+        }
+
+        if ( m_pManifest != NULL && m_pManifest->NextJob( workerJob.m_job ) )
+        {
+            workerJob.m_attempts        = 0;
+            workerJob.m_startSeconds    = 0;
+            return true;
+        }
+
+        return false;
+    }
+
+    /*************************************************************************
+    StartWorker
+        Run the executable in job mode in a new process. The arguments
+        are prepared before the fork, the child only redirects its
+        console output and replaces itself.
+    Exceptions
+        None
+    *************************************************************************/
+    void JobCoordinator::StartWorker( WorkerJob& workerJob )
+    {
+#if !defined(WIN32) && !defined(WIN64)
+        std::vector<std::string> arguments;
+        arguments.push_back( m_executable );
+        arguments.push_back( "-j" );
+        arguments.push_back( workerJob.m_job.m_line );
+        arguments.insert( arguments.end(), m_workerArguments.begin(), m_workerArguments.end() );
+
+        std::vector<char*> argv;
+        for ( unsigned int i = 0; i < arguments.size(); i++ )
+        {
+            argv.push_back( const_cast<char*>( arguments[i].c_str() ) );
+        }
+        argv.push_back( NULL );
+
+        // flush so that the child does not repeat buffered output
+        fflush( stdout );
+        fflush( stderr );
+
+        const pid_t pid = fork();
+        if ( pid < 0 )
+        {
+            AbortError( __LINE__, __FILE__, "Unable to start a worker process" );
+        }
+
+        if ( pid == 0 )
+        {
+            const int nullFile = open( "/dev/null", O_WRONLY );
+            if ( nullFile >= 0 )
+            {
+                dup2( nullFile, STDOUT_FILENO );
+                close( nullFile );
+            }
+
+            execvp( argv[0], &argv[0] );
+            _exit( WORKER_EXEC_FAILED );
+        }
+
+        workerJob.m_attempts++;
+        workerJob.m_startSeconds = GetSeconds();
+        m_runningJobs[(int)pid] = workerJob;
+        m_workersStarted++;
+
+        LOG_FILE( "Job " << workerJob.m_job.m_lineNumber << " started in process " << pid << ": " << workerJob.m_job.m_line );
+#endif
+    }
+
+    /*************************************************************************
+    CollectWorker
+        Read the log of the job for its statistics and errors, then
+        retry or quarantine a failed job
+    Exceptions
+        None
+    *************************************************************************/
+    void JobCoordinator::CollectWorker( WorkerJob&  workerJob,
+                                        const int   status )
+    {
+#if !defined(WIN32) && !defined(WIN64)
+        const CameraJob& job = workerJob.m_job;
+        const double seconds = GetSeconds() - workerJob.m_startSeconds;
+
+        std::ostringstream reason;
+        if ( WIFEXITED( status ) && WEXITSTATUS( status ) == WORKER_EXEC_FAILED )
+        {
+            reason << "unable to run " << m_executable;
+        }
+        else if ( WIFEXITED( status ) && WEXITSTATUS( status ) != 0 )
+        {
+            reason << "exit code " << WEXITSTATUS( status );
+        }
+        else if ( WIFSIGNALED( status ) )
+        {
+            reason << "signal " << WTERMSIG( status );
+        }
+        const bool failed = !reason.str().empty();
+
+        // statistics and errors of the job log
+        const std::string logFileName = GetJobLogFileName( m_outputDirectory, job );
+        std::ifstream logFile( logFileName.c_str() );
+        std::string line;
+        long long framesProcessed   = 0;
+        long long framesIdle        = 0;
+        long long framesDropped     = 0;
+        while ( std::getline( logFile, line ) )
+        {
+            const size_t statsStart = line.find( JOB_STATS_TAG );
+            if ( statsStart != std::string::npos )
+            {
+                sscanf( line.c_str() + statsStart + strlen( JOB_STATS_TAG ), "%lld %lld %lld",
+                        &framesProcessed, &framesIdle, &framesDropped );
+            }
+            else if ( failed && line.find( "ERROR" ) != std::string::npos )
+            {
+                LOG_FILE( "Job " << job.m_lineNumber << ": " << line );
+            }
+        }
+
+        if ( !failed )
+        {
+            m_jobsDone++;
+            m_framesProcessed   += framesProcessed;
+            m_framesIdle        += framesIdle;
+            m_framesDropped     += framesDropped;
+
+            LOG_FILE( "Job " << job.m_lineNumber << " done in " << seconds << " s: " << framesProcessed << " frames, " <<
+                      framesIdle << " idle, " << framesDropped << " dropped" );
+            return;
+        }
+
+        LOG_ERROR( "Job " << job.m_lineNumber << " failed after " << seconds << " s with " << reason.str() << ": " << job.m_line );
+
+        if ( workerJob.m_attempts <= m_maxRetries )
+        {
+            m_jobsRetried++;
+            m_pendingJobs.push_front( workerJob );
+            return;
+        }
+
+        Quarantine( workerJob, reason.str() );
+#endif
+    }
+
+    /*************************************************************************
+    Quarantine
+        Append the job to the quarantine file, so that the failed jobs
+        can be rerun as a manifest once their inputs are fixed
+    Exceptions
+        None
+    *************************************************************************/
+    void JobCoordinator::Quarantine( const WorkerJob&       workerJob,
+                                     const std::string&     reason )
+    {
+        m_jobsQuarantined++;
+
+        const std::string fileName = m_outputDirectory + "/" + QUARANTINE_FILE_NAME;
+        std::ofstream quarantineFile( fileName.c_str(), std::ios::app );
+        if ( !quarantineFile.is_open() )
+        {
+            LOG_ERROR( "Unable to write " << fileName );
+            return;
+        }
+
+        quarantineFile << "# failed " << workerJob.m_attempts << " times, last with " << reason << '\n';
+        quarantineFile << workerJob.m_job.m_line << '\n';
+
+        LOG_ERROR( "Job " << workerJob.m_job.m_lineNumber << " quarantined after " << workerJob.m_attempts << " attempts" );
+    }
+
+    /*************************************************************************
+    RunWorkerJob
+        Process the camera of one job into its own log file
+    Exceptions
+        None
+    *************************************************************************/
+    int RunWorkerJob( const std::string&        jobLine,
+                      const InputParameters&    settings,
+                      const int                 startFrameIndex,
+                      const int                 endFrameIndex )
+    {
+        JobManifest manifest( settings.m_inputVideoDirectory, startFrameIndex, endFrameIndex );
+
+        CameraJob job;
+        manifest.ParseJob( jobLine, job );
+
+        Logger::Instance().Open( GetJobLogFileName( settings.m_outputVideoDirectory, job ) );
+        Logger::Instance().SetLevel( settings.m_logLevel );
+
+        PipelineProfiles profiles( settings );
+        profiles.Load( settings.m_profileFileName, settings.m_cameraProfiles );
+
+        // a worker has no console to show windows on
+        CameraPtr pCamera = CreateJobCamera( job, profiles, true );
+        pCamera->Initialize( );
+        pCamera->Process( job.m_startFrameIndex, job.m_endFrameIndex );
+
+        const CameraStats& stats = pCamera->GetStats();
+        LOG_FILE( JOB_STATS_TAG << ' ' << stats.m_framesProcessed << ' ' << stats.m_framesIdle << ' ' << stats.m_framesDropped );
+
+        Logger::Instance().Close();
+        return 0;
+    }
+}
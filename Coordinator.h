@@ -0,0 +1,96 @@
+#ifndef COORDINATOR_H
+#define COORDINATOR_H
+
+#include "JobManifest.h"
+
+#include <boost/cstdint.hpp>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Tracker
+{
+    /*
+    *   Runs the jobs of a batch in worker processes, one job per worker
+    *   at a time, so that an input crashing or aborting its process only
+    *   fails its own job. A worker runs this executable in job mode with
+    *   the arguments of the coordinator. A failed job is rerun up to
+    *   m_coordinatorMaxRetries times and then quarantined: its line is
+    *   written to the quarantine file, which is a job manifest of its own.
+    *   Each job logs into its own file; the coordinator log gets the
+    *   result, statistics and errors of every job and the batch totals.
+    */
+    class JobCoordinator
+    {
+    public:
+    // Constructor; workerArguments configure the workers, e.g. -d config.cfg
+    JobCoordinator( const std::string&                executable,
+                    const std::vector<std::string>&   workerArguments );
+
+    // Destructor
+    ~JobCoordinator( );
+
+    // Read the jobs from the manifest, or from the video and camera ID lists
+    void Initialize( const InputParameters&  settings,
+                     const int               startFrameIndex,
+                     const int               endFrameIndex );
+
+    // Run all jobs, returns the number of quarantined jobs
+    int  Run( );
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( JobCoordinator );
+
+    // Job waiting for or running in a worker
+    struct WorkerJob
+    {
+        CameraJob           m_job;
+        int                 m_attempts;
+        double              m_startSeconds;
+    };
+
+    // The next job to run, retries first
+    bool NextJob( WorkerJob& workerJob );
+
+    // Start a worker process on the job
+    void StartWorker( WorkerJob& workerJob );
+
+    // Account the result of an exited worker and retry or quarantine a failed job
+    void CollectWorker( WorkerJob&  workerJob,
+                        const int   status );
+
+    // Record a job that failed too often
+    void Quarantine( const WorkerJob&       workerJob,
+                     const std::string&     reason );
+
+    std::string                         m_executable;
+    std::vector<std::string>            m_workerArguments;
+    int                                 m_workerCount;
+    int                                 m_maxRetries;
+    std::string                         m_outputDirectory;
+    JobManifest*                        m_pManifest;        // NULL for the video list
+    std::deque<WorkerJob>               m_pendingJobs;      // retries and the jobs of the video list
+    std::map<int, WorkerJob>            m_runningJobs;      // by process ID
+    double                              m_startSeconds;
+
+    // totals of the batch
+    int                                 m_jobsDone;
+    int                                 m_jobsRetried;
+    int                                 m_jobsQuarantined;
+    int                                 m_workersStarted;
+    boost::int64_t                      m_framesProcessed;
+    boost::int64_t                      m_framesIdle;
+    boost::int64_t                      m_framesDropped;
+    };
+
+    // Run one job of a coordinator in this process and log its statistics,
+    // returns the exit code of the worker
+    int RunWorkerJob( const std::string&        jobLine,
+                      const InputParameters&    settings,
+                      const int                 startFrameIndex,
+                      const int                 endFrameIndex );
+}
+#endif
@@ -0,0 +1,414 @@
+#include "CropExporter.h"
+
+#include <boost/bind.hpp>
+
+#include <string.h>
+#include <time.h>
+
+// size of a tar header and of the blocks of an archive
+#define TAR_BLOCK_SIZE      512
+
+namespace Tracker
+{
+    /********************************************************************
+    CropExporter
+        Starts the encoder threads
+    Exceptions:
+        None
+    *********************************************************************/
+    CropExporter::CropExporter( const std::string&           archiveBaseName,
+                                const CropExportSettings&    settings )
+        : m_archiveBaseName( archiveBaseName ),
+        m_settings( settings ),
+        m_tracks( ),
+        m_cropsInFrame( 0 ),
+        m_closed( false ),
+        m_queue( ),
+        m_queueDepth( 0 ),
+        m_freeBuffers( ),
+        m_allocatedBuffers( 0 ),
+        m_bufferBytes( 0 ),
+        m_stopping( false ),
+        m_droppedCrops( 0 ),
+        m_pArchive( NULL ),
+        m_archiveIndex( 0 ),
+        m_archiveEntries( 0 ),
+        m_exportedCrops( 0 )
+    {
+        try
+        {
+            for ( int i = 0; i < std::max( 1, m_settings.m_workerThreads ); i++ )
+            {
+                m_workers.create_thread( boost::bind( &CropExporter::WorkerLoop, this ) );
+            }
+        }
+        EXCEPTION_CATCH_AND_ABORT( "Failed to start the crop encoders" );
+    }
+
+    /********************************************************************
+    Default Destructor for class CropExporter
+    *********************************************************************/
+    CropExporter::~CropExporter( )
+    {
+        try
+        {
+            Close( );
+        }
+        EXCEPTION_CATCH_AND_LOG( "Failed to close the crop exporter" );
+    }
+
+    /********************************************************************
+    CopyCrop
+        Copies the crop into a pooled buffer, fails when the pool is empty
+    Exceptions:
+        None
+    *********************************************************************/
+    bool CropExporter::CopyCrop( const cv::Mat& crop, CropJob& job )
+    {
+        if ( job.m_buffer.empty() )
+        {
+            boost::mutex::scoped_lock lock( m_queueMutex );
+
+            if ( !m_freeBuffers.empty() )
+            {
+                job.m_buffer = m_freeBuffers.back();
+                m_freeBuffers.pop_back();
+            }
+            else if ( m_allocatedBuffers < m_settings.m_bufferCount )
+            {
+                m_allocatedBuffers++;
+            }
+            else
+            {
+                m_droppedCrops++;
+                return false;
+            }
+        }
+
+        // grow the buffer only when the crop does not fit
+        const size_t cropSize = crop.total() * crop.elemSize();
+        if ( job.m_buffer.empty() || (size_t)job.m_buffer.cols < cropSize )
+        {
+            const size_t previousSize = job.m_buffer.empty() ? 0 : (size_t)job.m_buffer.cols;
+            job.m_buffer.create( 1, (int)cropSize, CV_8UC1 );
+
+            boost::mutex::scoped_lock lock( m_queueMutex );
+            m_bufferBytes += cropSize - previousSize;
+        }
+
+        job.m_pixels = cv::Mat( crop.rows, crop.cols, crop.type(), job.m_buffer.data );
+        crop.copyTo( job.m_pixels );
+        return true;
+    }
+
+    /********************************************************************
+    GetBufferBytes
+        Bytes of the pooled crop buffers, whether free or in use
+    Exceptions:
+        None
+    *********************************************************************/
+    size_t CropExporter::GetBufferBytes( )
+    {
+        boost::mutex::scoped_lock lock( m_queueMutex );
+        return m_bufferBytes;
+    }
+
+    /********************************************************************
+    ReleaseBuffer
+        Returns the buffer of a job to the pool
+    Exceptions:
+        None
+    *********************************************************************/
+    void CropExporter::ReleaseBuffer( CropJob& job )
+    {
+        job.m_pixels.release();
+
+        if ( !job.m_buffer.empty() )
+        {
+            boost::mutex::scoped_lock lock( m_queueMutex );
+            m_freeBuffers.push_back( job.m_buffer );
+        }
+        job.m_buffer.release();
+    }
+
+    /********************************************************************
+    Enqueue
+        Hands a job to the workers; its buffer now belongs to the queue
+    Exceptions:
+        None
+    *********************************************************************/
+    void CropExporter::Enqueue( CropJob& job )
+    {
+        {
+            boost::mutex::scoped_lock lock( m_queueMutex );
+            m_queue.push_back( job );
+            m_queueDepth.store( (int)m_queue.size(), boost::memory_order_relaxed );
+        }
+        m_queueCondition.notify_one();
+
+        job.m_buffer.release();
+        job.m_pixels.release();
+    }
+
+    /********************************************************************
+    AddCrop
+        Samples the crop of a tracked blob. Every Nth crop of a track is
+        queued, or the largest crop is kept until the track ends.
+    Exceptions:
+        None
+    *********************************************************************/
+    void CropExporter::AddCrop( const cv::Mat&   frame,
+                                const cv::Rect&  region,
+                                const int        blobId,
+                                const int        frameNum )
+    {
+        ASSERT_TRUE( !m_closed );
+
+        const cv::Rect clippedRegion = region & cv::Rect( 0, 0, frame.cols, frame.rows );
+        if ( clippedRegion.area() <= 0 || m_cropsInFrame >= m_settings.m_maxCropsPerFrame )
+        {
+            return;
+        }
+
+        std::map<int, TrackState>::iterator trackIt = m_tracks.find( blobId );
+        if ( trackIt == m_tracks.end() )
+        {
+            TrackState track;
+            track.m_cropCount   = 0;
+            track.m_lastFrame   = frameNum;
+            track.m_bestArea    = 0;
+            trackIt = m_tracks.insert( std::make_pair( blobId, track ) ).first;
+        }
+
+        TrackState& track = trackIt->second;
+        track.m_lastFrame = frameNum;
+
+        if ( m_settings.m_sampleInterval > 0 )
+        {
+            if ( track.m_cropCount++ % m_settings.m_sampleInterval == 0 )
+            {
+                CropJob job;
+                job.m_blobId    = blobId;
+                job.m_frameNum  = frameNum;
+                if ( CopyCrop( frame( clippedRegion ), job ) )
+                {
+                    Enqueue( job );
+                    m_cropsInFrame++;
+                }
+            }
+        }
+        else if ( clippedRegion.area() > track.m_bestArea )
+        {
+            // the largest crop shows the least truncated view of the object
+            track.m_best.m_blobId   = blobId;
+            track.m_best.m_frameNum = frameNum;
+            if ( CopyCrop( frame( clippedRegion ), track.m_best ) )
+            {
+                track.m_bestArea = clippedRegion.area();
+                m_cropsInFrame++;
+            }
+        }
+    }
+
+    /********************************************************************
+    EndFrame
+        Queues the best crops of tracks that were not seen in the frame
+    Exceptions:
+        None
+    *********************************************************************/
+    void CropExporter::EndFrame( const int frameNum )
+    {
+        m_cropsInFrame = 0;
+
+        std::map<int, TrackState>::iterator trackIt = m_tracks.begin();
+        while ( trackIt != m_tracks.end() )
+        {
+            if ( trackIt->second.m_lastFrame < frameNum )
+            {
+                if ( !trackIt->second.m_best.m_pixels.empty() )
+                {
+                    Enqueue( trackIt->second.m_best );
+                }
+                m_tracks.erase( trackIt++ );
+            }
+            else
+            {
+                ++trackIt;
+            }
+        }
+    }
+
+    /********************************************************************
+    Close
+        Exports the remaining crops and waits for the workers
+    Exceptions:
+        None
+    *********************************************************************/
+    void CropExporter::Close( )
+    {
+        if ( m_closed )
+        {
+            return;
+        }
+        m_closed = true;
+
+        for ( std::map<int, TrackState>::iterator it = m_tracks.begin(); it != m_tracks.end(); ++it )
+        {
+            if ( !it->second.m_best.m_pixels.empty() )
+            {
+                Enqueue( it->second.m_best );
+            }
+        }
+        m_tracks.clear();
+
+        {
+            boost::mutex::scoped_lock lock( m_queueMutex );
+            m_stopping = true;
+        }
+        m_queueCondition.notify_all();
+        m_workers.join_all();
+
+        CloseArchive( );
+
+        LOG_FILE( "Exported " << m_exportedCrops << " crops to " << m_archiveBaseName <<
+            "_crops_*.tar, dropped " << m_droppedCrops );
+    }
+
+    /********************************************************************
+    WorkerLoop
+        Encodes queued crops until the exporter is closed and drained
+    Exceptions:
+        None
+    *********************************************************************/
+    void CropExporter::WorkerLoop( )
+    {
+        const std::string extension = "." + m_settings.m_format;
+
+        std::vector<int> encodeParams;
+        if ( m_settings.m_format == "jpg" )
+        {
+            encodeParams.push_back( CV_IMWRITE_JPEG_QUALITY );
+            encodeParams.push_back( 90 );
+        }
+
+        std::vector<uchar> encoded;
+        for ( ;; )
+        {
+            CropJob job;
+            {
+                boost::mutex::scoped_lock lock( m_queueMutex );
+                while ( m_queue.empty() && !m_stopping )
+                {
+                    m_queueCondition.wait( lock );
+                }
+
+                if ( m_queue.empty() )
+                {
+                    return;
+                }
+
+                job = m_queue.front();
+                m_queue.pop_front();
+                m_queueDepth.store( (int)m_queue.size(), boost::memory_order_relaxed );
+            }
+
+            const bool encodedOk = cv::imencode( extension, job.m_pixels, encoded, encodeParams );
+            ReleaseBuffer( job );
+
+            if ( encodedOk )
+            {
+                char entryName[64];
+                sprintf( entryName, "f%08d_id%05d%s", job.m_frameNum, job.m_blobId, extension.c_str() );
+                WriteArchiveEntry( entryName, encoded );
+            }
+        }
+    }
+
+    /********************************************************************
+    WriteArchiveEntry
+        Appends a file to the current tar archive, starting a new archive
+        every m_archiveSize entries
+    Exceptions:
+        None
+    *********************************************************************/
+    void CropExporter::WriteArchiveEntry( const std::string&           entryName,
+                                          const std::vector<uchar>&    data )
+    {
+        boost::mutex::scoped_lock lock( m_archiveMutex );
+
+        if ( m_pArchive != NULL && m_archiveEntries >= m_settings.m_archiveSize )
+        {
+            CloseArchive( );
+        }
+
+        if ( m_pArchive == NULL )
+        {
+            char archiveName[32];
+            sprintf( archiveName, "_crops_%04d.tar", m_archiveIndex++ );
+
+            m_pArchive = fopen( ( m_archiveBaseName + archiveName ).c_str(), "wb" );
+            if ( m_pArchive == NULL )
+            {
+                LOG_FILE( "Unable to open crop archive " + m_archiveBaseName + archiveName );
+                return;
+            }
+            m_archiveEntries = 0;
+        }
+
+        // ustar header
+        char header[TAR_BLOCK_SIZE];
+        memset( header, 0, sizeof(header) );
+        strncpy( header, entryName.c_str(), 99 );
+        sprintf( header + 100, "%07o", 0644 );
+        sprintf( header + 108, "%07o", 0 );
+        sprintf( header + 116, "%07o", 0 );
+        sprintf( header + 124, "%011lo", (unsigned long)data.size() );
+        sprintf( header + 136, "%011lo", (unsigned long)time( NULL ) );
+        header[156] = '0';
+        memcpy( header + 257, "ustar", 6 );
+        memcpy( header + 263, "00", 2 );
+
+        // the checksum is computed with the checksum field set to spaces
+        memset( header + 148, ' ', 8 );
+        unsigned int checksum = 0;
+        for ( int i = 0; i < TAR_BLOCK_SIZE; i++ )
+        {
+            checksum += (unsigned char)header[i];
+        }
+        sprintf( header + 148, "%06o", checksum );
+        header[155] = ' ';
+
+        static const char padding[TAR_BLOCK_SIZE] = { 0 };
+        const size_t paddingSize = ( TAR_BLOCK_SIZE - data.size() % TAR_BLOCK_SIZE ) % TAR_BLOCK_SIZE;
+
+        if ( fwrite( header, sizeof(header), 1, m_pArchive ) != 1 ||
+             ( !data.empty() && fwrite( &data[0], data.size(), 1, m_pArchive ) != 1 ) ||
+             ( paddingSize > 0 && fwrite( padding, paddingSize, 1, m_pArchive ) != 1 ) )
+        {
+            LOG_FILE( "Unable to write crop " + entryName );
+            return;
+        }
+
+        m_archiveEntries++;
+        m_exportedCrops++;
+    }
+
+    /********************************************************************
+    CloseArchive
+        Writes the end-of-archive blocks and closes the archive file
+    Exceptions:
+        None
+    *********************************************************************/
+    void CropExporter::CloseArchive( )
+    {
+        if ( m_pArchive == NULL )
+        {
+            return;
+        }
+
+        static const char endBlocks[2 * TAR_BLOCK_SIZE] = { 0 };
+        fwrite( endBlocks, sizeof(endBlocks), 1, m_pArchive );
+        fclose( m_pArchive );
+        m_pArchive = NULL;
+    }
+}
@@ -0,0 +1,142 @@
+#ifndef CROP_EXPORTER_H
+#define CROP_EXPORTER_H
+
+#include "OpenCvDefinitions.h"
+#include "CommonMacros.h"
+
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+namespace Tracker
+{
+    /*
+    *   Settings of the blob crop export.
+    */
+    struct CropExportSettings
+    {
+        CropExportSettings( )
+            : m_format( "jpg" ),
+            m_sampleInterval( 10 ),
+            m_maxCropsPerFrame( 16 ),
+            m_bufferCount( 256 ),
+            m_workerThreads( 2 ),
+            m_archiveSize( 1000 )
+        {
+        }
+
+        std::string         m_format;               // jpg or png
+        int                 m_sampleInterval;       // every Nth crop of a track, 0 keeps the largest crop
+        int                 m_maxCropsPerFrame;     // crops taken from one frame at most
+        int                 m_bufferCount;          // crops in flight at most
+        int                 m_workerThreads;        // encoder threads
+        int                 m_archiveSize;          // crops per archive file
+    };
+
+    /*
+    *   Exports crops of the tracked blobs without holding up the frame
+    *   loop. Crops are copied into pooled buffers, encoded by a pool of
+    *   worker threads and appended to tar archives of m_archiveSize
+    *   crops each. When all buffers are in use further crops are dropped.
+    */
+    class CropExporter
+    {
+    public:
+    // Constructor, archives are named <archiveBaseName>_crops_NNNN.tar
+    CropExporter( const std::string&           archiveBaseName,
+                  const CropExportSettings&    settings );
+
+    // Destructor
+    ~CropExporter( );
+
+    // Offer the crop of a tracked blob in the current frame
+    void AddCrop( const cv::Mat&   frame,
+                  const cv::Rect&  region,
+                  const int        blobId,
+                  const int        frameNum );
+
+    // Finish the frame, exporting the best crops of ended tracks
+    void EndFrame( const int frameNum );
+
+    // Export the remaining crops and stop the workers
+    void Close( );
+
+    // Bytes held by the crop buffers
+    size_t GetBufferBytes( );
+
+    // Crops waiting for the encoders, read without locking
+    int    GetQueueDepth( ) const   { return m_queueDepth.load( boost::memory_order_relaxed ); }
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( CropExporter );
+
+    // A crop waiting to be encoded
+    struct CropJob
+    {
+        cv::Mat             m_buffer;
+        cv::Mat             m_pixels;
+        int                 m_blobId;
+        int                 m_frameNum;
+    };
+
+    // Sampling state of a track
+    struct TrackState
+    {
+        int                 m_cropCount;
+        int                 m_lastFrame;
+        int                 m_bestArea;
+        CropJob             m_best;
+    };
+
+    // Take a buffer from the pool and copy the crop into it
+    bool    CopyCrop( const cv::Mat& crop, CropJob& job );
+
+    // Return the buffer of a job to the pool
+    void    ReleaseBuffer( CropJob& job );
+
+    // Queue a job for the workers
+    void    Enqueue( CropJob& job );
+
+    // Encode queued crops until closed
+    void    WorkerLoop( );
+
+    // Append an encoded crop to the current archive
+    void    WriteArchiveEntry( const std::string&           entryName,
+                               const std::vector<uchar>&    data );
+
+    // Terminate the current archive file
+    void    CloseArchive( );
+
+    std::string                     m_archiveBaseName;
+    CropExportSettings              m_settings;
+    std::map<int, TrackState>       m_tracks;
+    int                             m_cropsInFrame;
+    bool                            m_closed;
+
+    // shared with the workers
+    boost::mutex                    m_queueMutex;
+    boost::condition_variable       m_queueCondition;
+    std::deque<CropJob>             m_queue;
+    boost::atomic<int>              m_queueDepth;
+    std::vector<cv::Mat>            m_freeBuffers;
+    int                             m_allocatedBuffers;
+    size_t                          m_bufferBytes;
+    bool                            m_stopping;
+    int                             m_droppedCrops;
+    boost::thread_group             m_workers;
+
+    // archive output
+    boost::mutex                    m_archiveMutex;
+    FILE*                           m_pArchive;
+    int                             m_archiveIndex;
+    int                             m_archiveEntries;
+    int                             m_exportedCrops;
+    };
+}
+#endif
@@ -0,0 +1,371 @@
+// the FFmpeg headers use UINT64_C, which C++ only defines on request
+#define __STDC_CONSTANT_MACROS
+
+#include "FFmpegFrameSource.h"
+
+#ifdef USE_FFMPEG_DECODER
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+
+//load the ffmpeg libraries
+#if defined(WIN32) || defined(WIN64)
+#pragma comment(lib,"avformat.lib")
+#pragma comment(lib,"avcodec.lib")
+#pragma comment(lib,"avutil.lib")
+#pragma comment(lib,"swscale.lib")
+#endif
+
+namespace Tracker
+{
+    /********************************************************************
+    FFmpegFrameSource
+        Opens the video file and its decoder
+    Exceptions:
+        None
+    *********************************************************************/
+    FFmpegFrameSource::FFmpegFrameSource( const std::string&        fileName,
+                                          const DecoderSettings&    decoderSettings )
+        : m_pFormatContext( NULL ),
+        m_pCodecContext( NULL ),
+        m_pFrame( NULL ),
+        m_pPacket( NULL ),
+        m_pScaleContext( NULL ),
+        m_streamIndex( -1 ),
+        m_scale( 1.0 ),
+        m_scaleOnConversion( false ),
+        m_flushed( false ),
+        m_framePending( false ),
+        m_converted( false ),
+        m_frame( )
+    {
+        if ( !Open( fileName, decoderSettings ) )
+        {
+            LOG_FILE( "Unable to decode " + fileName + " with FFmpeg" );
+            Release( );
+        }
+    }
+
+    /********************************************************************
+    Default Destructor for class FFmpegFrameSource
+    *********************************************************************/
+    FFmpegFrameSource::~FFmpegFrameSource( )
+    {
+        Release( );
+    }
+
+    /********************************************************************
+    Open
+        Opens the container and the decoder of its best video stream.
+        Frame threading decodes several frames at once and delays the
+        output by a frame per thread, slice threading splits a frame;
+        a decoder uses the kinds it supports.
+    Exceptions:
+        None
+    *********************************************************************/
+    bool FFmpegFrameSource::Open( const std::string&        fileName,
+                                  const DecoderSettings&    decoderSettings )
+    {
+        if ( avformat_open_input( &m_pFormatContext, fileName.c_str(), NULL, NULL ) < 0 ||
+             avformat_find_stream_info( m_pFormatContext, NULL ) < 0 )
+        {
+            return false;
+        }
+
+        m_streamIndex = av_find_best_stream( m_pFormatContext, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0 );
+        if ( m_streamIndex < 0 )
+        {
+            return false;
+        }
+
+        const AVCodecParameters* pParameters = m_pFormatContext->streams[m_streamIndex]->codecpar;
+        const AVCodec* pCodec = avcodec_find_decoder( pParameters->codec_id );
+        if ( pCodec == NULL )
+        {
+            return false;
+        }
+
+        m_pCodecContext = avcodec_alloc_context3( pCodec );
+        if ( m_pCodecContext == NULL ||
+             avcodec_parameters_to_context( m_pCodecContext, pParameters ) < 0 )
+        {
+            return false;
+        }
+
+        m_pCodecContext->thread_count = decoderSettings.m_threads;
+        if ( decoderSettings.m_threadType == "frame" )
+        {
+            m_pCodecContext->thread_type = FF_THREAD_FRAME;
+        }
+        else if ( decoderSettings.m_threadType == "slice" )
+        {
+            m_pCodecContext->thread_type = FF_THREAD_SLICE;
+        }
+        else
+        {
+            m_pCodecContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        }
+
+        // codecs without reduced resolution decoding reset lowres when opened
+        if ( decoderSettings.m_downScale )
+        {
+            m_pCodecContext->lowres = 1;
+        }
+
+        if ( avcodec_open2( m_pCodecContext, pCodec, NULL ) < 0 )
+        {
+            return false;
+        }
+
+        m_pFrame    = av_frame_alloc();
+        m_pPacket   = av_packet_alloc();
+        if ( m_pFrame == NULL || m_pPacket == NULL )
+        {
+            return false;
+        }
+
+        m_scaleOnConversion = decoderSettings.m_downScale && m_pCodecContext->lowres == 0;
+        m_scale             = decoderSettings.m_downScale ? 0.5 : 1.0;
+
+        LOG_FILE( "Decoding " << fileName << " with " << pCodec->name << ", " << m_pCodecContext->thread_count <<
+                  " threads" << ( m_pCodecContext->lowres > 0 ? ", at half resolution" : "" ) );
+        return true;
+    }
+
+    /********************************************************************
+    Release
+        Closes the decoder and the file
+    Exceptions:
+        None
+    *********************************************************************/
+    void FFmpegFrameSource::Release( )
+    {
+        sws_freeContext( m_pScaleContext );
+        m_pScaleContext = NULL;
+
+        av_packet_free( &m_pPacket );
+        av_frame_free( &m_pFrame );
+        avcodec_free_context( &m_pCodecContext );
+        avformat_close_input( &m_pFormatContext );
+
+        m_streamIndex   = -1;
+        m_framePending  = false;
+    }
+
+    /********************************************************************
+    SendPacket
+        Sends the next packet of the video stream to the decoder. At the
+        end of the file the decoder is flushed, so that it returns the
+        frames its threads still hold. Damaged packets are skipped.
+    Exceptions:
+        None
+    *********************************************************************/
+    bool FFmpegFrameSource::SendPacket( )
+    {
+        if ( m_flushed )
+        {
+            return false;
+        }
+
+        while ( av_read_frame( m_pFormatContext, m_pPacket ) >= 0 )
+        {
+            const bool videoPacket  = m_pPacket->stream_index == m_streamIndex;
+            const bool sent         = videoPacket && avcodec_send_packet( m_pCodecContext, m_pPacket ) >= 0;
+            av_packet_unref( m_pPacket );
+
+            if ( sent )
+            {
+                return true;
+            }
+        }
+
+        m_flushed = true;
+        return avcodec_send_packet( m_pCodecContext, NULL ) >= 0;
+    }
+
+    /********************************************************************
+    DecodeFrame
+        Decodes the next frame, sending packets until the decoder has one
+    Exceptions:
+        None
+    *********************************************************************/
+    bool FFmpegFrameSource::DecodeFrame( )
+    {
+        for ( ;; )
+        {
+            const int result = avcodec_receive_frame( m_pCodecContext, m_pFrame );
+            if ( result == 0 )
+            {
+                m_converted = false;
+                return true;
+            }
+
+            if ( result != AVERROR(EAGAIN) || !SendPacket( ) )
+            {
+                return false;
+            }
+        }
+    }
+
+    /********************************************************************
+    Grab
+        Decodes the next frame, or takes the one decoded by Seek
+    Exceptions:
+        None
+    *********************************************************************/
+    bool FFmpegFrameSource::Grab( )
+    {
+        if ( !IsOpened() )
+        {
+            return false;
+        }
+
+        if ( m_framePending )
+        {
+            m_framePending  = false;
+            m_converted     = false;
+            return true;
+        }
+
+        return DecodeFrame( );
+    }
+
+    /********************************************************************
+    Retrieve
+        Converts the decoded frame to BGR, halving it in the same pass
+        when the decoder delivered the full size
+    Exceptions:
+        None
+    *********************************************************************/
+    bool FFmpegFrameSource::Retrieve( cv::Mat& frame )
+    {
+        if ( !IsOpened() || m_pFrame->width <= 0 || m_pFrame->height <= 0 )
+        {
+            return false;
+        }
+
+        if ( !m_converted )
+        {
+            const int width     = m_scaleOnConversion ? m_pFrame->width / 2 : m_pFrame->width;
+            const int height    = m_scaleOnConversion ? m_pFrame->height / 2 : m_pFrame->height;
+
+            m_pScaleContext = sws_getCachedContext( m_pScaleContext,
+                                                    m_pFrame->width, m_pFrame->height, (AVPixelFormat)m_pFrame->format,
+                                                    width, height, AV_PIX_FMT_BGR24,
+                                                    m_scaleOnConversion ? SWS_AREA : SWS_POINT, NULL, NULL, NULL );
+            if ( m_pScaleContext == NULL )
+            {
+                return false;
+            }
+
+            m_frame.create( height, width, CV_8UC3 );
+
+            uint8_t*    planes[1]   = { m_frame.data };
+            const int   strides[1]  = { (int)m_frame.step };
+            sws_scale( m_pScaleContext, m_pFrame->data, m_pFrame->linesize, 0, m_pFrame->height, planes, strides );
+
+            m_converted = true;
+        }
+
+        frame = m_frame;
+        return true;
+    }
+
+    /********************************************************************
+    Seek
+        Seeks to the key frame before the given frame and decodes up to
+        it, so that the next Grab delivers it
+    Exceptions:
+        None
+    *********************************************************************/
+    bool FFmpegFrameSource::Seek( const int frameIndex )
+    {
+        if ( !IsOpened() )
+        {
+            return false;
+        }
+
+        const AVStream* pStream   = m_pFormatContext->streams[m_streamIndex];
+        const double    frameRate = av_q2d( pStream->avg_frame_rate );
+        const double    timeBase  = av_q2d( pStream->time_base );
+        if ( frameRate <= 0 || timeBase <= 0 )
+        {
+            return false;
+        }
+
+        const int64_t startTime = pStream->start_time != AV_NOPTS_VALUE ? pStream->start_time : 0;
+        const int64_t target    = startTime + (int64_t)( frameIndex / frameRate / timeBase + 0.5 );
+        const int64_t halfFrame = (int64_t)( 0.5 / frameRate / timeBase );
+
+        if ( av_seek_frame( m_pFormatContext, m_streamIndex, target, AVSEEK_FLAG_BACKWARD ) < 0 )
+        {
+            return false;
+        }
+        avcodec_flush_buffers( m_pCodecContext );
+        m_flushed       = false;
+        m_framePending  = false;
+
+        while ( DecodeFrame( ) )
+        {
+            if ( m_pFrame->best_effort_timestamp == AV_NOPTS_VALUE ||
+                 m_pFrame->best_effort_timestamp >= target - halfFrame )
+            {
+                m_framePending = true;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /********************************************************************
+    GetFrameCount
+        Frame count of the stream, or estimated from its duration
+    Exceptions:
+        None
+    *********************************************************************/
+    int FFmpegFrameSource::GetFrameCount( )
+    {
+        if ( !IsOpened() )
+        {
+            return -1;
+        }
+
+        const AVStream* pStream = m_pFormatContext->streams[m_streamIndex];
+        if ( pStream->nb_frames > 0 )
+        {
+            return (int)pStream->nb_frames;
+        }
+
+        if ( pStream->duration != AV_NOPTS_VALUE && av_q2d( pStream->avg_frame_rate ) > 0 )
+        {
+            return cvRound( pStream->duration * av_q2d( pStream->time_base ) * av_q2d( pStream->avg_frame_rate ) );
+        }
+
+        return -1;
+    }
+
+    /********************************************************************
+    GetTimestamp
+        Presentation time of the grabbed frame from the stream start
+    Exceptions:
+        None
+    *********************************************************************/
+    double FFmpegFrameSource::GetTimestamp( )
+    {
+        if ( !IsOpened() || m_pFrame->best_effort_timestamp == AV_NOPTS_VALUE )
+        {
+            return -1.0;
+        }
+
+        const AVStream* pStream   = m_pFormatContext->streams[m_streamIndex];
+        const int64_t   startTime = pStream->start_time != AV_NOPTS_VALUE ? pStream->start_time : 0;
+        return ( m_pFrame->best_effort_timestamp - startTime ) * av_q2d( pStream->time_base );
+    }
+}
+
+#endif
\ No newline at end of file
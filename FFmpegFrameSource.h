@@ -0,0 +1,71 @@
+#ifndef FFMPEG_FRAME_SOURCE_H
+#define FFMPEG_FRAME_SOURCE_H
+
+#include "FrameSource.h"
+
+#ifdef USE_FFMPEG_DECODER
+
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVFrame;
+struct AVPacket;
+struct SwsContext;
+
+namespace Tracker
+{
+    /*
+    *   Video file decoded by libavcodec, with the threading of the
+    *   decoder set from the DecoderSettings. Half resolution frames come
+    *   from the decoder itself where the codec supports it ( lowres ),
+    *   otherwise from the colour conversion, which then scales in the
+    *   same pass, so the full size BGR frame is never built.
+    */
+    class FFmpegFrameSource : public FrameSource
+    {
+    public:
+    // Constructor
+    FFmpegFrameSource( const std::string&       fileName,
+                       const DecoderSettings&   decoderSettings );
+
+    // Destructor
+    virtual ~FFmpegFrameSource( );
+
+    virtual bool    IsOpened( ) const       { return m_pCodecContext != NULL; }
+    virtual bool    Grab( );
+    virtual bool    Retrieve( cv::Mat& frame );
+    virtual void    Release( );
+    virtual double  GetScale( ) const       { return m_scale; }
+    virtual bool    Seek( const int frameIndex );
+    virtual int     GetFrameCount( );
+    virtual double  GetTimestamp( );
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( FFmpegFrameSource );
+
+    // Open the container and the decoder of its video stream
+    bool    Open( const std::string& fileName, const DecoderSettings& decoderSettings );
+
+    // Decode the next frame of the video stream
+    bool    DecodeFrame( );
+
+    // Send the next packet of the video stream, or flush at the end
+    bool    SendPacket( );
+
+    AVFormatContext*                m_pFormatContext;
+    AVCodecContext*                 m_pCodecContext;
+    AVFrame*                        m_pFrame;
+    AVPacket*                       m_pPacket;
+    SwsContext*                     m_pScaleContext;
+    int                             m_streamIndex;
+    double                          m_scale;
+    bool                            m_scaleOnConversion;    // the decoder delivers full frames
+    bool                            m_flushed;
+    bool                            m_framePending;         // decoded by Seek, delivered by the next Grab
+    bool                            m_converted;
+    cv::Mat                         m_frame;
+    };
+}
+
+#endif
+#endif
\ No newline at end of file
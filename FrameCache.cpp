@@ -0,0 +1,507 @@
+#include "FrameCache.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#define FRAME_CACHE_MAGIC           0x43465442  // 'BTFC'
+#define FRAME_CACHE_VERSION         1
+#define FRAME_CACHE_HEADER_SIZE     4096        // keeps the frames page aligned
+
+namespace Tracker
+{
+    /********************************************************************
+    GetSourceFileStatus
+        Size and modification time of the source video
+    Exceptions:
+        None
+    *********************************************************************/
+    static bool GetSourceFileStatus( const std::string& sourceFileName,
+                                     boost::uint64_t&   fileSize,
+                                     boost::int64_t&    modifiedTime )
+    {
+        struct stat fileStatus;
+        if ( stat( sourceFileName.c_str(), &fileStatus ) != 0 )
+        {
+            return false;
+        }
+
+        fileSize        = (boost::uint64_t)fileStatus.st_size;
+        modifiedTime    = (boost::int64_t)fileStatus.st_mtime;
+        return true;
+    }
+
+    /********************************************************************
+    CachingFrameSource
+        Starts writing the cache into a temporary file
+    Exceptions:
+        None
+    *********************************************************************/
+    CachingFrameSource::CachingFrameSource( const FrameSourcePtr&   pSource,
+                                            const std::string&      sourceFileName,
+                                            const std::string&      cacheFileName,
+                                            const bool              downScale )
+        : m_pSource( pSource ),
+        m_cacheFileName( cacheFileName ),
+        m_temporaryFileName( cacheFileName + ".tmp" ),
+        m_pCacheFile( NULL ),
+        m_header( ),
+        m_downScale( downScale ),
+        m_sourceEnded( false ),
+        m_frame( ),
+        m_scaledFrame( )
+    {
+        ASSERT_TRUE( m_pSource );
+
+        memset( &m_header, 0, sizeof(m_header) );
+        m_header.m_magic        = FRAME_CACHE_MAGIC;
+        m_header.m_version      = FRAME_CACHE_VERSION;
+        m_header.m_downScaled   = m_downScale ? 1 : 0;
+        m_header.m_headerSize   = FRAME_CACHE_HEADER_SIZE;
+
+        if ( !GetSourceFileStatus( sourceFileName, m_header.m_sourceFileSize, m_header.m_sourceModifiedTime ) )
+        {
+            LOG_FILE( "Frame cache disabled, unable to stat " + sourceFileName );
+            return;
+        }
+
+        m_pCacheFile = fopen( m_temporaryFileName.c_str(), "wb" );
+        if ( m_pCacheFile == NULL )
+        {
+            LOG_FILE( "Frame cache disabled, unable to create " + m_temporaryFileName );
+            return;
+        }
+
+        LOG_FILE( "Writing frame cache " + m_cacheFileName );
+    }
+
+    /********************************************************************
+    Default Destructor for class CachingFrameSource
+    *********************************************************************/
+    CachingFrameSource::~CachingFrameSource( )
+    {
+        Release( );
+    }
+
+    /********************************************************************
+    Grab
+        Decodes the next frame and appends it to the cache
+    Exceptions:
+        None
+    *********************************************************************/
+    bool CachingFrameSource::Grab( )
+    {
+        if ( !m_pSource->Grab() )
+        {
+            m_sourceEnded = true;
+            return false;
+        }
+
+        if ( m_pCacheFile == NULL )
+        {
+            m_frame.release();
+            return true;
+        }
+
+        if ( !m_pSource->Retrieve( m_frame ) )
+        {
+            AbandonCache( "unable to retrieve frame" );
+            return true;
+        }
+
+        if ( m_downScale )
+        {
+            cv::resize( m_frame, m_scaledFrame, cv::Size(0,0), 0.5, 0.5 );
+            AppendFrame( m_scaledFrame );
+        }
+        else
+        {
+            AppendFrame( m_frame );
+        }
+
+        return true;
+    }
+
+    /********************************************************************
+    Retrieve
+        Returns the frame decoded while caching
+    Exceptions:
+        None
+    *********************************************************************/
+    bool CachingFrameSource::Retrieve( cv::Mat& frame )
+    {
+        if ( m_frame.empty() )
+        {
+            return m_pSource->Retrieve( frame );
+        }
+
+        frame = m_frame;
+        return true;
+    }
+
+    /********************************************************************
+    AppendFrame
+        Writes one frame; the first frame fixes the layout of the cache
+    Exceptions:
+        None
+    *********************************************************************/
+    void CachingFrameSource::AppendFrame( const cv::Mat& frame )
+    {
+        const boost::uint64_t frameSize = frame.total() * frame.elemSize();
+
+        if ( m_header.m_frameCount == 0 )
+        {
+            m_header.m_width        = frame.cols;
+            m_header.m_height       = frame.rows;
+            m_header.m_type         = frame.type();
+            m_header.m_frameSize    = frameSize;
+
+            // reserve the header, it is written once the cache is complete
+            std::vector<char> emptyHeader( FRAME_CACHE_HEADER_SIZE, 0 );
+            if ( fwrite( &emptyHeader[0], 1, emptyHeader.size(), m_pCacheFile ) != emptyHeader.size() )
+            {
+                AbandonCache( "unable to write header" );
+                return;
+            }
+        }
+        else if ( frame.cols != (int)m_header.m_width ||
+                  frame.rows != (int)m_header.m_height ||
+                  frame.type() != (int)m_header.m_type )
+        {
+            AbandonCache( "frame size changed" );
+            return;
+        }
+
+        const cv::Mat continuousFrame = frame.isContinuous() ? frame : frame.clone();
+        if ( fwrite( continuousFrame.data, 1, (size_t)frameSize, m_pCacheFile ) != frameSize )
+        {
+            AbandonCache( "unable to write frame" );
+            return;
+        }
+
+        m_header.m_frameCount++;
+    }
+
+    /********************************************************************
+    AbandonCache
+        Stops caching and removes the partial file
+    Exceptions:
+        None
+    *********************************************************************/
+    void CachingFrameSource::AbandonCache( const char* reason )
+    {
+        LOG_FILE( "Frame cache " << m_cacheFileName << " abandoned: " << reason );
+
+        if ( m_pCacheFile != NULL )
+        {
+            fclose( m_pCacheFile );
+            m_pCacheFile = NULL;
+        }
+
+        remove( m_temporaryFileName.c_str() );
+    }
+
+    /********************************************************************
+    Release
+        Completes the header and publishes the cache file, which must
+        hold every frame of the video
+    Exceptions:
+        None
+    *********************************************************************/
+    void CachingFrameSource::Release( )
+    {
+        m_pSource->Release();
+
+        if ( m_pCacheFile == NULL )
+        {
+            return;
+        }
+
+        if ( m_header.m_frameCount == 0 )
+        {
+            AbandonCache( "no frames" );
+            return;
+        }
+
+        if ( !m_sourceEnded )
+        {
+            AbandonCache( "the video was not read to its end" );
+            return;
+        }
+
+        m_header.m_complete = 1;
+        if ( fseek( m_pCacheFile, 0, SEEK_SET ) != 0 ||
+             fwrite( &m_header, sizeof(m_header), 1, m_pCacheFile ) != 1 )
+        {
+            AbandonCache( "unable to complete header" );
+            return;
+        }
+
+        fclose( m_pCacheFile );
+        m_pCacheFile = NULL;
+
+        remove( m_cacheFileName.c_str() );
+        if ( rename( m_temporaryFileName.c_str(), m_cacheFileName.c_str() ) != 0 )
+        {
+            LOG_FILE( "Unable to publish frame cache " + m_cacheFileName );
+            remove( m_temporaryFileName.c_str() );
+            return;
+        }
+
+        LOG_FILE( "Frame cache " << m_cacheFileName << " holds " << m_header.m_frameCount << " frames" );
+    }
+
+    /*
+    *   Cache file mapped into the process.
+    */
+    class MappedFrameSource::Mapping
+    {
+    public:
+        boost::interprocess::file_mapping       m_file;
+        boost::interprocess::mapped_region      m_region;
+    };
+
+    /********************************************************************
+    MappedFrameSource
+        Maps a cache file validated with IsFrameCacheValid
+    Exceptions:
+        None
+    *********************************************************************/
+    MappedFrameSource::MappedFrameSource( const std::string&        cacheFileName,
+                                          const std::string&        sourceFileName,
+                                          const DecoderSettings&    decoderSettings )
+        : m_pMapping( NULL ),
+        m_pHeader( NULL ),
+        m_sourceFileName( sourceFileName ),
+        m_decoderSettings( decoderSettings ),
+        m_pFallbackSource( ),
+        m_frameIndex( -1 ),
+        m_scaledFrame( )
+    {
+        try
+        {
+            m_pMapping = new Mapping( );
+            boost::interprocess::file_mapping file( cacheFileName.c_str(), boost::interprocess::read_only );
+            m_pMapping->m_file.swap( file );
+
+            // overlays are drawn on the retrieved frames, so writes stay private to the process
+            boost::interprocess::mapped_region region( m_pMapping->m_file, boost::interprocess::copy_on_write );
+            m_pMapping->m_region.swap( region );
+        }
+        catch ( std::exception& ex )
+        {
+            LOG_FILE( "Unable to map frame cache " << cacheFileName << ": " << ex.what() );
+            return;
+        }
+
+        m_pHeader = static_cast<const FrameCacheHeader*>( m_pMapping->m_region.get_address() );
+        LOG_FILE( "Reading " << m_pHeader->m_frameCount << " frames from frame cache " << cacheFileName );
+    }
+
+    /********************************************************************
+    Default Destructor for class MappedFrameSource
+    *********************************************************************/
+    MappedFrameSource::~MappedFrameSource( )
+    {
+        Release( );
+        delete m_pMapping;
+    }
+
+    /********************************************************************
+    Release
+        Stops reading
+    Exceptions:
+        None
+    *********************************************************************/
+    void MappedFrameSource::Release( )
+    {
+        if ( m_pFallbackSource )
+        {
+            m_pFallbackSource->Release();
+        }
+
+        m_pHeader = NULL;
+    }
+
+    /********************************************************************
+    Grab
+        Moves to the next cached frame, or decodes past the cache
+    Exceptions:
+        None
+    *********************************************************************/
+    bool MappedFrameSource::Grab( )
+    {
+        if ( m_pHeader == NULL )
+        {
+            return false;
+        }
+
+        m_frameIndex++;
+        if ( m_frameIndex < (boost::int64_t)m_pHeader->m_frameCount )
+        {
+            return true;
+        }
+
+        if ( !m_pFallbackSource )
+        {
+            LOG_FILE( "Frame cache exhausted, decoding " + m_sourceFileName );
+
+            m_pFallbackSource = OpenVideoFile( m_sourceFileName, m_decoderSettings );
+            for ( boost::uint32_t i = 0; i < m_pHeader->m_frameCount; i++ )
+            {
+                if ( !m_pFallbackSource->Grab() )
+                {
+                    return false;
+                }
+            }
+        }
+
+        return m_pFallbackSource->Grab();
+    }
+
+    /********************************************************************
+    Seek
+        Moves to a cached frame, or positions the decoder past the cache
+    Exceptions:
+        None
+    *********************************************************************/
+    bool MappedFrameSource::Seek( const int frameIndex )
+    {
+        if ( m_pHeader == NULL || frameIndex < 0 )
+        {
+            return false;
+        }
+
+        m_frameIndex = frameIndex - 1;
+        if ( frameIndex <= (int)m_pHeader->m_frameCount )
+        {
+            // the decoder is repositioned when the cache is exhausted again
+            m_pFallbackSource.reset();
+            return true;
+        }
+
+        if ( !m_pFallbackSource )
+        {
+            m_pFallbackSource = OpenVideoFile( m_sourceFileName, m_decoderSettings );
+        }
+        return m_pFallbackSource->Seek( frameIndex );
+    }
+
+    /********************************************************************
+    GetFrameCount
+        A valid cache holds every frame of the video
+    Exceptions:
+        None
+    *********************************************************************/
+    int MappedFrameSource::GetFrameCount( )
+    {
+        return m_pHeader != NULL ? (int)m_pHeader->m_frameCount : -1;
+    }
+
+    /********************************************************************
+    Retrieve
+        Wraps the mapped frame without copying it
+    Exceptions:
+        None
+    *********************************************************************/
+    bool MappedFrameSource::Retrieve( cv::Mat& frame )
+    {
+        if ( m_pHeader == NULL || m_frameIndex < 0 )
+        {
+            return false;
+        }
+
+        if ( m_frameIndex >= (boost::int64_t)m_pHeader->m_frameCount )
+        {
+            if ( !m_pFallbackSource->Retrieve( frame ) )
+            {
+                return false;
+            }
+
+            // keep the delivered resolution consistent with the cached frames
+            if ( m_pHeader->m_downScaled )
+            {
+                cv::resize( frame, m_scaledFrame, cv::Size( m_pHeader->m_width, m_pHeader->m_height ) );
+                frame = m_scaledFrame;
+            }
+            return true;
+        }
+
+        uchar* pFrame = static_cast<uchar*>( m_pMapping->m_region.get_address() ) +
+                              m_pHeader->m_headerSize +
+                              m_frameIndex * m_pHeader->m_frameSize;
+
+        frame = cv::Mat( m_pHeader->m_height,
+                         m_pHeader->m_width,
+                         m_pHeader->m_type,
+                         pFrame );
+        return true;
+    }
+
+    /********************************************************************
+    IsFrameCacheValid
+        Checks the cache header against the source file size and time
+    Exceptions:
+        None
+    *********************************************************************/
+    bool IsFrameCacheValid( const std::string&  cacheFileName,
+                            const std::string&  sourceFileName,
+                            const bool          downScale )
+    {
+        FILE* pCacheFile = fopen( cacheFileName.c_str(), "rb" );
+        if ( pCacheFile == NULL )
+        {
+            return false;
+        }
+
+        FrameCacheHeader header;
+        const bool headerRead = fread( &header, sizeof(header), 1, pCacheFile ) == 1;
+
+        fseek( pCacheFile, 0, SEEK_END );
+        const boost::uint64_t cacheFileSize = (boost::uint64_t)ftell( pCacheFile );
+        fclose( pCacheFile );
+
+        boost::uint64_t sourceFileSize;
+        boost::int64_t  sourceModifiedTime;
+        if ( !headerRead ||
+             !GetSourceFileStatus( sourceFileName, sourceFileSize, sourceModifiedTime ) )
+        {
+            return false;
+        }
+
+        return header.m_magic == FRAME_CACHE_MAGIC &&
+               header.m_version == FRAME_CACHE_VERSION &&
+               header.m_complete == 1 &&
+               header.m_frameCount > 0 &&
+               header.m_downScaled == ( downScale ? 1u : 0u ) &&
+               header.m_sourceFileSize == sourceFileSize &&
+               header.m_sourceModifiedTime == sourceModifiedTime &&
+               cacheFileSize >= header.m_headerSize + header.m_frameCount * header.m_frameSize;
+    }
+
+    /********************************************************************
+    CreateCachedFrameSource
+        Reads a valid cache, otherwise decodes the video and rebuilds it
+    Exceptions:
+        None
+    *********************************************************************/
+    FrameSourcePtr CreateCachedFrameSource( const std::string&      sourceFileName,
+                                            const std::string&      cacheFileName,
+                                            const bool              downScale,
+                                            const DecoderSettings&  decoderSettings )
+    {
+        // the cache scales the frames itself
+        DecoderSettings fullSizeDecoder = decoderSettings;
+        fullSizeDecoder.m_downScale     = false;
+
+        if ( IsFrameCacheValid( cacheFileName, sourceFileName, downScale ) )
+        {
+            return FrameSourcePtr( new MappedFrameSource( cacheFileName, sourceFileName, fullSizeDecoder ) );
+        }
+
+        FrameSourcePtr pVideoSource = OpenVideoFile( sourceFileName, fullSizeDecoder );
+        return FrameSourcePtr( new CachingFrameSource( pVideoSource, sourceFileName, cacheFileName, downScale ) );
+    }
+}
\ No newline at end of file
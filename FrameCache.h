@@ -0,0 +1,130 @@
+#ifndef FRAME_CACHE_H
+#define FRAME_CACHE_H
+
+#include "FrameSource.h"
+
+#include <boost/cstdint.hpp>
+
+#include <string>
+#include <stdio.h>
+
+namespace Tracker
+{
+    /*
+    *   Header of a decoded-frame cache file. Frames follow at offset
+    *   headerSize, frameSize bytes each, starting with the first frame
+    *   of the video.
+    */
+    struct FrameCacheHeader
+    {
+        boost::uint32_t             m_magic;            // 'BTFC'
+        boost::uint32_t             m_version;
+        boost::uint32_t             m_complete;         // set once the writer has finished
+        boost::uint32_t             m_width;
+        boost::uint32_t             m_height;
+        boost::uint32_t             m_type;             // OpenCV matrix type
+        boost::uint32_t             m_downScaled;       // frames stored at half resolution
+        boost::uint32_t             m_frameCount;
+        boost::uint64_t             m_frameSize;
+        boost::uint64_t             m_headerSize;
+        boost::uint64_t             m_sourceFileSize;
+        boost::int64_t              m_sourceModifiedTime;
+    };
+
+    /*
+    *   Passes the frames of a video through and writes every decoded
+    *   frame to the cache file, which is published when the source is
+    *   released after its last frame. A source released earlier, e.g.
+    *   at the end of the processed frame range, discards the cache.
+    */
+    class CachingFrameSource : public FrameSource
+    {
+    public:
+    // Constructor
+    CachingFrameSource( const FrameSourcePtr&   pSource,
+                        const std::string&      sourceFileName,
+                        const std::string&      cacheFileName,
+                        const bool              downScale );
+
+    // Destructor
+    virtual ~CachingFrameSource( );
+
+    virtual bool IsOpened( ) const          { return m_pSource->IsOpened(); }
+    virtual bool Grab( );
+    virtual bool Retrieve( cv::Mat& frame );
+    virtual void Release( );
+    virtual double GetTimestamp( )          { return m_pSource->GetTimestamp(); }
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( CachingFrameSource );
+
+    // Append the frame to the cache file
+    void AppendFrame( const cv::Mat& frame );
+
+    // Stop caching and discard the partial file
+    void AbandonCache( const char* reason );
+
+    FrameSourcePtr                  m_pSource;
+    std::string                     m_cacheFileName;
+    std::string                     m_temporaryFileName;
+    FILE*                           m_pCacheFile;
+    FrameCacheHeader                m_header;
+    bool                            m_downScale;
+    bool                            m_sourceEnded;      // the video was read to its end
+    cv::Mat                         m_frame;
+    cv::Mat                         m_scaledFrame;
+    };
+
+    /*
+    *   Reads frames straight from a memory-mapped cache file. Once the
+    *   cached frames are exhausted the video is decoded again from the
+    *   first frame that is not in the cache.
+    */
+    class MappedFrameSource : public FrameSource
+    {
+    public:
+    // Constructor
+    MappedFrameSource( const std::string&       cacheFileName,
+                       const std::string&       sourceFileName,
+                       const DecoderSettings&   decoderSettings );
+
+    // Destructor
+    virtual ~MappedFrameSource( );
+
+    virtual bool    IsOpened( ) const       { return m_pHeader != NULL; }
+    virtual bool    Grab( );
+    virtual bool    Retrieve( cv::Mat& frame );
+    virtual void    Release( );
+    virtual double  GetScale( ) const       { return m_pHeader != NULL && m_pHeader->m_downScaled ? 0.5 : 1.0; }
+    virtual bool    Seek( const int frameIndex );
+    virtual int     GetFrameCount( );
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( MappedFrameSource );
+
+    class Mapping;
+
+    Mapping*                        m_pMapping;
+    const FrameCacheHeader*         m_pHeader;
+    std::string                     m_sourceFileName;
+    DecoderSettings                 m_decoderSettings;
+    FrameSourcePtr                  m_pFallbackSource;
+    boost::int64_t                  m_frameIndex;
+    cv::Mat                         m_scaledFrame;
+    };
+
+    // Is the cache file complete and made from the current source file
+    bool            IsFrameCacheValid( const std::string&   cacheFileName,
+                                       const std::string&   sourceFileName,
+                                       const bool           downScale );
+
+    // Open the cached frames of a video file, or a source that builds the
+    // cache; the decoder always delivers the original frames to the cache
+    FrameSourcePtr  CreateCachedFrameSource( const std::string&         sourceFileName,
+                                             const std::string&         cacheFileName,
+                                             const bool                 downScale,
+                                             const DecoderSettings&     decoderSettings );
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,611 @@
+#include "FrameSource.h"
+#include "FFmpegFrameSource.h"
+
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <sstream>
+
+#if defined(WIN32) || defined(WIN64)
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#define SLEEP_MILLISECONDS( ms )        Sleep( ms )
+// ordered accesses of the shared frame ring counters
+#define LOAD_ACQUIRE_32( p )            ( (boost::uint32_t)InterlockedCompareExchange( (volatile LONG*)(p), 0, 0 ) )
+#define LOAD_ACQUIRE_64( p )            ( (boost::uint64_t)InterlockedCompareExchange64( (volatile LONGLONG*)(p), 0, 0 ) )
+#define STORE_RELEASE_64( p, value )    InterlockedExchange64( (volatile LONGLONG*)(p), (LONGLONG)(value) )
+#else
+#include <unistd.h>
+#define SLEEP_MILLISECONDS( ms )        usleep( (ms) * 1000 )
+// ordered accesses of the shared frame ring counters
+#define LOAD_ACQUIRE_32( p )            __atomic_load_n( (p), __ATOMIC_ACQUIRE )
+#define LOAD_ACQUIRE_64( p )            __atomic_load_n( (p), __ATOMIC_ACQUIRE )
+#define STORE_RELEASE_64( p, value )    __atomic_store_n( (p), (value), __ATOMIC_RELEASE )
+#endif
+
+#define SHARED_FRAME_RING_MAGIC     0x52535442  // 'BTSR'
+#define SHARED_FRAME_RING_VERSION   1
+#define Y4M_MAX_HEADER_LENGTH       1024
+
+namespace Tracker
+{
+    /********************************************************************
+    VideoFileSource
+        Opens the video file with cv::VideoCapture
+    Exceptions:
+        None
+    *********************************************************************/
+    VideoFileSource::VideoFileSource( const std::string& fileName )
+        : m_videoCap( fileName )
+    {
+    }
+
+    /********************************************************************
+    Seek
+        Positions the decoder on the given frame
+    Exceptions:
+        None
+    *********************************************************************/
+    bool VideoFileSource::Seek( const int frameIndex )
+    {
+        return m_videoCap.set( CV_CAP_PROP_POS_FRAMES, frameIndex );
+    }
+
+    /********************************************************************
+    GetFrameCount
+        Frame count reported by the container
+    Exceptions:
+        None
+    *********************************************************************/
+    int VideoFileSource::GetFrameCount( )
+    {
+        const double frameCount = m_videoCap.get( CV_CAP_PROP_FRAME_COUNT );
+        return frameCount > 0 ? cvRound( frameCount ) : -1;
+    }
+
+    /********************************************************************
+    StreamFrameSource
+        Opens stdin, a named pipe or a file for reading
+    Exceptions:
+        None
+    *********************************************************************/
+    StreamFrameSource::StreamFrameSource( const std::string&    streamName,
+                                          const RawFrameFormat* pRawFormat )
+        : m_pStream( NULL ),
+        m_ownsStream( false ),
+        m_y4m( pRawFormat == NULL ),
+        m_format( ),
+        m_frameRate( 0 ),
+        m_grabbedFrames( 0 ),
+        m_planes( ),
+        m_frame( ),
+        m_converted( false )
+    {
+        if ( streamName == "-" )
+        {
+#if defined(WIN32) || defined(WIN64)
+            _setmode( _fileno( stdin ), _O_BINARY );
+#endif
+            m_pStream = stdin;
+        }
+        else
+        {
+            m_pStream       = fopen( streamName.c_str(), "rb" );
+            m_ownsStream    = true;
+        }
+
+        if ( m_pStream == NULL )
+        {
+            LOG_FILE( "Unable to open input stream " + streamName );
+            return;
+        }
+
+        if ( m_y4m )
+        {
+            if ( !ReadY4MHeader( ) )
+            {
+                LOG_FILE( "Invalid Y4M header in " + streamName );
+                Release( );
+                return;
+            }
+        }
+        else
+        {
+            m_format = *pRawFormat;
+            if ( m_format.m_width <= 0 || m_format.m_height <= 0 )
+            {
+                LOG_FILE( "Raw_Frame_Width and Raw_Frame_Height are required for " + streamName );
+                Release( );
+                return;
+            }
+        }
+
+        AllocateBuffers( );
+    }
+
+    /********************************************************************
+    Default Destructor for class StreamFrameSource
+    *********************************************************************/
+    StreamFrameSource::~StreamFrameSource( )
+    {
+        Release( );
+    }
+
+    /********************************************************************
+    Release
+        Closes the stream
+    Exceptions:
+        None
+    *********************************************************************/
+    void StreamFrameSource::Release( )
+    {
+        if ( m_pStream != NULL && m_ownsStream )
+        {
+            fclose( m_pStream );
+        }
+
+        m_pStream = NULL;
+    }
+
+    /********************************************************************
+    ReadY4MHeader
+        Parses "YUV4MPEG2 W<width> H<height> F<rate> ... C<colorspace>"
+    Exceptions:
+        None
+    *********************************************************************/
+    bool StreamFrameSource::ReadY4MHeader( )
+    {
+        char header[Y4M_MAX_HEADER_LENGTH];
+        if ( fgets( header, sizeof(header), m_pStream ) == NULL ||
+             strncmp( header, "YUV4MPEG2 ", 10 ) != 0 )
+        {
+            return false;
+        }
+
+        m_format.m_format = "i420";
+
+        std::istringstream tokens( header + 10 );
+        std::string token;
+        while ( tokens >> token )
+        {
+            switch ( token[0] )
+            {
+                case 'W':
+                    m_format.m_width = atoi( token.c_str() + 1 );
+                    break;
+                case 'H':
+                    m_format.m_height = atoi( token.c_str() + 1 );
+                    break;
+                case 'F':
+                {
+                    int numerator = 0, denominator = 0;
+                    if ( sscanf( token.c_str() + 1, "%d:%d", &numerator, &denominator ) == 2 && numerator > 0 && denominator > 0 )
+                    {
+                        m_frameRate = (double)numerator / denominator;
+                    }
+                    break;
+                }
+                case 'C':
+                    if ( token.compare( 1, 4, "mono" ) == 0 )
+                    {
+                        m_format.m_format = "gray8";
+                    }
+                    else if ( token.compare( 1, 3, "420" ) != 0 )
+                    {
+                        LOG_FILE( "Unsupported Y4M colorspace " + token );
+                        return false;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        return m_format.m_width > 0 && m_format.m_height > 0;
+    }
+
+    /********************************************************************
+    AllocateBuffers
+        Allocates the buffer the stream is read into. BGR frames are read
+        straight into the frame handed to the tracker.
+    Exceptions:
+        None
+    *********************************************************************/
+    void StreamFrameSource::AllocateBuffers( )
+    {
+        const int width     = m_format.m_width;
+        const int height    = m_format.m_height;
+
+        if ( m_format.m_format == "bgr24" )
+        {
+            m_frame.create( height, width, CV_8UC3 );
+        }
+        else if ( m_format.m_format == "gray8" )
+        {
+            m_planes.create( height, width, CV_8UC1 );
+        }
+        else if ( m_format.m_format == "i420" )
+        {
+            ASSERT_TRUE( width % 2 == 0 && height % 2 == 0 );
+            m_planes.create( height * 3 / 2, width, CV_8UC1 );
+        }
+        else
+        {
+            LOG_FILE( "Unsupported raw frame format " + m_format.m_format );
+            Release( );
+        }
+    }
+
+    /********************************************************************
+    ReadFully
+        Reads the requested number of bytes, blocking on a pipe until the
+        producer has written them
+    Exceptions:
+        None
+    *********************************************************************/
+    bool StreamFrameSource::ReadFully( void*         pBuffer,
+                                       const size_t  size )
+    {
+        return fread( pBuffer, 1, size, m_pStream ) == size;
+    }
+
+    /********************************************************************
+    Grab
+        Reads the next frame from the stream
+    Exceptions:
+        None
+    *********************************************************************/
+    bool StreamFrameSource::Grab( )
+    {
+        if ( m_pStream == NULL )
+        {
+            return false;
+        }
+
+        if ( m_y4m )
+        {
+            // skip the "FRAME" line and its optional parameters
+            char frameHeader[Y4M_MAX_HEADER_LENGTH];
+            if ( fgets( frameHeader, sizeof(frameHeader), m_pStream ) == NULL ||
+                 strncmp( frameHeader, "FRAME", 5 ) != 0 )
+            {
+                return false;
+            }
+        }
+
+        cv::Mat& target = m_planes.empty() ? m_frame : m_planes;
+
+        m_converted = false;
+        if ( !ReadFully( target.data, target.total() * target.elemSize() ) )
+        {
+            return false;
+        }
+
+        m_grabbedFrames++;
+        return true;
+    }
+
+    /********************************************************************
+    GetTimestamp
+        Capture time of the grabbed frame from the Y4M frame rate
+    Exceptions:
+        None
+    *********************************************************************/
+    double StreamFrameSource::GetTimestamp( )
+    {
+        return m_frameRate > 0 ? ( m_grabbedFrames - 1 ) / m_frameRate : -1.0;
+    }
+
+    /********************************************************************
+    Retrieve
+        Converts the grabbed frame to BGR if needed
+    Exceptions:
+        None
+    *********************************************************************/
+    bool StreamFrameSource::Retrieve( cv::Mat& frame )
+    {
+        if ( m_pStream == NULL )
+        {
+            return false;
+        }
+
+        if ( !m_converted && !m_planes.empty() )
+        {
+            if ( m_format.m_format == "i420" )
+            {
+                cv::cvtColor( m_planes, m_frame, CV_YUV2BGR_I420 );
+            }
+            else
+            {
+                cv::cvtColor( m_planes, m_frame, CV_GRAY2BGR );
+            }
+        }
+
+        m_converted = true;
+        frame       = m_frame;
+        return true;
+    }
+
+    /*
+    *   Shared memory segment mapped into the process.
+    */
+    class SharedMemoryFrameSource::Mapping
+    {
+    public:
+        boost::interprocess::shared_memory_object   m_segment;
+        boost::interprocess::mapped_region          m_region;
+    };
+
+    /********************************************************************
+    SharedMemoryFrameSource
+        Maps the shared memory ring published by the producer
+    Exceptions:
+        None
+    *********************************************************************/
+    SharedMemoryFrameSource::SharedMemoryFrameSource( const std::string& segmentName )
+        : m_pMapping( NULL ),
+        m_pHeader( NULL ),
+        m_holdsSlot( false ),
+        m_slotIndex( 0 ),
+        m_convertedFrame( )
+    {
+        // boost names the segment without the leading slash of shm_open
+        std::string name = segmentName;
+        if ( !name.empty() && name[0] == '/' )
+        {
+            name = name.substr( 1 );
+        }
+
+        try
+        {
+            m_pMapping = new Mapping( );
+            boost::interprocess::shared_memory_object segment( boost::interprocess::open_only,
+                                                               name.c_str(),
+                                                               boost::interprocess::read_write );
+            m_pMapping->m_segment.swap( segment );
+
+            boost::interprocess::mapped_region region( m_pMapping->m_segment, boost::interprocess::read_write );
+            m_pMapping->m_region.swap( region );
+        }
+        catch ( std::exception& ex )
+        {
+            LOG_FILE( "Unable to map shared memory " << segmentName << ": " << ex.what() );
+            return;
+        }
+
+        if ( m_pMapping->m_region.get_size() < sizeof(SharedFrameRingHeader) )
+        {
+            LOG_FILE( "Invalid shared memory frame ring " + segmentName );
+            return;
+        }
+
+        SharedFrameRingHeader* pHeader = static_cast<SharedFrameRingHeader*>( m_pMapping->m_region.get_address() );
+        const boost::uint64_t frameSize = (boost::uint64_t)pHeader->m_width * pHeader->m_height * pHeader->m_channels;
+
+        if ( pHeader->m_magic != SHARED_FRAME_RING_MAGIC ||
+             pHeader->m_version != SHARED_FRAME_RING_VERSION ||
+             ( pHeader->m_channels != 1 && pHeader->m_channels != 3 ) ||
+             pHeader->m_slotCount == 0 ||
+             pHeader->m_slotSize < frameSize ||
+             pHeader->m_headerSize < sizeof(SharedFrameRingHeader) ||
+             pHeader->m_headerSize + pHeader->m_slotSize * pHeader->m_slotCount > m_pMapping->m_region.get_size() )
+        {
+            LOG_FILE( "Invalid shared memory frame ring " + segmentName );
+            return;
+        }
+
+        m_pHeader = pHeader;
+    }
+
+    /********************************************************************
+    Default Destructor for class SharedMemoryFrameSource
+    *********************************************************************/
+    SharedMemoryFrameSource::~SharedMemoryFrameSource( )
+    {
+        Release( );
+        delete m_pMapping;
+    }
+
+    /********************************************************************
+    Release
+        Hands back the current slot and stops reading
+    Exceptions:
+        None
+    *********************************************************************/
+    void SharedMemoryFrameSource::Release( )
+    {
+        if ( m_pHeader != NULL )
+        {
+            ReleaseSlot( );
+        }
+
+        m_pHeader = NULL;
+    }
+
+    /********************************************************************
+    ReleaseSlot
+        Lets the producer reuse the slot of the last frame
+    Exceptions:
+        None
+    *********************************************************************/
+    void SharedMemoryFrameSource::ReleaseSlot( )
+    {
+        if ( m_holdsSlot )
+        {
+            // the reads of the slot complete before the producer may reuse it
+            STORE_RELEASE_64( &m_pHeader->m_readCount, m_slotIndex + 1 );
+            m_holdsSlot = false;
+        }
+    }
+
+    /********************************************************************
+    Grab
+        Waits for the producer to publish the next frame
+    Exceptions:
+        None
+    *********************************************************************/
+    bool SharedMemoryFrameSource::Grab( )
+    {
+        if ( m_pHeader == NULL )
+        {
+            return false;
+        }
+
+        ReleaseSlot( );
+
+        while ( true )
+        {
+            // closed first, so the frames written before it are seen;
+            // the acquire loads order the reads of the slot after them
+            const bool              closed      = LOAD_ACQUIRE_32( &m_pHeader->m_closed ) != 0;
+            const boost::uint64_t   writeCount  = LOAD_ACQUIRE_64( &m_pHeader->m_writeCount );
+            const boost::uint64_t   readCount   = LOAD_ACQUIRE_64( &m_pHeader->m_readCount );
+
+            if ( writeCount > readCount )
+            {
+                m_slotIndex = readCount;
+                m_holdsSlot = true;
+                return true;
+            }
+
+            if ( closed )
+            {
+                return false;
+            }
+
+            SLEEP_MILLISECONDS( 1 );
+        }
+    }
+
+    /********************************************************************
+    Retrieve
+        Wraps the slot of the grabbed frame without copying it
+    Exceptions:
+        None
+    *********************************************************************/
+    bool SharedMemoryFrameSource::Retrieve( cv::Mat& frame )
+    {
+        if ( m_pHeader == NULL || !m_holdsSlot )
+        {
+            return false;
+        }
+
+        uchar* pSlot = static_cast<uchar*>( m_pMapping->m_region.get_address() ) +
+                       m_pHeader->m_headerSize +
+                       ( m_slotIndex % m_pHeader->m_slotCount ) * m_pHeader->m_slotSize;
+
+        cv::Mat slotFrame( m_pHeader->m_height,
+                           m_pHeader->m_width,
+                           CV_8UC( m_pHeader->m_channels ),
+                           pSlot );
+
+        if ( m_pHeader->m_channels == 3 )
+        {
+            frame = slotFrame;
+        }
+        else
+        {
+            cv::cvtColor( slotFrame, m_convertedFrame, CV_GRAY2BGR );
+            frame = m_convertedFrame;
+        }
+
+        return true;
+    }
+
+    /********************************************************************
+    CreateFrameSource
+        Creates the frame source for a configured video name
+    Exceptions:
+        None
+    *********************************************************************/
+    FrameSourcePtr CreateFrameSource( const std::string&        sourceDirectory,
+                                      const std::string&        sourceName,
+                                      const RawFrameFormat&     rawFormat,
+                                      const DecoderSettings&    decoderSettings )
+    {
+        const std::string scheme    = sourceName.substr( 0, 4 );
+        const std::string location  = sourceName.size() > 4 ? sourceName.substr( 4 ) : std::string();
+
+        if ( scheme == "y4m:" )
+        {
+            return FrameSourcePtr( new StreamFrameSource( location, NULL ) );
+        }
+
+        if ( scheme == "raw:" )
+        {
+            return FrameSourcePtr( new StreamFrameSource( location, &rawFormat ) );
+        }
+
+        if ( scheme == "shm:" )
+        {
+            return FrameSourcePtr( new SharedMemoryFrameSource( location ) );
+        }
+
+        return OpenVideoFile( sourceDirectory + '/' + sourceName, decoderSettings );
+    }
+
+    /********************************************************************
+    OpenVideoFile
+        Opens a video file with FFmpeg when configured and built in,
+        otherwise with cv::VideoCapture
+    Exceptions:
+        None
+    *********************************************************************/
+    FrameSourcePtr OpenVideoFile( const std::string&        fileName,
+                                  const DecoderSettings&    decoderSettings )
+    {
+        if ( decoderSettings.m_ffmpeg )
+        {
+#ifdef USE_FFMPEG_DECODER
+            return FrameSourcePtr( new FFmpegFrameSource( fileName, decoderSettings ) );
+#else
+            LOG_WARNING( "Video_Decoder FFmpeg needs a build with USE_FFMPEG_DECODER, decoding " << fileName << " with OpenCV" );
+#endif
+        }
+
+        return FrameSourcePtr( new VideoFileSource( fileName ) );
+    }
+
+    /********************************************************************
+    IsStreamSource
+        Is the video name a y4m:, raw: or shm: stream
+    Exceptions:
+        None
+    *********************************************************************/
+    bool IsStreamSource( const std::string& sourceName )
+    {
+        const std::string scheme = sourceName.substr( 0, 4 );
+        return scheme == "y4m:" || scheme == "raw:" || scheme == "shm:";
+    }
+
+    /********************************************************************
+    GetSourceOutputName
+        Plain video names are kept as is; stream sources are named after
+        the last component of their path, and stdin after "stdin"
+    Exceptions:
+        None
+    *********************************************************************/
+    std::string GetSourceOutputName( const std::string& sourceName )
+    {
+        if ( !IsStreamSource( sourceName ) )
+        {
+            return sourceName;
+        }
+
+        const std::string scheme = sourceName.substr( 0, 4 );
+        std::string location = sourceName.substr( 4 );
+        if ( location == "-" )
+        {
+            return "stdin";
+        }
+
+        const size_t separator = location.find_last_of( "/\\" );
+        if ( separator != std::string::npos )
+        {
+            location = location.substr( separator + 1 );
+        }
+
+        return location.empty() ? scheme.substr( 0, 3 ) : location;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,234 @@
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include "OpenCvDefinitions.h"
+#include "CommonMacros.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+namespace Tracker
+{
+    /*
+    *   Layout of a raw frame stream, which has no header of its own.
+    */
+    struct RawFrameFormat
+    {
+        RawFrameFormat( ) : m_width( 0 ), m_height( 0 ), m_format( "bgr24" ) {}
+
+        int                 m_width;
+        int                 m_height;
+        std::string         m_format;       // bgr24, gray8 or i420
+    };
+
+    /*
+    *   Decoding of video files. cv::VideoCapture offers no decoder
+    *   options, so the settings apply to the FFmpeg decoder, which is
+    *   built with USE_FFMPEG_DECODER.
+    */
+    struct DecoderSettings
+    {
+        DecoderSettings( ) : m_ffmpeg( false ), m_threads( 0 ), m_threadType( ), m_downScale( false ) {}
+
+        bool                m_ffmpeg;       // decode with FFmpeg instead of cv::VideoCapture
+        int                 m_threads;      // decoder threads, 0 for one per core
+        std::string         m_threadType;   // frame, slice or frame+slice, empty for both
+        bool                m_downScale;    // deliver half resolution frames
+    };
+
+    /*
+    *   Source of decoded frames for a camera.
+    *   A retrieved frame stays valid until the next Grab.
+    */
+    class FrameSource
+    {
+    public:
+    // Destructor
+    virtual ~FrameSource( ) {}
+
+    // Is the source ready to deliver frames
+    virtual bool IsOpened( ) const = 0;
+
+    // Advance to the next frame
+    virtual bool Grab( ) = 0;
+
+    // Get the grabbed frame as BGR, without a copy where possible
+    virtual bool Retrieve( cv::Mat& frame ) = 0;
+
+    // Close the source
+    virtual void Release( ) = 0;
+
+    // Scale of the delivered frames relative to the original video
+    virtual double GetScale( ) const { return 1.0; }
+
+    // Position the source so that the next Grab delivers the given frame
+    virtual bool Seek( const int frameIndex ) { return false; }
+
+    // Number of frames in the source, -1 if unknown
+    virtual int GetFrameCount( ) { return -1; }
+
+    // Capture time of the grabbed frame in seconds, -1 if unknown
+    virtual double GetTimestamp( ) { return -1.0; }
+    };
+
+    // declaration for shared pointer
+    typedef boost::shared_ptr<FrameSource> FrameSourcePtr;
+
+    /*
+    *   Video file decoded by cv::VideoCapture.
+    */
+    class VideoFileSource : public FrameSource
+    {
+    public:
+    // Constructor
+    explicit VideoFileSource( const std::string& fileName );
+
+    virtual bool IsOpened( ) const          { return m_videoCap.isOpened(); }
+    virtual bool Grab( )                    { return m_videoCap.grab(); }
+    virtual bool Retrieve( cv::Mat& frame ) { return m_videoCap.retrieve( frame ); }
+    virtual void Release( )                 { m_videoCap.release(); }
+    virtual bool Seek( const int frameIndex );
+    virtual int  GetFrameCount( );
+    virtual double GetTimestamp( )          { return m_videoCap.get( CV_CAP_PROP_POS_MSEC ) / 1000.0; }
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( VideoFileSource );
+
+    cv::VideoCapture                m_videoCap;
+    };
+
+    /*
+    *   Y4M or raw frames read from stdin, a named pipe or a file.
+    *   Reads block while the producer is behind, and the producer blocks
+    *   on the full pipe while the tracker is behind.
+    */
+    class StreamFrameSource : public FrameSource
+    {
+    public:
+    // Constructor, "-" reads from stdin; a NULL raw format expects Y4M
+    StreamFrameSource( const std::string&       streamName,
+                       const RawFrameFormat*    pRawFormat );
+
+    // Destructor
+    virtual ~StreamFrameSource( );
+
+    virtual bool IsOpened( ) const          { return m_pStream != NULL; }
+    virtual bool Grab( );
+    virtual bool Retrieve( cv::Mat& frame );
+    virtual void Release( );
+    virtual double GetTimestamp( );
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( StreamFrameSource );
+
+    // Parse the Y4M stream header
+    bool ReadY4MHeader( );
+
+    // Read exactly the requested number of bytes
+    bool ReadFully( void* pBuffer, const size_t size );
+
+    // Allocate the frame buffers for the configured format
+    void AllocateBuffers( );
+
+    FILE*                           m_pStream;
+    bool                            m_ownsStream;
+    bool                            m_y4m;
+    RawFrameFormat                  m_format;
+    double                          m_frameRate;        // from the Y4M header, 0 if unknown
+    int                             m_grabbedFrames;
+    cv::Mat                         m_planes;
+    cv::Mat                         m_frame;
+    bool                            m_converted;
+    };
+
+    /*
+    *   Frames published by a local process into a POSIX shared memory ring.
+    *
+    *   The segment starts with a SharedFrameRingHeader, followed by
+    *   slotCount slots of slotSize bytes at offset headerSize. The producer
+    *   writes frame n into slot n % slotCount and then increments
+    *   writeCount; it must wait while writeCount - readCount == slotCount.
+    *   The tracker increments readCount once it is done with a frame, so
+    *   frames are handed over in place and the producer is held back when
+    *   the ring is full. The producer sets closed at the end of the stream.
+    *
+    *   The counters and closed are shared between processes without a
+    *   lock and must be accessed atomically with acquire and release
+    *   ordering, e.g. __atomic_load_n / __atomic_store_n or the Interlocked
+    *   functions. The producer stores writeCount with release after writing
+    *   the slot, stores closed with release after the last writeCount, and
+    *   loads readCount with acquire before reusing a slot; the tracker does
+    *   the reverse. volatile alone does not order the accesses.
+    */
+    struct SharedFrameRingHeader
+    {
+        boost::uint32_t             m_magic;            // 'BTSR'
+        boost::uint32_t             m_version;          // 1
+        boost::uint32_t             m_width;
+        boost::uint32_t             m_height;
+        boost::uint32_t             m_channels;         // 1 or 3 ( BGR )
+        boost::uint32_t             m_slotCount;
+        boost::uint64_t             m_slotSize;
+        boost::uint64_t             m_headerSize;
+        volatile boost::uint64_t    m_writeCount;
+        volatile boost::uint64_t    m_readCount;
+        volatile boost::uint32_t    m_closed;
+    };
+
+    class SharedMemoryFrameSource : public FrameSource
+    {
+    public:
+    // Constructor
+    explicit SharedMemoryFrameSource( const std::string& segmentName );
+
+    // Destructor
+    virtual ~SharedMemoryFrameSource( );
+
+    virtual bool IsOpened( ) const          { return m_pHeader != NULL; }
+    virtual bool Grab( );
+    virtual bool Retrieve( cv::Mat& frame );
+    virtual void Release( );
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( SharedMemoryFrameSource );
+
+    // Hand the current slot back to the producer
+    void ReleaseSlot( );
+
+    class Mapping;
+
+    Mapping*                        m_pMapping;
+    SharedFrameRingHeader*          m_pHeader;
+    bool                            m_holdsSlot;
+    boost::uint64_t                 m_slotIndex;
+    cv::Mat                         m_convertedFrame;
+    };
+
+    // Create the source for a configured video name:
+    //      y4m:<path>  Y4M stream ( "-" for stdin )
+    //      raw:<path>  raw frames in the given format
+    //      shm:<name>  shared memory ring
+    //      otherwise   video file in the input directory
+    FrameSourcePtr  CreateFrameSource( const std::string&       sourceDirectory,
+                                       const std::string&       sourceName,
+                                       const RawFrameFormat&    rawFormat,
+                                       const DecoderSettings&   decoderSettings );
+
+    // Open a video file with the configured decoder
+    FrameSourcePtr  OpenVideoFile( const std::string&       fileName,
+                                   const DecoderSettings&   decoderSettings );
+
+    // Is the video name a y4m:, raw: or shm: stream
+    bool            IsStreamSource( const std::string& sourceName );
+
+    // Name used for the output files and windows of a source
+    std::string     GetSourceOutputName( const std::string& sourceName );
+}
+#endif
\ No newline at end of file
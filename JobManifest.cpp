@@ -0,0 +1,291 @@
+#include "JobManifest.h"
+#include "FrameSource.h"
+
+#include <sstream>
+#include <stdio.h>
+
+// whitespace separating the fields of a job line
+#define JOB_FIELD_SEPARATORS        " \t\r"
+
+namespace Tracker
+{
+    /********************************************************************
+    Constructor for class JobManifest
+    *********************************************************************/
+    JobManifest::JobManifest( const std::string&  videoDirectory,
+                              const int           defaultStartFrameIndex,
+                              const int           defaultEndFrameIndex )
+        : m_videoDirectory( videoDirectory ),
+        m_defaultStartFrameIndex( defaultStartFrameIndex ),
+        m_defaultEndFrameIndex( defaultEndFrameIndex ),
+        m_fileName( ),
+        m_file( ),
+        m_lineNumber( 0 ),
+        m_jobCount( 0 )
+    {
+    }
+
+    /********************************************************************
+    Destructor for class JobManifest
+    *********************************************************************/
+    JobManifest::~JobManifest( )
+    {
+    }
+
+    /*************************************************************************
+    Open
+        Open the manifest file
+    Exceptions
+        None
+    *************************************************************************/
+    void JobManifest::Open( const std::string& fileName )
+    {
+        m_fileName = fileName;
+        m_file.open( fileName.c_str() );
+        if ( !m_file.is_open() )
+        {
+            LOG_FILE( "Unable to open job manifest " + fileName );
+            AbortError( __LINE__, __FILE__, "Unable to open job manifest" );
+        }
+
+        m_lineNumber    = 0;
+        m_jobCount      = 0;
+    }
+
+    /*************************************************************************
+    NextJob
+        Read lines up to the next job
+    Exceptions
+        None
+    *************************************************************************/
+    bool JobManifest::NextJob( CameraJob& job )
+    {
+        std::string line;
+        while ( std::getline( m_file, line ) )
+        {
+            m_lineNumber++;
+
+            // skip comments and blank lines
+            const size_t pathStart = line.find_first_not_of( JOB_FIELD_SEPARATORS );
+            if ( pathStart == std::string::npos || line[pathStart] == '#' )
+            {
+                continue;
+            }
+
+            ParseJob( line.substr( pathStart, line.find_last_not_of( JOB_FIELD_SEPARATORS ) + 1 - pathStart ), job );
+            m_jobCount++;
+            return true;
+        }
+
+        return false;
+    }
+
+    /*************************************************************************
+    ParseJob
+        Parse the path, camera ID, frame range and profile of a job line
+    Exceptions
+        None
+    *************************************************************************/
+    void JobManifest::ParseJob( const std::string& line, CameraJob& job ) const
+    {
+        // the path, quoted when it has spaces
+        std::string path;
+        size_t      pathEnd;
+        if ( line[0] == '"' )
+        {
+            pathEnd = line.find( '"', 1 );
+            if ( pathEnd == std::string::npos )
+            {
+                InvalidLine( "unterminated quote" );
+            }
+            path = line.substr( 1, pathEnd - 1 );
+            pathEnd++;
+        }
+        else
+        {
+            pathEnd = line.find_first_of( JOB_FIELD_SEPARATORS );
+            path = line.substr( 0, pathEnd );
+        }
+
+        std::istringstream fields( pathEnd < line.size() ? line.substr( pathEnd ) : std::string() );
+
+        std::string cameraId;
+        std::string range;
+        std::string extra;
+        job.m_profileName.clear();
+        fields >> cameraId >> range >> job.m_profileName >> extra;
+        if ( path.empty() || cameraId.empty() || !extra.empty() )
+        {
+            InvalidLine( "expected <path> <camera ID> [<start>:<end> | -] [<profile>]" );
+        }
+
+        char trailing;
+        if ( sscanf( cameraId.c_str(), "%d%c", &job.m_cameraId, &trailing ) != 1 )
+        {
+            InvalidLine( "invalid camera ID " + cameraId );
+        }
+
+        if ( range.empty() || range == "-" )
+        {
+            job.m_startFrameIndex   = m_defaultStartFrameIndex;
+            job.m_endFrameIndex     = m_defaultEndFrameIndex;
+        }
+        else if ( sscanf( range.c_str(), "%d:%d%c", &job.m_startFrameIndex, &job.m_endFrameIndex, &trailing ) != 2 ||
+                  job.m_startFrameIndex < 0 ||
+                  ( job.m_endFrameIndex >= 0 && job.m_endFrameIndex <= job.m_startFrameIndex ) )
+        {
+            InvalidLine( "invalid frame range " + range );
+        }
+
+        // stream sources are kept as they are, absolute paths keep their directory
+        const bool absolutePath = path[0] == '/' || path[0] == '\\' || ( path.size() > 1 && path[1] == ':' );
+        if ( !IsStreamSource( path ) && absolutePath )
+        {
+            const size_t separator = path.find_last_of( "/\\" );
+            job.m_videoDirectory    = ( separator == 0 ) ? path.substr( 0, 1 ) : path.substr( 0, separator );
+            job.m_videoFileName     = path.substr( separator + 1 );
+        }
+        else
+        {
+            job.m_videoDirectory    = m_videoDirectory;
+            job.m_videoFileName     = path;
+        }
+
+        // outputs of videos of the same name in different directories must not collide
+        if ( IsStreamSource( path ) )
+        {
+            job.m_outputName = GetSourceOutputName( path );
+        }
+        else
+        {
+            const size_t nameStart = path.find_first_not_of( "/\\" );
+            job.m_outputName = ( nameStart == std::string::npos ) ? path : path.substr( nameStart );
+            for ( size_t i = 0; i < job.m_outputName.size(); i++ )
+            {
+                if ( job.m_outputName[i] == '/' || job.m_outputName[i] == '\\' || job.m_outputName[i] == ':' )
+                {
+                    job.m_outputName[i] = '_';
+                }
+            }
+        }
+
+        // nor those of jobs on the same video with another camera, range or profile
+        std::ostringstream outputName;
+        outputName << job.m_outputName << "_cam" << job.m_cameraId;
+        if ( !range.empty() && range != "-" )
+        {
+            outputName << '_' << job.m_startFrameIndex << '-';
+            if ( job.m_endFrameIndex < 0 )
+            {
+                outputName << "end";
+            }
+            else
+            {
+                outputName << job.m_endFrameIndex;
+            }
+        }
+        if ( !job.m_profileName.empty() )
+        {
+            outputName << '_' << job.m_profileName;
+        }
+        job.m_outputName = outputName.str();
+
+        job.m_lineNumber    = m_lineNumber;
+        job.m_line          = line;
+    }
+
+    /*************************************************************************
+    InvalidLine
+        Report the current line of the manifest and abort
+    Exceptions
+        None
+    *************************************************************************/
+    void JobManifest::InvalidLine( const std::string& reason ) const
+    {
+        LOG_FILE( m_fileName << " line " << m_lineNumber << ": " << reason );
+        AbortError( __LINE__, __FILE__, "Invalid line in job manifest" );
+    }
+
+    /*************************************************************************
+    CreateJobCamera
+        Create the camera of a job with the settings of its profile; the
+        camera is initialized when it starts
+    Exceptions
+        None
+    *************************************************************************/
+    CameraPtr CreateJobCamera( const CameraJob&           job,
+                               const PipelineProfiles&    profiles,
+                               const bool                 hideWindows )
+    {
+        InputParameters settings = job.m_profileName.empty() ? profiles.GetSettings( job.m_cameraId )
+                                                             : profiles.GetProfileSettings( job.m_profileName );
+
+        if ( hideWindows )
+        {
+            settings.m_displayIntermediateResult = 0;
+        }
+
+        CameraPtr pCamera( new Camera( job.m_videoDirectory, job.m_videoFileName ) );
+        pCamera->SetCameraId( job.m_cameraId );
+        pCamera->ApplySettings( settings );
+        pCamera->SetOutputName( job.m_outputName );
+
+        LOG_FILE( "Job " << job.m_lineNumber << ": camera " << job.m_cameraId << " " << job.m_videoFileName <<
+                  ( job.m_profileName.empty() ? std::string() : " with profile " + job.m_profileName ) );
+        return pCamera;
+    }
+
+    /********************************************************************
+    Constructor for class ManifestCameras
+    *********************************************************************/
+    ManifestCameras::ManifestCameras( JobManifest&               manifest,
+                                      const PipelineProfiles&    profiles,
+                                      const bool                 hideWindows )
+        : m_manifest( manifest ),
+        m_profiles( profiles ),
+        m_hideWindows( hideWindows )
+    {
+    }
+
+    /********************************************************************
+    Destructor for class ManifestCameras
+    *********************************************************************/
+    ManifestCameras::~ManifestCameras( )
+    {
+    }
+
+    /*************************************************************************
+    NextCamera
+        Create the camera of the next job
+    Exceptions
+        None
+    *************************************************************************/
+    bool ManifestCameras::NextCamera( CameraPtr&     pCamera,
+                                      int&           startFrameIndex,
+                                      int&           endFrameIndex )
+    {
+        CameraJob job;
+        if ( !m_manifest.NextJob( job ) )
+        {
+            LOG_FILE( "Read " << m_manifest.GetJobCount() << " jobs from the job manifest" );
+            return false;
+        }
+
+        // windows cannot be driven from the scheduler workers
+        pCamera         = CreateJobCamera( job, m_profiles, m_hideWindows );
+        startFrameIndex = job.m_startFrameIndex;
+        endFrameIndex   = job.m_endFrameIndex;
+        return true;
+    }
+
+    /*************************************************************************
+    CameraFinished
+        Release the metrics of an ended camera
+    Exceptions
+        None
+    *************************************************************************/
+    void ManifestCameras::CameraFinished( const CameraPtr& pCamera )
+    {
+        pCamera->ReleaseMetrics( );
+    }
+}
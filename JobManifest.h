@@ -0,0 +1,127 @@
+#ifndef JOB_MANIFEST_H
+#define JOB_MANIFEST_H
+
+#include "Camera.h"
+#include "Profiles.h"
+#include "Scheduler.h"
+
+#include <fstream>
+#include <string>
+
+namespace Tracker
+{
+    /*
+    *   One line of a job manifest: a video, the ID of its camera, the
+    *   frames to process and an optional pipeline profile.
+    */
+    struct CameraJob
+    {
+        CameraJob( )
+            : m_videoDirectory( ),
+            m_videoFileName( ),
+            m_outputName( ),
+            m_cameraId( 0 ),
+            m_startFrameIndex( 0 ),
+            m_endFrameIndex( -1 ),
+            m_profileName( ),
+            m_lineNumber( 0 ),
+            m_line( )
+        {
+        }
+
+        std::string         m_videoDirectory;
+        std::string         m_videoFileName;
+        std::string         m_outputName;
+        int                 m_cameraId;
+        int                 m_startFrameIndex;
+        int                 m_endFrameIndex;        // -1 for the end of the video
+        std::string         m_profileName;          // empty for the profile of the camera ID
+        int                 m_lineNumber;
+        std::string         m_line;                 // the job as written in the manifest
+    };
+
+    /*
+    *   Reads the jobs of a manifest file one at a time, so that a
+    *   manifest of any length is never held in memory. Each line is
+    *       <path> <camera ID> [<start>:<end> | -] [<profile>]
+    *   A path with spaces is quoted; relative paths are taken from the
+    *   video directory. Blank lines and lines starting with # are
+    *   skipped.
+    */
+    class JobManifest
+    {
+    public:
+    // Constructor, jobs without a frame range use the default one
+    JobManifest( const std::string&  videoDirectory,
+                 const int           defaultStartFrameIndex,
+                 const int           defaultEndFrameIndex );
+
+    // Destructor
+    ~JobManifest( );
+
+    // Open the manifest file
+    void Open( const std::string& fileName );
+
+    // Read the next job, false at the end of the manifest
+    bool NextJob( CameraJob& job );
+
+    // Parse one job line, also of a job handed over without a manifest
+    void ParseJob( const std::string& line, CameraJob& job ) const;
+
+    // Jobs read so far
+    int  GetJobCount( ) const                       { return m_jobCount; }
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( JobManifest );
+
+    // Report an invalid line and abort
+    void InvalidLine( const std::string& reason ) const;
+
+    std::string                     m_videoDirectory;
+    int                             m_defaultStartFrameIndex;
+    int                             m_defaultEndFrameIndex;
+    std::string                     m_fileName;
+    std::ifstream                   m_file;
+    int                             m_lineNumber;
+    int                             m_jobCount;
+    };
+
+    // Create the camera of a job with the settings of its profile;
+    // hideWindows turns the display off
+    CameraPtr CreateJobCamera( const CameraJob&           job,
+                               const PipelineProfiles&    profiles,
+                               const bool                 hideWindows );
+
+    /*
+    *   Creates the camera of each manifest job as the scheduler asks for
+    *   it, with the settings of its profile, and releases the metrics of
+    *   the cameras that have ended.
+    */
+    class ManifestCameras : public CameraSource
+    {
+    public:
+    // Constructor; hideWindows turns the display off for the scheduler workers
+    ManifestCameras( JobManifest&               manifest,
+                     const PipelineProfiles&    profiles,
+                     const bool                 hideWindows );
+
+    // Destructor
+    virtual ~ManifestCameras( );
+
+    virtual bool NextCamera( CameraPtr&     pCamera,
+                             int&           startFrameIndex,
+                             int&           endFrameIndex );
+
+    virtual void CameraFinished( const CameraPtr& pCamera );
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( ManifestCameras );
+
+    JobManifest&                    m_manifest;
+    const PipelineProfiles&         m_profiles;
+    bool                            m_hideWindows;
+    };
+}
+#endif
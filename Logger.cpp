@@ -0,0 +1,433 @@
+#include "Logger.h"
+
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+
+#include <algorithm>
+#include <string.h>
+
+// bytes buffered per thread, a power of two
+#define LOG_BUFFER_SIZE             ( 64 * 1024 )
+
+// longest message kept, longer ones are truncated
+#define LOG_MAX_MESSAGE_SIZE        4096
+
+// interval at which the flusher writes out the buffers
+#define LOG_FLUSH_INTERVAL_MS       50
+
+namespace Tracker
+{
+    /*
+    *   Header of a queued message, followed by the message text.
+    */
+    struct LogMessageHeader
+    {
+        boost::uint32_t             m_length;
+        boost::uint16_t             m_level;
+        boost::uint16_t             m_targets;
+        boost::int32_t              m_cameraId;
+        boost::uint32_t             m_reserved;
+        boost::int64_t              m_time;             // microseconds since the logger started
+    };
+
+    /*
+    *   Single producer, single consumer ring of messages. The owning
+    *   thread appends at the head and the flusher consumes at the tail.
+    */
+    class LogBuffer
+    {
+    public:
+    LogBuffer( )
+        : m_released( false ),
+        m_cameraId( -1 ),
+        m_stream( ),
+        m_head( 0 ),
+        m_tail( 0 )
+    {
+    }
+
+    // Append a message, fails when the ring is full
+    bool Push( const LogMessageHeader& header, const char* pText )
+    {
+        const boost::uint32_t head = m_head.load( boost::memory_order_relaxed );
+        const boost::uint32_t tail = m_tail.load( boost::memory_order_acquire );
+
+        if ( LOG_BUFFER_SIZE - ( head - tail ) < sizeof(header) + header.m_length )
+        {
+            return false;
+        }
+
+        Write( head, &header, sizeof(header) );
+        Write( head + sizeof(header), pText, header.m_length );
+        m_head.store( head + sizeof(header) + header.m_length, boost::memory_order_release );
+        return true;
+    }
+
+    // Take the next message, fails when the ring is empty
+    bool Pop( LogMessageHeader& header, std::vector<char>& text )
+    {
+        const boost::uint32_t tail = m_tail.load( boost::memory_order_relaxed );
+        const boost::uint32_t head = m_head.load( boost::memory_order_acquire );
+
+        if ( head == tail )
+        {
+            return false;
+        }
+
+        Read( tail, &header, sizeof(header) );
+        text.resize( header.m_length );
+        if ( header.m_length > 0 )
+        {
+            Read( tail + sizeof(header), &text[0], header.m_length );
+        }
+        m_tail.store( tail + sizeof(header) + header.m_length, boost::memory_order_release );
+        return true;
+    }
+
+    bool IsEmpty( ) const
+    {
+        return m_head.load( boost::memory_order_acquire ) == m_tail.load( boost::memory_order_acquire );
+    }
+
+    boost::atomic<bool>             m_released;     // the owning thread has exited
+    int                             m_cameraId;
+    std::ostringstream              m_stream;
+
+    private:
+
+    void Write( const boost::uint32_t position, const void* pData, const size_t size )
+    {
+        const size_t offset = position & ( LOG_BUFFER_SIZE - 1 );
+        const size_t first  = std::min( size, (size_t)LOG_BUFFER_SIZE - offset );
+        memcpy( m_data + offset, pData, first );
+        memcpy( m_data, static_cast<const char*>( pData ) + first, size - first );
+    }
+
+    void Read( const boost::uint32_t position, void* pData, const size_t size ) const
+    {
+        const size_t offset = position & ( LOG_BUFFER_SIZE - 1 );
+        const size_t first  = std::min( size, (size_t)LOG_BUFFER_SIZE - offset );
+        memcpy( pData, m_data + offset, first );
+        memcpy( static_cast<char*>( pData ) + first, m_data, size - first );
+    }
+
+    boost::atomic<boost::uint32_t>  m_head;
+    boost::atomic<boost::uint32_t>  m_tail;
+    char                            m_data[LOG_BUFFER_SIZE];
+    };
+
+    /********************************************************************
+    ReleaseThreadBuffer
+        Called at thread exit; the flusher deletes the buffer once empty
+    Exceptions:
+        None
+    *********************************************************************/
+    static void ReleaseThreadBuffer( LogBuffer* pBuffer )
+    {
+        pBuffer->m_released.store( true, boost::memory_order_release );
+    }
+
+    /********************************************************************
+    Instance
+        The logger is created on first use
+    Exceptions:
+        None
+    *********************************************************************/
+    Logger& Logger::Instance( )
+    {
+        static Logger logger;
+        return logger;
+    }
+
+    /********************************************************************
+    Logger
+        Starts the flusher thread
+    Exceptions:
+        None
+    *********************************************************************/
+    Logger::Logger( )
+        : m_level( LOG_LEVEL_INFO ),
+        m_startTime( boost::posix_time::microsec_clock::universal_time() ),
+        m_threadBuffer( ReleaseThreadBuffer ),
+        m_buffers( ),
+        m_pFile( NULL ),
+        m_line( ),
+        m_droppedMessages( 0 ),
+        m_stopping( false ),
+        m_flusher( )
+    {
+        m_flusher = boost::thread( boost::bind( &Logger::FlusherLoop, this ) );
+    }
+
+    /********************************************************************
+    Default Destructor for class Logger
+    *********************************************************************/
+    Logger::~Logger( )
+    {
+        Close( );
+
+        // the buffers are deleted here, not by the thread exit cleanup
+        m_threadBuffer.release();
+
+        for ( unsigned int i = 0; i < m_buffers.size(); i++ )
+        {
+            delete m_buffers[i];
+        }
+    }
+
+    /********************************************************************
+    Open
+        Opens the log file for the file messages
+    Exceptions:
+        None
+    *********************************************************************/
+    void Logger::Open( const std::string& fileName )
+    {
+        boost::mutex::scoped_lock lock( m_drainMutex );
+
+        if ( m_pFile != NULL )
+        {
+            fclose( m_pFile );
+        }
+        m_pFile = fopen( fileName.c_str(), "w" );
+    }
+
+    /********************************************************************
+    Close
+        Stops the flusher, writes the pending messages and closes the file
+    Exceptions:
+        None
+    *********************************************************************/
+    void Logger::Close( )
+    {
+        {
+            boost::mutex::scoped_lock lock( m_flusherMutex );
+            m_stopping = true;
+        }
+        m_flusherCondition.notify_all();
+
+        if ( m_flusher.joinable() )
+        {
+            m_flusher.join();
+        }
+
+        Drain( );
+
+        boost::mutex::scoped_lock lock( m_drainMutex );
+        if ( m_pFile != NULL )
+        {
+            fclose( m_pFile );
+            m_pFile = NULL;
+        }
+    }
+
+    /********************************************************************
+    Flush
+        Writes the pending messages from the calling thread
+    Exceptions:
+        None
+    *********************************************************************/
+    void Logger::Flush( )
+    {
+        Drain( );
+    }
+
+    /********************************************************************
+    GetThreadBuffer
+        Registers a buffer for a thread on its first message
+    Exceptions:
+        None
+    *********************************************************************/
+    LogBuffer& Logger::GetThreadBuffer( )
+    {
+        LogBuffer* pBuffer = m_threadBuffer.get();
+        if ( pBuffer == NULL )
+        {
+            pBuffer = new LogBuffer( );
+            m_threadBuffer.reset( pBuffer );
+
+            boost::mutex::scoped_lock lock( m_buffersMutex );
+            m_buffers.push_back( pBuffer );
+        }
+        return *pBuffer;
+    }
+
+    /********************************************************************
+    SetThreadCameraId / GetThreadCameraId
+        Camera tag of the messages of the calling thread
+    Exceptions:
+        None
+    *********************************************************************/
+    void Logger::SetThreadCameraId( const int cameraId )
+    {
+        GetThreadBuffer().m_cameraId = cameraId;
+    }
+
+    int Logger::GetThreadCameraId( )
+    {
+        return GetThreadBuffer().m_cameraId;
+    }
+
+    /********************************************************************
+    BeginMessage
+        Returns the emptied stream of the calling thread
+    Exceptions:
+        None
+    *********************************************************************/
+    std::ostream& Logger::BeginMessage( )
+    {
+        LogBuffer& buffer = GetThreadBuffer();
+        buffer.m_stream.str( "" );
+        buffer.m_stream.clear();
+        return buffer.m_stream;
+    }
+
+    /********************************************************************
+    EndMessage
+        Queues the streamed message in the buffer of the calling thread
+    Exceptions:
+        None
+    *********************************************************************/
+    void Logger::EndMessage( const int level,
+                             const int targets )
+    {
+        LogBuffer& buffer = GetThreadBuffer();
+        const std::string text = buffer.m_stream.str();
+
+        LogMessageHeader header;
+        header.m_length     = (boost::uint32_t)std::min( text.size(), (size_t)LOG_MAX_MESSAGE_SIZE );
+        header.m_level      = (boost::uint16_t)level;
+        header.m_targets    = (boost::uint16_t)targets;
+        header.m_cameraId   = buffer.m_cameraId;
+        header.m_reserved   = 0;
+        header.m_time       = ( boost::posix_time::microsec_clock::universal_time() - m_startTime ).total_microseconds();
+
+        while ( !buffer.Push( header, text.data() ) )
+        {
+            // only errors are worth waiting for
+            if ( level < LOG_LEVEL_ERROR )
+            {
+                m_droppedMessages.fetch_add( 1, boost::memory_order_relaxed );
+                return;
+            }
+            Drain( );
+        }
+    }
+
+    /********************************************************************
+    Drain
+        Writes the messages of all buffers and deletes the buffers of
+        exited threads. Only one thread drains at a time.
+    Exceptions:
+        None
+    *********************************************************************/
+    void Logger::Drain( )
+    {
+        boost::mutex::scoped_lock drainLock( m_drainMutex );
+
+        std::vector<LogBuffer*> buffers;
+        {
+            boost::mutex::scoped_lock lock( m_buffersMutex );
+            buffers = m_buffers;
+        }
+
+        static const char* levelNames[] = { "DEBUG", "INFO", "WARNING", "ERROR" };
+
+        LogMessageHeader    header;
+        std::vector<char>   text;
+        bool                written = false;
+
+        for ( unsigned int i = 0; i < buffers.size(); i++ )
+        {
+            while ( buffers[i]->Pop( header, text ) )
+            {
+                written = true;
+
+                if ( ( header.m_targets & LOG_TARGET_FILE ) && m_pFile != NULL )
+                {
+                    char prefix[64];
+                    if ( header.m_cameraId >= 0 )
+                    {
+                        sprintf( prefix, "%10.3f %-7s [cam %02d] ", header.m_time / 1e6, levelNames[header.m_level & 3], header.m_cameraId );
+                    }
+                    else
+                    {
+                        sprintf( prefix, "%10.3f %-7s ", header.m_time / 1e6, levelNames[header.m_level & 3] );
+                    }
+
+                    m_line.assign( prefix );
+                    m_line.append( text.begin(), text.end() );
+                    m_line.push_back( '\n' );
+                    fwrite( m_line.data(), m_line.size(), 1, m_pFile );
+                }
+
+                if ( header.m_targets & LOG_TARGET_CONSOLE )
+                {
+                    if ( !text.empty() )
+                    {
+                        fwrite( &text[0], text.size(), 1, stdout );
+                    }
+                    fputc( '\n', stdout );
+                }
+            }
+        }
+
+        const unsigned int droppedMessages = m_droppedMessages.exchange( 0, boost::memory_order_relaxed );
+        if ( droppedMessages > 0 && m_pFile != NULL )
+        {
+            fprintf( m_pFile, "%u log messages dropped\n", droppedMessages );
+            written = true;
+        }
+
+        if ( written )
+        {
+            if ( m_pFile != NULL )
+            {
+                fflush( m_pFile );
+            }
+            fflush( stdout );
+        }
+
+        // forget the buffers of exited threads once they are empty
+        boost::mutex::scoped_lock lock( m_buffersMutex );
+        for ( std::vector<LogBuffer*>::iterator it = m_buffers.begin(); it != m_buffers.end(); )
+        {
+            if ( (*it)->m_released.load( boost::memory_order_acquire ) && (*it)->IsEmpty() )
+            {
+                delete *it;
+                it = m_buffers.erase( it );
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    /********************************************************************
+    FlusherLoop
+        Drains the buffers every LOG_FLUSH_INTERVAL_MS until closed
+    Exceptions:
+        None
+    *********************************************************************/
+    void Logger::FlusherLoop( )
+    {
+        for ( ;; )
+        {
+            {
+                boost::mutex::scoped_lock lock( m_flusherMutex );
+                if ( !m_stopping )
+                {
+                    m_flusherCondition.timed_wait( lock, boost::posix_time::milliseconds( LOG_FLUSH_INTERVAL_MS ) );
+                }
+                if ( m_stopping )
+                {
+                    return;
+                }
+            }
+
+            Drain( );
+        }
+    }
+}
@@ -0,0 +1,147 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+// severity levels
+#define LOG_LEVEL_DEBUG             0
+#define LOG_LEVEL_INFO              1
+#define LOG_LEVEL_WARNING           2
+#define LOG_LEVEL_ERROR             3
+
+// messages below this level are compiled out
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL           LOG_LEVEL_INFO
+#endif
+
+// destinations of a message
+#define LOG_TARGET_FILE             1
+#define LOG_TARGET_CONSOLE          2
+
+namespace Tracker
+{
+    class LogBuffer;
+
+    /*
+    *   Asynchronous logger. Each thread formats its messages into its own
+    *   lock-free buffer and a background thread writes them out, so the
+    *   logging thread never waits on the disk. Messages that do not fit
+    *   into a full buffer are dropped and counted, except errors, which
+    *   wait for the flusher.
+    */
+    class Logger
+    {
+    public:
+    // The process wide logger
+    static Logger& Instance( );
+
+    // Start writing file messages to the log file
+    void Open( const std::string& fileName );
+
+    // Write the pending messages and close the log file
+    void Close( );
+
+    // Write the pending messages of all threads now
+    void Flush( );
+
+    // Messages below the level are ignored
+    void SetLevel( const int level )    { m_level = level; }
+    int  GetLevel( ) const              { return m_level; }
+
+    // Camera whose ID tags the messages of the calling thread, -1 for none
+    void SetThreadCameraId( const int cameraId );
+    int  GetThreadCameraId( );
+
+    // Stream of the calling thread for the next message
+    std::ostream&   BeginMessage( );
+
+    // Queue the streamed message
+    void            EndMessage( const int level,
+                                const int targets );
+
+    private:
+
+    // Constructor
+    Logger( );
+
+    // Destructor
+    ~Logger( );
+
+    // Disallow copies
+    Logger( const Logger& );
+    Logger& operator=( const Logger& );
+
+    // Buffer of the calling thread, created on first use
+    LogBuffer&  GetThreadBuffer( );
+
+    // Write the messages of all buffers
+    void        Drain( );
+
+    // Drain the buffers periodically until closed
+    void        FlusherLoop( );
+
+    volatile int                            m_level;
+    boost::posix_time::ptime                m_startTime;
+    boost::thread_specific_ptr<LogBuffer>   m_threadBuffer;
+
+    boost::mutex                            m_buffersMutex;
+    std::vector<LogBuffer*>                 m_buffers;
+
+    boost::mutex                            m_drainMutex;
+    FILE*                                   m_pFile;
+    std::string                             m_line;
+
+    boost::atomic<unsigned int>             m_droppedMessages;
+
+    boost::mutex                            m_flusherMutex;
+    boost::condition_variable               m_flusherCondition;
+    bool                                    m_stopping;
+    boost::thread                           m_flusher;
+    };
+
+    /*
+    *   Tags the log messages of the calling thread with a camera ID for
+    *   the lifetime of the object.
+    */
+    class LogCameraScope
+    {
+    public:
+    explicit LogCameraScope( const int cameraId )
+        : m_previousCameraId( Logger::Instance().GetThreadCameraId() )
+    {
+        Logger::Instance().SetThreadCameraId( cameraId );
+    }
+
+    ~LogCameraScope( )
+    {
+        Logger::Instance().SetThreadCameraId( m_previousCameraId );
+    }
+
+    private:
+
+    LogCameraScope( const LogCameraScope& );
+    LogCameraScope& operator=( const LogCameraScope& );
+
+    int                             m_previousCameraId;
+    };
+}
+
+// LOG MESSAGE at a level to the given targets
+#define LOG_MESSAGE( level, targets, context )                                                  \
+do                                                                                              \
+{                                                                                               \
+    if ( (level) >= LOG_COMPILE_LEVEL && (level) >= Tracker::Logger::Instance().GetLevel() )   \
+    {                                                                                           \
+        Tracker::Logger::Instance().BeginMessage() << context;                                  \
+        Tracker::Logger::Instance().EndMessage( (level), (targets) );                           \
+    }                                                                                           \
+} while ( 0 )
+
+#endif
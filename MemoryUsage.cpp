@@ -0,0 +1,139 @@
+#include "MemoryUsage.h"
+
+#include <stdio.h>
+
+#if defined(WIN32) || defined(WIN64)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment( lib, "psapi.lib" )
+#else
+#include <unistd.h>
+#endif
+
+// FG_0 and FG_0S ( CvFGDStatModel ): per pixel 25 color and 40 color
+// co-occurrence statistics of 12 and 16 bytes, the pixel header and
+// about ten working images
+#define FGD_MODEL_BYTES_PER_PIXEL           1000
+
+// FG_1 ( CvGaussBGModel ): per pixel 5 Gaussians of 64 bytes and the
+// working images
+#define MOG_MODEL_BYTES_PER_PIXEL           330
+
+// FG_MOG2: per pixel 5 modes of a weight, a variance and 3 means in
+// floats, the mode count and the masks
+#define MOG2_MODEL_BYTES_PER_PIXEL          110
+
+// other detectors keep a background image and a few masks
+#define DEFAULT_MODEL_BYTES_PER_PIXEL       16
+
+// mean shift and particle trackers keep color histograms, kernel
+// weights and particles per blob; CC trackers little more than the blob
+#define MS_TRACKER_BYTES_PER_BLOB           65536
+#define CC_TRACKER_BYTES_PER_BLOB           1024
+
+// analyzers keep the feature vectors of the tracks and the touched
+// histogram bins, both growing with the tracked blob frames
+#define ANALYSIS_BYTES_PER_BLOB_FRAME       48
+
+namespace Tracker
+{
+    /********************************************************************
+    GetMatBytes
+        Bytes of the pixel buffer of an image
+    Exceptions:
+        None
+    *********************************************************************/
+    size_t GetMatBytes( const cv::Mat& image )
+    {
+        return image.empty() ? 0 : image.total() * image.elemSize();
+    }
+
+    /********************************************************************
+    EstimateFGModelBytes
+        Background model size from the per-pixel model of the module
+    Exceptions:
+        None
+    *********************************************************************/
+    size_t EstimateFGModelBytes( const std::string&  moduleName,
+                                 const int           width,
+                                 const int           height )
+    {
+        const size_t pixels = (size_t)width * height;
+
+        if ( moduleName == "FG_0" || moduleName == "FG_0S" )
+        {
+            return pixels * FGD_MODEL_BYTES_PER_PIXEL;
+        }
+        if ( moduleName == "FG_1" )
+        {
+            return pixels * MOG_MODEL_BYTES_PER_PIXEL;
+        }
+        if ( moduleName == "FG_MOG2" )
+        {
+            return pixels * MOG2_MODEL_BYTES_PER_PIXEL;
+        }
+        return pixels * DEFAULT_MODEL_BYTES_PER_PIXEL;
+    }
+
+    /********************************************************************
+    EstimateTrackerBytes
+        Tracker state from the number of tracked blobs
+    Exceptions:
+        None
+    *********************************************************************/
+    size_t EstimateTrackerBytes( const std::string&  moduleName,
+                                 const int           blobCount )
+    {
+        if ( moduleName == "CC" )
+        {
+            return (size_t)blobCount * CC_TRACKER_BYTES_PER_BLOB;
+        }
+        return (size_t)blobCount * MS_TRACKER_BYTES_PER_BLOB;
+    }
+
+    /********************************************************************
+    EstimateAnalysisBytes
+        Analysis state from the blob frames it has seen
+    Exceptions:
+        None
+    *********************************************************************/
+    size_t EstimateAnalysisBytes( const std::string& moduleName,
+                                  const int          blobFrames )
+    {
+        if ( moduleName.empty() || moduleName == "None" )
+        {
+            return 0;
+        }
+        return (size_t)blobFrames * ANALYSIS_BYTES_PER_BLOB_FRAME;
+    }
+
+    /********************************************************************
+    GetProcessResidentBytes
+        Resident set of the process from the operating system
+    Exceptions:
+        None
+    *********************************************************************/
+    size_t GetProcessResidentBytes( )
+    {
+#if defined(WIN32) || defined(WIN64)
+        PROCESS_MEMORY_COUNTERS counters;
+        if ( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof(counters) ) )
+        {
+            return counters.WorkingSetSize;
+        }
+        return 0;
+#else
+        FILE* pStatm = fopen( "/proc/self/statm", "r" );
+        if ( pStatm == NULL )
+        {
+            return 0;
+        }
+
+        unsigned long totalPages = 0, residentPages = 0;
+        const int fields = fscanf( pStatm, "%lu %lu", &totalPages, &residentPages );
+        fclose( pStatm );
+
+        return fields == 2 ? (size_t)residentPages * sysconf( _SC_PAGESIZE ) : 0;
+#endif
+    }
+}
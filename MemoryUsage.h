@@ -0,0 +1,59 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include "OpenCvDefinitions.h"
+
+#include <string>
+#include <stddef.h>
+
+namespace Tracker
+{
+    /*
+    *   Memory of a camera by module. Frames and output buffers are
+    *   counted exactly; the state of the legacy OpenCV modules is opaque
+    *   and estimated from the sizes of their models with the default
+    *   parameters.
+    */
+    struct MemoryUsage
+    {
+        MemoryUsage( )
+            : m_frameBytes( 0 ),
+            m_fgModelBytes( 0 ),
+            m_trackerBytes( 0 ),
+            m_analysisBytes( 0 ),
+            m_outputBytes( 0 )
+        {
+        }
+
+        size_t GetTotalBytes( ) const
+        {
+            return m_frameBytes + m_fgModelBytes + m_trackerBytes + m_analysisBytes + m_outputBytes;
+        }
+
+        size_t              m_frameBytes;       // frames, masks and motion field
+        size_t              m_fgModelBytes;     // background model ( estimate )
+        size_t              m_trackerBytes;     // blob tracker state ( estimate )
+        size_t              m_analysisBytes;    // trajectory analysis ( estimate )
+        size_t              m_outputBytes;      // crop buffers
+    };
+
+    // Bytes of the pixel buffer of an image
+    size_t  GetMatBytes( const cv::Mat& image );
+
+    // Estimated background model size of a FG detection module
+    size_t  EstimateFGModelBytes( const std::string&  moduleName,
+                                  const int           width,
+                                  const int           height );
+
+    // Estimated state of a blob tracker module tracking the blobs
+    size_t  EstimateTrackerBytes( const std::string&  moduleName,
+                                  const int           blobCount );
+
+    // Estimated state of an analysis module after the tracked blob frames
+    size_t  EstimateAnalysisBytes( const std::string& moduleName,
+                                   const int          blobFrames );
+
+    // Resident memory of the process, 0 if unknown
+    size_t  GetProcessResidentBytes( );
+}
+#endif
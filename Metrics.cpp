@@ -0,0 +1,493 @@
+#include "Metrics.h"
+#include "CommonMacros.h"
+
+#include <boost/asio.hpp>
+#include <boost/bind.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <stdio.h>
+
+#if defined(WIN32) || defined(WIN64)
+#include <windows.h>
+#endif
+
+// largest request read from a client
+#define METRICS_REQUEST_SIZE        1024
+
+// counters exported per camera
+#define METRIC_COUNT                15
+
+namespace Tracker
+{
+    /*
+    *   Name, type and help of an exported metric.
+    */
+    struct MetricFamily
+    {
+        const char*         m_name;
+        const char*         m_type;
+        const char*         m_help;
+    };
+
+    static const MetricFamily g_metricFamilies[METRIC_COUNT] =
+    {
+        { "blobtracker_frame_number",               "gauge",    "Last frame number read" },
+        { "blobtracker_frames_processed_total",     "counter",  "Frames run through the tracker" },
+        { "blobtracker_frames_shed_total",          "counter",  "Frames processed without overlays and crops" },
+        { "blobtracker_frames_dropped_total",       "counter",  "Frames dropped without detection while the tracks coasted" },
+        { "blobtracker_fps",                        "gauge",    "Frames processed, dropped or idle per second over the last interval" },
+        { "blobtracker_active_blobs",               "gauge",    "Blobs tracked in the last frame" },
+        { "blobtracker_crop_queue_depth",           "gauge",    "Crops waiting for the encoders" },
+        { "blobtracker_decode_seconds_total",       "counter",  "Time spent grabbing and decoding frames" },
+        { "blobtracker_tracking_seconds_total",     "counter",  "Time spent in detection and tracking" },
+        { "blobtracker_output_seconds_total",       "counter",  "Time spent on records, crops, overlays and saved videos" },
+        { "blobtracker_lag_seconds",                "gauge",    "Lag behind the capture clock in the real-time mode" },
+        { "blobtracker_memory_bytes",               "gauge",    "Accounted memory of the camera" },
+        { "blobtracker_shedding_level",             "gauge",    "Load shedding level of the real-time mode" },
+        { "blobtracker_memory_level",               "gauge",    "Degradation level of the memory budget" },
+        { "blobtracker_frames_idle_total",          "counter",  "Frames that skipped the pipeline as the scene was static" }
+    };
+
+    /********************************************************************
+    EscapeLabel
+        Escapes a Prometheus label value
+    Exceptions:
+        None
+    *********************************************************************/
+    static std::string EscapeLabel( const std::string& value )
+    {
+        std::string escaped;
+        for ( unsigned int i = 0; i < value.size(); i++ )
+        {
+            if ( value[i] == '\\' || value[i] == '"' )
+            {
+                escaped.push_back( '\\' );
+            }
+            escaped.push_back( value[i] == '\n' ? ' ' : value[i] );
+        }
+        return escaped;
+    }
+
+    /*
+    *   One HTTP request on the metrics port, answered with the last
+    *   sampled metrics and closed.
+    */
+    class MetricsConnection : public boost::enable_shared_from_this<MetricsConnection>
+    {
+    public:
+    MetricsConnection( boost::asio::io_service& ioService, Metrics& metrics )
+        : m_socket( ioService ),
+        m_metrics( metrics ),
+        m_response( )
+    {
+    }
+
+    boost::asio::ip::tcp::socket& GetSocket( )  { return m_socket; }
+
+    // Read the request
+    void Start( )
+    {
+        m_socket.async_read_some( boost::asio::buffer( m_request, sizeof(m_request) ),
+                                  boost::bind( &MetricsConnection::OnRead,
+                                               shared_from_this(),
+                                               boost::asio::placeholders::error,
+                                               boost::asio::placeholders::bytes_transferred ) );
+    }
+
+    private:
+
+    // Answer GET / and GET /metrics, anything else is not found
+    void OnRead( const boost::system::error_code& error, const size_t size )
+    {
+        if ( error )
+        {
+            return;
+        }
+
+        const std::string request( m_request, size );
+        if ( request.compare( 0, 13, "GET /metrics " ) == 0 || request.compare( 0, 6, "GET / " ) == 0 )
+        {
+            const std::string text = m_metrics.GetText();
+
+            std::ostringstream response;
+            response << "HTTP/1.0 200 OK\r\n"
+                     << "Content-Type: text/plain; version=0.0.4\r\n"
+                     << "Content-Length: " << text.size() << "\r\n"
+                     << "Connection: close\r\n\r\n"
+                     << text;
+            m_response = response.str();
+        }
+        else
+        {
+            m_response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        }
+
+        boost::asio::async_write( m_socket,
+                                  boost::asio::buffer( m_response ),
+                                  boost::bind( &MetricsConnection::OnWritten,
+                                               shared_from_this(),
+                                               boost::asio::placeholders::error ) );
+    }
+
+    void OnWritten( const boost::system::error_code& error )
+    {
+        boost::system::error_code ignored;
+        m_socket.shutdown( boost::asio::ip::tcp::socket::shutdown_both, ignored );
+    }
+
+    MetricsConnection( const MetricsConnection& );
+    MetricsConnection& operator=( const MetricsConnection& );
+
+    boost::asio::ip::tcp::socket    m_socket;
+    Metrics&                        m_metrics;
+    char                            m_request[METRICS_REQUEST_SIZE];
+    std::string                     m_response;
+    };
+
+    /*
+    *   Serves the metrics on a localhost port from its own thread.
+    */
+    class MetricsServer
+    {
+    public:
+    MetricsServer( const int port, Metrics& metrics )
+        : m_metrics( metrics ),
+        m_ioService( ),
+        m_acceptor( m_ioService, boost::asio::ip::tcp::endpoint( boost::asio::ip::address_v4::loopback(), (unsigned short)port ) ),
+        m_thread( )
+    {
+        Accept( );
+        m_thread = boost::thread( boost::bind( &MetricsServer::RunLoop, this ) );
+    }
+
+    ~MetricsServer( )
+    {
+        m_ioService.stop();
+        if ( m_thread.joinable() )
+        {
+            m_thread.join();
+        }
+    }
+
+    private:
+
+    // Wait for the next client
+    void Accept( )
+    {
+        boost::shared_ptr<MetricsConnection> pConnection( new MetricsConnection( m_ioService, m_metrics ) );
+        m_acceptor.async_accept( pConnection->GetSocket(),
+                                 boost::bind( &MetricsServer::OnAccept,
+                                              this,
+                                              pConnection,
+                                              boost::asio::placeholders::error ) );
+    }
+
+    void OnAccept( boost::shared_ptr<MetricsConnection>   pConnection,
+                   const boost::system::error_code&       error )
+    {
+        if ( !error )
+        {
+            pConnection->Start();
+        }
+        Accept( );
+    }
+
+    void RunLoop( )
+    {
+        try
+        {
+            m_ioService.run();
+        }
+        EXCEPTION_CATCH_AND_LOG( "Metrics server stopped" );
+    }
+
+    MetricsServer( const MetricsServer& );
+    MetricsServer& operator=( const MetricsServer& );
+
+    Metrics&                            m_metrics;
+    boost::asio::io_service             m_ioService;
+    boost::asio::ip::tcp::acceptor      m_acceptor;
+    boost::thread                       m_thread;
+    };
+
+    /********************************************************************
+    Instance
+        The registry is created on first use
+    Exceptions:
+        None
+    *********************************************************************/
+    Metrics& Metrics::Instance( )
+    {
+        static Metrics metrics;
+        return metrics;
+    }
+
+    /********************************************************************
+    Metrics
+        Nothing is sampled until started
+    Exceptions:
+        None
+    *********************************************************************/
+    Metrics::Metrics( )
+        : m_cameras( ),
+        m_text( ),
+        m_fileName( ),
+        m_intervalMs( 1000 ),
+        m_pServer( NULL ),
+        m_stopping( false ),
+        m_sampler( )
+    {
+    }
+
+    /********************************************************************
+    Default Destructor for class Metrics
+    *********************************************************************/
+    Metrics::~Metrics( )
+    {
+        Stop( );
+    }
+
+    /********************************************************************
+    AddCamera
+        Registers the counters of a camera
+    Exceptions:
+        None
+    *********************************************************************/
+    CameraMetricsPtr Metrics::AddCamera( const int          cameraId,
+                                         const std::string& name )
+    {
+        CameraMetricsPtr pCamera( new CameraMetrics( cameraId, name ) );
+
+        boost::mutex::scoped_lock lock( m_camerasMutex );
+        m_cameras.push_back( pCamera );
+        return pCamera;
+    }
+
+    /********************************************************************
+    RemoveCamera
+        Unregisters the counters of a camera, its series end with the
+        next sample
+    Exceptions:
+        None
+    *********************************************************************/
+    void Metrics::RemoveCamera( const CameraMetricsPtr& pCamera )
+    {
+        boost::mutex::scoped_lock lock( m_camerasMutex );
+        m_cameras.erase( std::remove( m_cameras.begin(), m_cameras.end(), pCamera ), m_cameras.end() );
+    }
+
+    /********************************************************************
+    Start
+        Starts the server and the sampler thread
+    Exceptions:
+        None
+    *********************************************************************/
+    void Metrics::Start( const int          port,
+                         const std::string& fileName,
+                         const int          intervalMs )
+    {
+        if ( port <= 0 && fileName.empty() )
+        {
+            return;
+        }
+
+        m_fileName      = fileName;
+        m_intervalMs    = intervalMs;
+        m_stopping      = false;
+
+        Sample( );
+
+        if ( port > 0 )
+        {
+            try
+            {
+                m_pServer = new MetricsServer( port, *this );
+                LOG( "Serving metrics on http://127.0.0.1:" << port << "/metrics" );
+            }
+            EXCEPTION_CATCH_AND_LOG( "Unable to serve metrics on port " << port );
+        }
+
+        m_sampler = boost::thread( boost::bind( &Metrics::SamplerLoop, this ) );
+    }
+
+    /********************************************************************
+    Stop
+        Stops the sampler and the server; the file gets the final counts
+    Exceptions:
+        None
+    *********************************************************************/
+    void Metrics::Stop( )
+    {
+        if ( !m_sampler.joinable() )
+        {
+            return;
+        }
+
+        {
+            boost::mutex::scoped_lock lock( m_samplerMutex );
+            m_stopping = true;
+        }
+        m_samplerCondition.notify_all();
+        m_sampler.join();
+
+        delete m_pServer;
+        m_pServer = NULL;
+
+        Sample( );
+    }
+
+    /********************************************************************
+    GetText
+        Last sampled metrics
+    Exceptions:
+        None
+    *********************************************************************/
+    std::string Metrics::GetText( )
+    {
+        boost::mutex::scoped_lock lock( m_textMutex );
+        return m_text;
+    }
+
+    /********************************************************************
+    Sample
+        Renders the counters of all cameras in Prometheus text format
+    Exceptions:
+        None
+    *********************************************************************/
+    void Metrics::Sample( )
+    {
+        std::vector<CameraMetricsPtr> cameras;
+        {
+            boost::mutex::scoped_lock lock( m_camerasMutex );
+            cameras = m_cameras;
+        }
+
+        static const boost::posix_time::ptime epoch( boost::posix_time::microsec_clock::universal_time() );
+        const double now = ( boost::posix_time::microsec_clock::universal_time() - epoch ).total_microseconds() / 1e6;
+
+        // read every counter once, so that all families agree
+        std::vector< std::vector<double> > values( cameras.size(), std::vector<double>( METRIC_COUNT, 0.0 ) );
+
+        for ( unsigned int i = 0; i < cameras.size(); i++ )
+        {
+            CameraMetrics&       camera = *cameras[i];
+            std::vector<double>& row    = values[i];
+
+            row[0]  = (double)camera.m_frameNumber.load( boost::memory_order_relaxed );
+            row[1]  = (double)camera.m_framesProcessed.load( boost::memory_order_relaxed );
+            row[2]  = (double)camera.m_framesShed.load( boost::memory_order_relaxed );
+            row[3]  = (double)camera.m_framesDropped.load( boost::memory_order_relaxed );
+            row[5]  = camera.m_activeBlobs.load( boost::memory_order_relaxed );
+            row[6]  = camera.m_cropQueueDepth.load( boost::memory_order_relaxed );
+            row[7]  = camera.m_decodeMicroseconds.load( boost::memory_order_relaxed ) / 1e6;
+            row[8]  = camera.m_trackingMicroseconds.load( boost::memory_order_relaxed ) / 1e6;
+            row[9]  = camera.m_outputMicroseconds.load( boost::memory_order_relaxed ) / 1e6;
+            row[10] = camera.m_lagMicroseconds.load( boost::memory_order_relaxed ) / 1e6;
+            row[11] = (double)camera.m_memoryBytes.load( boost::memory_order_relaxed );
+            row[12] = camera.m_sheddingLevel.load( boost::memory_order_relaxed );
+            row[13] = camera.m_memoryLevel.load( boost::memory_order_relaxed );
+            row[14] = (double)camera.m_framesIdle.load( boost::memory_order_relaxed );
+
+            // the rate over the interval since the previous sample
+            const boost::int64_t frames = (boost::int64_t)( row[1] + row[3] + row[14] );
+            if ( camera.m_sampleTime > 0 && now > camera.m_sampleTime )
+            {
+                row[4] = ( frames - camera.m_sampledFrames ) / ( now - camera.m_sampleTime );
+            }
+            camera.m_sampledFrames  = frames;
+            camera.m_sampleTime     = now;
+        }
+
+        // counters are printed in full, not rounded to six digits
+        std::ostringstream text;
+        text.precision( 15 );
+
+        for ( int metric = 0; metric < METRIC_COUNT; metric++ )
+        {
+            const MetricFamily& family = g_metricFamilies[metric];
+            text << "# HELP " << family.m_name << ' ' << family.m_help << '\n';
+            text << "# TYPE " << family.m_name << ' ' << family.m_type << '\n';
+
+            for ( unsigned int i = 0; i < cameras.size(); i++ )
+            {
+                text << family.m_name << "{camera=\"" << cameras[i]->m_cameraId << "\",name=\"" <<
+                        EscapeLabel( cameras[i]->m_name ) << "\"} " << values[i][metric] << '\n';
+            }
+        }
+
+        {
+            boost::mutex::scoped_lock lock( m_textMutex );
+            m_text = text.str();
+        }
+
+        if ( !m_fileName.empty() )
+        {
+            WriteFile( text.str() );
+        }
+    }
+
+    /********************************************************************
+    WriteFile
+        Writes a temporary file and renames it over the metrics file, so
+        that readers never see a partial file
+    Exceptions:
+        None
+    *********************************************************************/
+    void Metrics::WriteFile( const std::string& text )
+    {
+        const std::string temporaryName = m_fileName + ".tmp";
+
+        FILE* pFile = fopen( temporaryName.c_str(), "wb" );
+        if ( pFile == NULL )
+        {
+            LOG_WARNING( "Unable to write metrics file " << temporaryName );
+            return;
+        }
+
+        const bool written = text.empty() || fwrite( text.data(), text.size(), 1, pFile ) == 1;
+        if ( fclose( pFile ) != 0 || !written )
+        {
+            LOG_WARNING( "Unable to write metrics file " << temporaryName );
+            return;
+        }
+
+#if defined(WIN32) || defined(WIN64)
+        const bool renamed = MoveFileExA( temporaryName.c_str(), m_fileName.c_str(), MOVEFILE_REPLACE_EXISTING ) != 0;
+#else
+        const bool renamed = rename( temporaryName.c_str(), m_fileName.c_str() ) == 0;
+#endif
+        if ( !renamed )
+        {
+            LOG_WARNING( "Unable to replace metrics file " << m_fileName );
+        }
+    }
+
+    /********************************************************************
+    SamplerLoop
+        Samples every m_intervalMs until stopped
+    Exceptions:
+        None
+    *********************************************************************/
+    void Metrics::SamplerLoop( )
+    {
+        for ( ;; )
+        {
+            {
+                boost::mutex::scoped_lock lock( m_samplerMutex );
+                if ( !m_stopping )
+                {
+                    m_samplerCondition.timed_wait( lock, boost::posix_time::milliseconds( m_intervalMs ) );
+                }
+                if ( m_stopping )
+                {
+                    return;
+                }
+            }
+
+            Sample( );
+        }
+    }
+}
@@ -0,0 +1,140 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace Tracker
+{
+    /*
+    *   Live counters of a camera. The frame loop only stores into them,
+    *   the metrics thread reads them; neither side takes a lock.
+    */
+    struct CameraMetrics
+    {
+        CameraMetrics( const int cameraId, const std::string& name )
+            : m_cameraId( cameraId ),
+            m_name( name ),
+            m_frameNumber( 0 ),
+            m_framesProcessed( 0 ),
+            m_framesShed( 0 ),
+            m_framesDropped( 0 ),
+            m_framesIdle( 0 ),
+            m_activeBlobs( 0 ),
+            m_cropQueueDepth( 0 ),
+            m_decodeMicroseconds( 0 ),
+            m_trackingMicroseconds( 0 ),
+            m_outputMicroseconds( 0 ),
+            m_lagMicroseconds( 0 ),
+            m_memoryBytes( 0 ),
+            m_sheddingLevel( 0 ),
+            m_memoryLevel( 0 ),
+            m_sampledFrames( 0 ),
+            m_sampleTime( 0 )
+        {
+        }
+
+        const int                           m_cameraId;
+        const std::string                   m_name;
+        boost::atomic<boost::int64_t>       m_frameNumber;
+        boost::atomic<boost::int64_t>       m_framesProcessed;
+        boost::atomic<boost::int64_t>       m_framesShed;
+        boost::atomic<boost::int64_t>       m_framesDropped;
+        boost::atomic<boost::int64_t>       m_framesIdle;
+        boost::atomic<int>                  m_activeBlobs;
+        boost::atomic<int>                  m_cropQueueDepth;
+        boost::atomic<boost::int64_t>       m_decodeMicroseconds;   // totals of the stages
+        boost::atomic<boost::int64_t>       m_trackingMicroseconds;
+        boost::atomic<boost::int64_t>       m_outputMicroseconds;
+        boost::atomic<boost::int64_t>       m_lagMicroseconds;
+        boost::atomic<boost::int64_t>       m_memoryBytes;
+        boost::atomic<int>                  m_sheddingLevel;
+        boost::atomic<int>                  m_memoryLevel;
+
+        // previous sample for the rates, sampler thread only
+        boost::int64_t                      m_sampledFrames;
+        double                              m_sampleTime;
+
+        private:
+
+        CameraMetrics( const CameraMetrics& );
+        CameraMetrics& operator=( const CameraMetrics& );
+    };
+
+    typedef boost::shared_ptr<CameraMetrics>    CameraMetricsPtr;
+
+    class MetricsServer;
+
+    /*
+    *   Process wide registry of the camera counters. Once started, a
+    *   background thread samples them every interval into Prometheus
+    *   text, which is served on a localhost port and/or atomically
+    *   rewritten into a file.
+    */
+    class Metrics
+    {
+    public:
+    // The process wide registry
+    static Metrics& Instance( );
+
+    // Register the counters of a camera
+    CameraMetricsPtr    AddCamera( const int          cameraId,
+                                   const std::string& name );
+
+    // Unregister the counters of a camera that has ended
+    void                RemoveCamera( const CameraMetricsPtr& pCamera );
+
+    // Start sampling; port 0 serves nothing, an empty file name writes nothing
+    void                Start( const int          port,
+                               const std::string& fileName,
+                               const int          intervalMs );
+
+    // Stop sampling and serving, writing the file a last time
+    void                Stop( );
+
+    // Last sampled metrics in Prometheus text format
+    std::string         GetText( );
+
+    private:
+
+    // Constructor
+    Metrics( );
+
+    // Destructor
+    ~Metrics( );
+
+    // Disallow copies
+    Metrics( const Metrics& );
+    Metrics& operator=( const Metrics& );
+
+    // Render the counters of all cameras
+    void                Sample( );
+
+    // Replace the metrics file by a complete new one
+    void                WriteFile( const std::string& text );
+
+    // Sample every interval until stopped
+    void                SamplerLoop( );
+
+    boost::mutex                            m_camerasMutex;
+    std::vector<CameraMetricsPtr>           m_cameras;
+
+    boost::mutex                            m_textMutex;
+    std::string                             m_text;
+
+    std::string                             m_fileName;
+    int                                     m_intervalMs;
+    MetricsServer*                          m_pServer;
+
+    boost::mutex                            m_samplerMutex;
+    boost::condition_variable               m_samplerCondition;
+    bool                                    m_stopping;
+    boost::thread                           m_sampler;
+    };
+}
+#endif
@@ -0,0 +1,245 @@
+#include "MotionField.h"
+#include "MemoryUsage.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <limits.h>
+
+// mean absolute difference per pixel below which a block is considered static
+#define MOTION_STATIC_DIFFERENCE    3
+
+namespace Tracker
+{
+    /********************************************************************
+    MotionField
+        Per-macroblock motion estimation
+    Exceptions:
+        None
+    *********************************************************************/
+    MotionField::MotionField( const int blockSize,
+                              const int searchRange )
+        : m_blockSize( blockSize ),
+        m_searchRange( searchRange ),
+        m_blocksX( 0 ),
+        m_blocksY( 0 ),
+        m_activeBlockCount( 0 ),
+        m_valid( false ),
+        m_previousGray( ),
+        m_currentGray( ),
+        m_blockActivity( ),
+        m_vectors( )
+    {
+        ASSERT_TRUE( m_blockSize >= 4 );
+        ASSERT_TRUE( m_searchRange >= 1 );
+    }
+
+    /********************************************************************
+    Update
+        Estimates the displacement of every macroblock of the frame
+        relative to the previous frame. Static blocks are detected with a
+        single zero-motion SAD, so the search only runs where something moves.
+    Exceptions:
+        None
+    *********************************************************************/
+    void MotionField::Update( const cv::Mat& frame )
+    {
+        std::swap( m_previousGray, m_currentGray );
+
+        if ( frame.channels() == 1 )
+        {
+            frame.copyTo( m_currentGray );
+        }
+        else
+        {
+            cv::cvtColor( frame, m_currentGray, CV_BGR2GRAY );
+        }
+
+        m_blocksX = m_currentGray.cols / m_blockSize;
+        m_blocksY = m_currentGray.rows / m_blockSize;
+
+        m_blockActivity = cv::Mat::zeros( std::max( m_blocksY, 1 ), std::max( m_blocksX, 1 ), CV_8UC1 );
+        m_vectors.assign( m_blocksX * m_blocksY, cv::Point( 0, 0 ) );
+        m_activeBlockCount  = 0;
+
+        // the first frame and a change of resolution have nothing to compare against
+        m_valid = !m_previousGray.empty() && m_previousGray.size() == m_currentGray.size();
+        if ( !m_valid )
+        {
+            return;
+        }
+
+        const int staticThreshold = MOTION_STATIC_DIFFERENCE * m_blockSize * m_blockSize / 2;
+
+        for ( int by = 0; by < m_blocksY; by++ )
+        {
+            for ( int bx = 0; bx < m_blocksX; bx++ )
+            {
+                if ( BlockSad( bx, by, 0, 0, INT_MAX ) > staticThreshold )
+                {
+                    SearchBlock( bx, by );
+
+                    m_blockActivity.at<uchar>( by, bx ) = 255;
+                    m_activeBlockCount++;
+                }
+            }
+        }
+    }
+
+    /********************************************************************
+    BlockSad
+        Sum of absolute differences between the block of the current frame
+        and the displaced block of the previous frame, every other row.
+        Returns INT_MAX when the displaced block leaves the frame.
+    Exceptions:
+        None
+    *********************************************************************/
+    int MotionField::BlockSad( const int bx,
+                               const int by,
+                               const int dx,
+                               const int dy,
+                               const int bestSoFar ) const
+    {
+        const int x0 = bx * m_blockSize;
+        const int y0 = by * m_blockSize;
+
+        if ( x0 + dx < 0 || y0 + dy < 0 ||
+             x0 + dx + m_blockSize > m_previousGray.cols ||
+             y0 + dy + m_blockSize > m_previousGray.rows )
+        {
+            return INT_MAX;
+        }
+
+        int sad = 0;
+        for ( int y = 0; y < m_blockSize; y += 2 )
+        {
+            const uchar* pCurrent   = m_currentGray.ptr<uchar>( y0 + y ) + x0;
+            const uchar* pPrevious  = m_previousGray.ptr<uchar>( y0 + y + dy ) + x0 + dx;
+
+            for ( int x = 0; x < m_blockSize; x++ )
+            {
+                sad += abs( pCurrent[x] - pPrevious[x] );
+            }
+
+            if ( sad >= bestSoFar )
+            {
+                break;
+            }
+        }
+
+        return sad;
+    }
+
+    /********************************************************************
+    SearchBlock
+        Small diamond search seeded with zero motion and with the vector of
+        the left neighbour, which is where the decoder would predict from.
+        The stored vector points from the previous to the current position.
+    Exceptions:
+        None
+    *********************************************************************/
+    void MotionField::SearchBlock( const int bx,
+                                   const int by )
+    {
+        static const int diamond[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+        cv::Point   best( 0, 0 );
+        int         bestSad = BlockSad( bx, by, 0, 0, INT_MAX );
+
+        if ( bx > 0 )
+        {
+            const cv::Point& predictor = m_vectors[ by * m_blocksX + bx - 1 ];
+            const int sad = BlockSad( bx, by, -predictor.x, -predictor.y, bestSad );
+            if ( sad < bestSad )
+            {
+                bestSad = sad;
+                best    = cv::Point( -predictor.x, -predictor.y );
+            }
+        }
+
+        bool improved = true;
+        while ( improved )
+        {
+            improved = false;
+            cv::Point center = best;
+
+            for ( int i = 0; i < 4; i++ )
+            {
+                cv::Point candidate( center.x + diamond[i][0], center.y + diamond[i][1] );
+                if ( abs( candidate.x ) > m_searchRange || abs( candidate.y ) > m_searchRange )
+                {
+                    continue;
+                }
+
+                const int sad = BlockSad( bx, by, candidate.x, candidate.y, bestSad );
+                if ( sad < bestSad )
+                {
+                    bestSad     = sad;
+                    best        = candidate;
+                    improved    = true;
+                }
+            }
+        }
+
+        m_vectors[ by * m_blocksX + bx ] = cv::Point( -best.x, -best.y );
+    }
+
+    /********************************************************************
+    GetRegionMotion
+        Median motion vector of the moving macroblocks under the region
+    Exceptions:
+        None
+    *********************************************************************/
+    bool MotionField::GetRegionMotion( const cv::Rect&  region,
+                                       cv::Point2f&     motion ) const
+    {
+        if ( !m_valid || m_activeBlockCount == 0 )
+        {
+            return false;
+        }
+
+        const int bx0 = std::max( 0, region.x / m_blockSize );
+        const int by0 = std::max( 0, region.y / m_blockSize );
+        const int bx1 = std::min( m_blocksX - 1, ( region.x + region.width ) / m_blockSize );
+        const int by1 = std::min( m_blocksY - 1, ( region.y + region.height ) / m_blockSize );
+
+        std::vector<int> motionX;
+        std::vector<int> motionY;
+        for ( int by = by0; by <= by1; by++ )
+        {
+            for ( int bx = bx0; bx <= bx1; bx++ )
+            {
+                if ( m_blockActivity.at<uchar>( by, bx ) != 0 )
+                {
+                    motionX.push_back( m_vectors[ by * m_blocksX + bx ].x );
+                    motionY.push_back( m_vectors[ by * m_blocksX + bx ].y );
+                }
+            }
+        }
+
+        if ( motionX.empty() )
+        {
+            return false;
+        }
+
+        const size_t middle = motionX.size() / 2;
+        std::nth_element( motionX.begin(), motionX.begin() + middle, motionX.end() );
+        std::nth_element( motionY.begin(), motionY.begin() + middle, motionY.end() );
+
+        motion = cv::Point2f( (float)motionX[middle], (float)motionY[middle] );
+        return true;
+    }
+
+    /********************************************************************
+    GetMemoryBytes
+        Bytes held by the images and vectors of the field
+    Exceptions:
+        None
+    *********************************************************************/
+    size_t MotionField::GetMemoryBytes( ) const
+    {
+        return GetMatBytes( m_previousGray ) +
+               GetMatBytes( m_currentGray ) +
+               GetMatBytes( m_blockActivity ) +
+               m_vectors.capacity() * sizeof(cv::Point);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef MOTION_FIELD_H
+#define MOTION_FIELD_H
+
+#include "OpenCvDefinitions.h"
+#include "CommonMacros.h"
+
+#include <vector>
+
+namespace Tracker
+{
+    /*
+    *   Per-macroblock motion vectors between consecutive frames, found
+    *   by block matching on the decoded frames. Used to seed the blob
+    *   tracker.
+    */
+    class MotionField
+    {
+    public:
+    // Constructor
+    MotionField( const int blockSize,
+                 const int searchRange );
+
+    // Estimate the motion of every macroblock against the previous frame
+    void Update( const cv::Mat& frame );
+
+    // Median motion of the moving macroblocks covered by the region
+    bool GetRegionMotion( const cv::Rect& region, cv::Point2f& motion ) const;
+
+    // Bytes held by the images and vectors of the field
+    size_t GetMemoryBytes( ) const;
+
+    // Getters
+    int  GetActiveBlockCount( ) const   { return m_activeBlockCount; }
+    int  GetBlockSize( ) const          { return m_blockSize; }
+    bool IsValid( ) const               { return m_valid; }
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( MotionField );
+
+    // Sum of absolute differences of one block for the given displacement
+    int  BlockSad( const int bx, const int by, const int dx, const int dy, const int bestSoFar ) const;
+
+    // Search the displacement of one block
+    void SearchBlock( const int bx, const int by );
+
+    int                             m_blockSize;
+    int                             m_searchRange;
+    int                             m_blocksX;
+    int                             m_blocksY;
+    int                             m_activeBlockCount;
+    bool                            m_valid;
+    cv::Mat                         m_previousGray;
+    cv::Mat                         m_currentGray;
+    cv::Mat                         m_blockActivity;        // 255: moving macroblock
+    std::vector<cv::Point>          m_vectors;
+    };
+}
+#endif
\ No newline at end of file
@@ -15,6 +15,7 @@
 #pragma comment(lib,"opencv_core230.lib")
 #pragma comment(lib,"opencv_highgui230.lib")    
 #pragma comment(lib,"opencv_legacy230.lib")    
+#pragma comment(lib,"opencv_video230.lib")    
 #pragma comment(lib,"opencv_imgproc230")    
 
 #else
@@ -22,6 +23,7 @@
 #pragma comment(lib,"opencv_core230d.lib")
 #pragma comment(lib,"opencv_highgui230d.lib")    
 #pragma comment(lib,"opencv_legacy230d.lib")    
+#pragma comment(lib,"opencv_video230d.lib")    
 #pragma comment(lib,"opencv_imgproc230d")    
 
 #endif
@@ -34,6 +36,7 @@
 #pragma comment(lib,"opencv_core220.lib")
 #pragma comment(lib,"opencv_highgui220.lib")    
 #pragma comment(lib,"opencv_legacy220.lib")    
+#pragma comment(lib,"opencv_video220.lib")    
 #pragma comment(lib,"opencv_imgproc220")   
 
 #else
@@ -41,6 +44,7 @@
 #pragma comment(lib,"opencv_core220d.lib")
 #pragma comment(lib,"opencv_highgui220d.lib")    
 #pragma comment(lib,"opencv_legacy220d.lib")    
+#pragma comment(lib,"opencv_video220d.lib")    
 #pragma comment(lib,"opencv_imgproc220d")  
 
 #endif
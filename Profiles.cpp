@@ -0,0 +1,171 @@
+#include "Profiles.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace Tracker
+{
+    /********************************************************************
+    Constructor for class PipelineProfiles
+    *********************************************************************/
+    PipelineProfiles::PipelineProfiles( const InputParameters& baseParams )
+        : m_baseParams( baseParams ),
+        m_profiles( ),
+        m_cameraProfiles( )
+    {
+    }
+
+    /********************************************************************
+    Destructor for class PipelineProfiles
+    *********************************************************************/
+    PipelineProfiles::~PipelineProfiles( )
+    {
+    }
+
+    /*************************************************************************
+    Load
+        Read the profiles and their camera assignments; without a profile
+        file every camera uses the config file settings
+    Exceptions
+        None
+    *************************************************************************/
+    void PipelineProfiles::Load( const std::string&  profileFileName,
+                                 const std::string&  cameraProfiles )
+    {
+        if ( profileFileName.empty() )
+        {
+            if ( !cameraProfiles.empty() )
+            {
+                AbortError( __LINE__, __FILE__, "Camera_Profiles requires a Profile_File" );
+            }
+            return;
+        }
+
+        ReadProfiles( profileFileName );
+        AssignProfiles( cameraProfiles );
+    }
+
+    /*************************************************************************
+    ReadProfiles
+        Read the profiles listed in the profile file
+    Exceptions
+        None
+    *************************************************************************/
+    void PipelineProfiles::ReadProfiles( const std::string& profileFileName )
+    {
+        std::ifstream profileFile( profileFileName.c_str() );
+        if ( !profileFile.is_open() )
+        {
+            LOG_FILE( "Unable to open profile file " + profileFileName );
+            AbortError( __LINE__, __FILE__, "Unable to open profile file" );
+        }
+
+        std::string line;
+        while ( std::getline( profileFile, line ) )
+        {
+            // skip comments and blank lines
+            const size_t nameStart = line.find_first_not_of( " \t\r" );
+            if ( nameStart == std::string::npos || line[nameStart] == '#' )
+            {
+                continue;
+            }
+
+            const size_t nameEnd = line.find_first_of( " \t\r", nameStart );
+            const std::string name = line.substr( nameStart, nameEnd - nameStart );
+            const std::string settings = ( nameEnd == std::string::npos ) ? std::string() : line.substr( nameEnd );
+
+            std::map<std::string, InputParameters>::iterator profileIt = m_profiles.find( name );
+            if ( profileIt == m_profiles.end() )
+            {
+                profileIt = m_profiles.insert( std::make_pair( name, m_baseParams ) ).first;
+            }
+
+            if ( ParseConfigOverride( settings.c_str(), &profileIt->second ) != 0 )
+            {
+                LOG_FILE( "Invalid settings for profile " + name );
+                AbortError( __LINE__, __FILE__, "Invalid settings in profile file" );
+            }
+        }
+
+        LOG_FILE( "Read " << m_profiles.size() << " pipeline profiles from " << profileFileName );
+    }
+
+    /*************************************************************************
+    AssignProfiles
+        Parse the comma separated <camera ID>:<profile name> assignments
+    Exceptions
+        None
+    *************************************************************************/
+    void PipelineProfiles::AssignProfiles( const std::string& cameraProfiles )
+    {
+        std::istringstream assignments( cameraProfiles );
+        std::string assignment;
+        while ( std::getline( assignments, assignment, ',' ) )
+        {
+            const size_t separator = assignment.find( ':' );
+            if ( separator == std::string::npos )
+            {
+                LOG_FILE( "Invalid camera profile assignment " + assignment );
+                AbortError( __LINE__, __FILE__, "Invalid Camera_Profiles entry" );
+            }
+
+            const int cameraId = atoi( assignment.substr( 0, separator ).c_str() );
+            const std::string name = assignment.substr( separator + 1 );
+
+            if ( m_profiles.find( name ) == m_profiles.end() )
+            {
+                LOG_FILE( "Unknown profile " + name + " in Camera_Profiles" );
+                AbortError( __LINE__, __FILE__, "Unknown profile in Camera_Profiles" );
+            }
+
+            m_cameraProfiles[cameraId] = name;
+        }
+    }
+
+    /*************************************************************************
+    GetSettings
+        Settings of the profile of a camera, or of the config file
+    Exceptions
+        None
+    *************************************************************************/
+    const InputParameters& PipelineProfiles::GetSettings( const int cameraId ) const
+    {
+        std::map<int, std::string>::const_iterator cameraIt = m_cameraProfiles.find( cameraId );
+        if ( cameraIt == m_cameraProfiles.end() )
+        {
+            return m_baseParams;
+        }
+
+        return m_profiles.find( cameraIt->second )->second;
+    }
+
+    /*************************************************************************
+    GetProfileName
+        Name of the profile of a camera, empty for the config file settings
+    Exceptions
+        None
+    *************************************************************************/
+    std::string PipelineProfiles::GetProfileName( const int cameraId ) const
+    {
+        std::map<int, std::string>::const_iterator cameraIt = m_cameraProfiles.find( cameraId );
+        return ( cameraIt == m_cameraProfiles.end() ) ? std::string() : cameraIt->second;
+    }
+
+    /*************************************************************************
+    GetProfileSettings
+        Settings of a named profile
+    Exceptions
+        None
+    *************************************************************************/
+    const InputParameters& PipelineProfiles::GetProfileSettings( const std::string& profileName ) const
+    {
+        std::map<std::string, InputParameters>::const_iterator profileIt = m_profiles.find( profileName );
+        if ( profileIt == m_profiles.end() )
+        {
+            LOG_FILE( "Unknown profile " + profileName );
+            AbortError( __LINE__, __FILE__, "Unknown pipeline profile" );
+        }
+
+        return profileIt->second;
+    }
+}
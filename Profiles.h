@@ -0,0 +1,62 @@
+#ifndef PROFILES_H
+#define PROFILES_H
+
+#include "Config.h"
+#include "CommonMacros.h"
+
+#include <map>
+#include <string>
+
+namespace Tracker
+{
+    /*
+    *   Named pipeline profiles assigned per camera ID, so each camera can
+    *   run the modules, parameters, scale and analysis its scene needs.
+    *
+    *   Each line of the profile file is a profile name followed by config
+    *   settings, applied on top of the config file, e.g.
+    *       corridor    Foreground_Detector_Module = "FG_0S" Blob_Tracker_Module = "CC"
+    *       corridor    Down_Scale_Image = 1 Blob_Analysis_Module = "None"
+    *       entrance    Blob_Tracker_Module = "CCMSPF"
+    *   Lines of the same name add to one profile. Camera_Profiles assigns
+    *   the profiles, e.g. "1:corridor,2:entrance"; other cameras use the
+    *   config file settings.
+    */
+    class PipelineProfiles
+    {
+    public:
+    // Constructor
+    explicit PipelineProfiles( const InputParameters& baseParams );
+
+    // Destructor
+    ~PipelineProfiles( );
+
+    // Read the profiles and their camera assignments
+    void Load( const std::string&  profileFileName,
+               const std::string&  cameraProfiles );
+
+    // Settings of a camera
+    const InputParameters&  GetSettings( const int cameraId ) const;
+
+    // Name of the profile of a camera, empty for the config file settings
+    std::string             GetProfileName( const int cameraId ) const;
+
+    // Settings of a named profile, e.g. one given by a job manifest
+    const InputParameters&  GetProfileSettings( const std::string& profileName ) const;
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( PipelineProfiles );
+
+    // Read the profiles listed in the profile file
+    void ReadProfiles( const std::string& profileFileName );
+
+    // Parse the camera ID to profile name assignments
+    void AssignProfiles( const std::string& cameraProfiles );
+
+    InputParameters                             m_baseParams;
+    std::map<std::string, InputParameters>      m_profiles;
+    std::map<int, std::string>                  m_cameraProfiles;
+    };
+}
+#endif
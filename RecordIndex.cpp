@@ -0,0 +1,729 @@
+#include "RecordIndex.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(WIN32) || defined(WIN64)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#define RECORD_INDEX_MAGIC          0x49525442  // 'BTRI'
+#define RECORD_INDEX_VERSION        1
+
+namespace Tracker
+{
+    /********************************************************************
+    GetRecordBox
+        Box of a record, whose position is the centre of the blob
+    Exceptions:
+        None
+    *********************************************************************/
+    cv::Rect GetRecordBox( const BlobRecord& record )
+    {
+        return cv::Rect( record.m_x - record.m_width / 2,
+                         record.m_y - record.m_height / 2,
+                         record.m_width,
+                         record.m_height );
+    }
+
+    /********************************************************************
+    IntersectsBox
+        Does the box given by its corners intersect the rectangle
+    Exceptions:
+        None
+    *********************************************************************/
+    static bool IntersectsBox( const int minX, const int minY, const int maxX, const int maxY, const cv::Rect& box )
+    {
+        return minX <= box.x + box.width && box.x <= maxX &&
+               minY <= box.y + box.height && box.y <= maxY;
+    }
+
+    /********************************************************************
+    FrameBefore / TrackBefore
+        Orderings of the index tables for binary searches
+    Exceptions:
+        None
+    *********************************************************************/
+    static bool FrameBefore( const RecordFrameEntry& entry, const int frameNumber )
+    {
+        return entry.m_frameNumber < frameNumber;
+    }
+
+    static bool TrackBefore( const RecordTrackEntry& entry, const int id )
+    {
+        return entry.m_id < id;
+    }
+
+    /********************************************************************
+    ParseNumber
+        Parses a decimal number without reading past the end
+    Exceptions:
+        None
+    *********************************************************************/
+    static bool ParseNumber( const char*& pPosition, const char* pEnd, double& value )
+    {
+        while ( pPosition < pEnd && ( *pPosition == ' ' || *pPosition == '\t' ) )
+        {
+            pPosition++;
+        }
+
+        const bool negative = pPosition < pEnd && *pPosition == '-';
+        if ( negative )
+        {
+            pPosition++;
+        }
+
+        const char* pDigits = pPosition;
+        value = 0.0;
+        while ( pPosition < pEnd && *pPosition >= '0' && *pPosition <= '9' )
+        {
+            value = value * 10.0 + ( *pPosition++ - '0' );
+        }
+
+        if ( pPosition < pEnd && *pPosition == '.' )
+        {
+            double scale = 0.1;
+            for ( pPosition++; pPosition < pEnd && *pPosition >= '0' && *pPosition <= '9'; pPosition++ )
+            {
+                value += ( *pPosition - '0' ) * scale;
+                scale *= 0.1;
+            }
+        }
+
+        if ( negative )
+        {
+            value = -value;
+        }
+        return pPosition > pDigits;
+    }
+
+    /********************************************************************
+    ParseRecordLine
+        Parses "frame x y width height id<tab>timestamp"
+    Exceptions:
+        None
+    *********************************************************************/
+    bool ParseRecordLine( const char*&  pPosition,
+                          const char*   pEnd,
+                          BlobRecord&   record )
+    {
+        double fields[7];
+        bool parsed = true;
+        for ( int i = 0; i < 7 && parsed; i++ )
+        {
+            parsed = ParseNumber( pPosition, pEnd, fields[i] );
+        }
+
+        // move to the next line
+        while ( pPosition < pEnd && *pPosition++ != '\n' )
+        {
+        }
+
+        if ( !parsed )
+        {
+            return false;
+        }
+
+        record.m_frameNumber    = (int)fields[0];
+        record.m_x              = (int)fields[1];
+        record.m_y              = (int)fields[2];
+        record.m_width          = (int)fields[3];
+        record.m_height         = (int)fields[4];
+        record.m_id             = (int)fields[5];
+        record.m_timestamp      = fields[6];
+        return true;
+    }
+
+    /********************************************************************
+    GetRecordIndexName
+        The index is stored next to the record file
+    Exceptions:
+        None
+    *********************************************************************/
+    std::string GetRecordIndexName( const std::string& recordFileName )
+    {
+        return recordFileName + ".idx";
+    }
+
+    /********************************************************************
+    RecordIndexBuilder
+        Starts an index file with an incomplete header
+    Exceptions:
+        None
+    *********************************************************************/
+    RecordIndexBuilder::RecordIndexBuilder( const std::string& indexFileName )
+        : m_pIndexFile( NULL ),
+        m_tracks( )
+    {
+        memset( &m_header, 0, sizeof(m_header) );
+        memset( &m_frame, 0, sizeof(m_frame) );
+
+        m_header.m_magic            = RECORD_INDEX_MAGIC;
+        m_header.m_version          = RECORD_INDEX_VERSION;
+        m_header.m_frameTableOffset = sizeof(RecordIndexHeader);
+
+        m_pIndexFile = fopen( indexFileName.c_str(), "wb" );
+        if ( m_pIndexFile == NULL ||
+             fwrite( &m_header, sizeof(m_header), 1, m_pIndexFile ) != 1 )
+        {
+            LOG_FILE( "Unable to write record index " + indexFileName );
+        }
+    }
+
+    /********************************************************************
+    Default Destructor for class RecordIndexBuilder
+    *********************************************************************/
+    RecordIndexBuilder::~RecordIndexBuilder( )
+    {
+        // an index that was not closed stays incomplete
+        if ( m_pIndexFile != NULL )
+        {
+            fclose( m_pIndexFile );
+        }
+    }
+
+    /********************************************************************
+    Add
+        Adds a record to the entries of its frame and track
+    Exceptions:
+        None
+    *********************************************************************/
+    void RecordIndexBuilder::Add( const BlobRecord&         record,
+                                  const boost::uint64_t     offset )
+    {
+        const cv::Rect box = GetRecordBox( record );
+
+        if ( m_frame.m_recordCount > 0 && m_frame.m_frameNumber != record.m_frameNumber )
+        {
+            FlushFrame( );
+        }
+
+        if ( m_frame.m_recordCount == 0 )
+        {
+            m_frame.m_frameNumber   = record.m_frameNumber;
+            m_frame.m_offset        = offset;
+            m_frame.m_minX          = box.x;
+            m_frame.m_minY          = box.y;
+            m_frame.m_maxX          = box.x + box.width;
+            m_frame.m_maxY          = box.y + box.height;
+        }
+        else
+        {
+            m_frame.m_minX          = std::min( m_frame.m_minX, box.x );
+            m_frame.m_minY          = std::min( m_frame.m_minY, box.y );
+            m_frame.m_maxX          = std::max( m_frame.m_maxX, box.x + box.width );
+            m_frame.m_maxY          = std::max( m_frame.m_maxY, box.y + box.height );
+        }
+        m_frame.m_recordCount++;
+
+        std::map<int, RecordTrackEntry>::iterator trackIt = m_tracks.find( record.m_id );
+        if ( trackIt == m_tracks.end() )
+        {
+            RecordTrackEntry track;
+            track.m_id              = record.m_id;
+            track.m_firstFrame      = record.m_frameNumber;
+            track.m_lastFrame       = record.m_frameNumber;
+            track.m_recordCount     = 1;
+            track.m_minX            = box.x;
+            track.m_minY            = box.y;
+            track.m_maxX            = box.x + box.width;
+            track.m_maxY            = box.y + box.height;
+            m_tracks.insert( std::make_pair( record.m_id, track ) );
+        }
+        else
+        {
+            RecordTrackEntry& track = trackIt->second;
+            track.m_lastFrame       = record.m_frameNumber;
+            track.m_recordCount++;
+            track.m_minX            = std::min( track.m_minX, box.x );
+            track.m_minY            = std::min( track.m_minY, box.y );
+            track.m_maxX            = std::max( track.m_maxX, box.x + box.width );
+            track.m_maxY            = std::max( track.m_maxY, box.y + box.height );
+        }
+    }
+
+    /********************************************************************
+    FlushFrame
+        Appends the entry of the current frame to the frame table
+    Exceptions:
+        None
+    *********************************************************************/
+    void RecordIndexBuilder::FlushFrame( )
+    {
+        if ( m_frame.m_recordCount == 0 )
+        {
+            return;
+        }
+
+        if ( m_pIndexFile != NULL &&
+             fwrite( &m_frame, sizeof(m_frame), 1, m_pIndexFile ) == 1 )
+        {
+            m_header.m_frameCount++;
+        }
+        m_frame.m_recordCount = 0;
+    }
+
+    /********************************************************************
+    Close
+        Writes the track table and completes the header
+    Exceptions:
+        None
+    *********************************************************************/
+    void RecordIndexBuilder::Close( const boost::uint64_t recordFileSize )
+    {
+        if ( m_pIndexFile == NULL )
+        {
+            return;
+        }
+
+        FlushFrame( );
+
+        m_header.m_recordFileSize   = recordFileSize;
+        m_header.m_trackTableOffset = m_header.m_frameTableOffset + m_header.m_frameCount * sizeof(RecordFrameEntry);
+
+        bool written = true;
+        for ( std::map<int, RecordTrackEntry>::const_iterator it = m_tracks.begin(); it != m_tracks.end() && written; ++it )
+        {
+            written = fwrite( &it->second, sizeof(RecordTrackEntry), 1, m_pIndexFile ) == 1;
+            m_header.m_trackCount++;
+        }
+
+        m_header.m_complete = written ? 1 : 0;
+        fseek( m_pIndexFile, 0, SEEK_SET );
+        fwrite( &m_header, sizeof(m_header), 1, m_pIndexFile );
+
+        fclose( m_pIndexFile );
+        m_pIndexFile = NULL;
+        m_tracks.clear();
+    }
+
+    /********************************************************************
+    RecordWriter
+        Opens the record file and starts its index
+    Exceptions:
+        None
+    *********************************************************************/
+    RecordWriter::RecordWriter( const std::string& recordFileName )
+        : m_pRecordFile( NULL ),
+        m_pIndexBuilder( NULL ),
+        m_offset( 0 ),
+        m_lastFrame( INT_MIN )
+    {
+        // binary mode keeps the index offsets exact
+        m_pRecordFile = fopen( recordFileName.c_str(), "wb" );
+        if ( m_pRecordFile != NULL )
+        {
+            m_pIndexBuilder = new RecordIndexBuilder( GetRecordIndexName( recordFileName ) );
+        }
+    }
+
+    /********************************************************************
+    RecordWriter
+        Drops the records after the kept bytes, indexes the kept ones
+        again and appends after them
+    Exceptions:
+        None
+    *********************************************************************/
+    RecordWriter::RecordWriter( const std::string&        recordFileName,
+                                const boost::uint64_t     keptBytes )
+        : m_pRecordFile( NULL ),
+        m_pIndexBuilder( NULL ),
+        m_offset( 0 ),
+        m_lastFrame( INT_MIN )
+    {
+        m_pRecordFile = fopen( recordFileName.c_str(), "r+b" );
+        if ( m_pRecordFile == NULL )
+        {
+            return;
+        }
+
+        // a shorter file would be extended, not truncated
+        fseek( m_pRecordFile, 0, SEEK_END );
+        bool truncated = (boost::uint64_t)ftell( m_pRecordFile ) >= keptBytes;
+        if ( truncated )
+        {
+#if defined(WIN32) || defined(WIN64)
+            truncated = _chsize_s( _fileno( m_pRecordFile ), (__int64)keptBytes ) == 0;
+#else
+            truncated = ftruncate( fileno( m_pRecordFile ), (off_t)keptBytes ) == 0;
+#endif
+        }
+
+        if ( !truncated )
+        {
+            LOG_FILE( "Unable to continue the record file " + recordFileName );
+            fclose( m_pRecordFile );
+            m_pRecordFile = NULL;
+            return;
+        }
+
+        m_pIndexBuilder = new RecordIndexBuilder( GetRecordIndexName( recordFileName ) );
+
+        fseek( m_pRecordFile, 0, SEEK_SET );
+
+        char line[256];
+        while ( m_offset < keptBytes && fgets( line, sizeof(line), m_pRecordFile ) != NULL )
+        {
+            const size_t length = strlen( line );
+
+            BlobRecord record;
+            const char* pPosition = line;
+            if ( ParseRecordLine( pPosition, line + length, record ) )
+            {
+                m_pIndexBuilder->Add( record, m_offset );
+                m_lastFrame = record.m_frameNumber;
+            }
+            m_offset += length;
+        }
+
+        // switch from reading to appending
+        fseek( m_pRecordFile, 0, SEEK_END );
+    }
+
+    /********************************************************************
+    Default Destructor for class RecordWriter
+    *********************************************************************/
+    RecordWriter::~RecordWriter( )
+    {
+        Close( );
+    }
+
+    /********************************************************************
+    Write
+        Appends a record line and indexes it
+    Exceptions:
+        None
+    *********************************************************************/
+    void RecordWriter::Write( const BlobRecord& record )
+    {
+        ASSERT_TRUE( m_pRecordFile != NULL );
+
+        // keep the file current with each completed frame
+        if ( record.m_frameNumber != m_lastFrame )
+        {
+            fflush( m_pRecordFile );
+            m_lastFrame = record.m_frameNumber;
+        }
+
+        char line[128];
+        const int length = sprintf( line,
+                                    "%d %d %d %d %d %d\t%g\n",
+                                    record.m_frameNumber,
+                                    record.m_x,
+                                    record.m_y,
+                                    record.m_width,
+                                    record.m_height,
+                                    record.m_id,
+                                    record.m_timestamp );
+
+        if ( fwrite( line, length, 1, m_pRecordFile ) != 1 )
+        {
+            AbortError( __LINE__, __FILE__, "Failed to save blob information" );
+        }
+
+        m_pIndexBuilder->Add( record, m_offset );
+        m_offset += length;
+    }
+
+    /********************************************************************
+    Flush
+        Writes the buffered records, e.g. before a checkpoint
+    Exceptions:
+        None
+    *********************************************************************/
+    void RecordWriter::Flush( )
+    {
+        if ( m_pRecordFile != NULL && fflush( m_pRecordFile ) != 0 )
+        {
+            AbortError( __LINE__, __FILE__, "Failed to save blob information" );
+        }
+    }
+
+    /********************************************************************
+    Close
+        Closes the record file and completes the index
+    Exceptions:
+        None
+    *********************************************************************/
+    void RecordWriter::Close( )
+    {
+        if ( m_pRecordFile == NULL )
+        {
+            return;
+        }
+
+        fclose( m_pRecordFile );
+        m_pRecordFile = NULL;
+
+        m_pIndexBuilder->Close( m_offset );
+        delete m_pIndexBuilder;
+        m_pIndexBuilder = NULL;
+    }
+
+    /********************************************************************
+    BuildRecordIndex
+        Indexes a record file written without an index
+    Exceptions:
+        None
+    *********************************************************************/
+    bool BuildRecordIndex( const std::string& recordFileName )
+    {
+        FILE* pRecordFile = fopen( recordFileName.c_str(), "rb" );
+        if ( pRecordFile == NULL )
+        {
+            return false;
+        }
+
+        RecordIndexBuilder indexBuilder( GetRecordIndexName( recordFileName ) );
+
+        char                line[256];
+        boost::uint64_t     offset      = 0;
+        int                 lastFrame   = INT_MIN;
+        bool                ordered     = true;
+
+        while ( ordered && fgets( line, sizeof(line), pRecordFile ) != NULL )
+        {
+            const size_t length = strlen( line );
+
+            BlobRecord record;
+            const char* pPosition = line;
+            if ( ParseRecordLine( pPosition, line + length, record ) )
+            {
+                ordered     = record.m_frameNumber >= lastFrame;
+                lastFrame   = record.m_frameNumber;
+                indexBuilder.Add( record, offset );
+            }
+            offset += length;
+        }
+        fclose( pRecordFile );
+
+        if ( !ordered )
+        {
+            LOG_FILE( "Records are not in frame order, unable to index " + recordFileName );
+            return false;
+        }
+
+        indexBuilder.Close( offset );
+        return true;
+    }
+
+    /********************************************************************
+    RecordQuery::Mapping
+        Memory mappings of the record file and the index
+    *********************************************************************/
+    class RecordQuery::Mapping
+    {
+    public:
+        boost::interprocess::file_mapping       m_recordFile;
+        boost::interprocess::mapped_region      m_recordRegion;
+        boost::interprocess::file_mapping       m_indexFile;
+        boost::interprocess::mapped_region      m_indexRegion;
+    };
+
+    /********************************************************************
+    RecordQuery
+        Maps the record file and its index, rebuilding an outdated index
+    Exceptions:
+        None
+    *********************************************************************/
+    RecordQuery::RecordQuery( const std::string& recordFileName )
+        : m_pMapping( new Mapping( ) ),
+        m_pRecords( NULL ),
+        m_recordFileSize( 0 ),
+        m_pHeader( NULL ),
+        m_pFrames( NULL ),
+        m_pTracks( NULL )
+    {
+        FILE* pRecordFile = fopen( recordFileName.c_str(), "rb" );
+        if ( pRecordFile == NULL )
+        {
+            LOG_FILE( "Unable to open record file " + recordFileName );
+            return;
+        }
+        fseek( pRecordFile, 0, SEEK_END );
+        m_recordFileSize = (boost::uint64_t)ftell( pRecordFile );
+        fclose( pRecordFile );
+
+        // an empty file cannot be mapped
+        if ( m_recordFileSize > 0 )
+        {
+            try
+            {
+                boost::interprocess::file_mapping file( recordFileName.c_str(), boost::interprocess::read_only );
+                m_pMapping->m_recordFile.swap( file );
+
+                boost::interprocess::mapped_region region( m_pMapping->m_recordFile, boost::interprocess::read_only );
+                m_pMapping->m_recordRegion.swap( region );
+            }
+            catch ( std::exception& ex )
+            {
+                LOG_FILE( "Unable to map record file " << recordFileName << ": " << ex.what() );
+                return;
+            }
+            m_pRecords = static_cast<const char*>( m_pMapping->m_recordRegion.get_address() );
+        }
+
+        const std::string indexFileName = GetRecordIndexName( recordFileName );
+        if ( !MapIndex( indexFileName ) )
+        {
+            LOG_CONSOLE( "Indexing " + recordFileName );
+            if ( !BuildRecordIndex( recordFileName ) || !MapIndex( indexFileName ) )
+            {
+                LOG_FILE( "Unable to index record file " + recordFileName );
+            }
+        }
+    }
+
+    /********************************************************************
+    Default Destructor for class RecordQuery
+    *********************************************************************/
+    RecordQuery::~RecordQuery( )
+    {
+        delete m_pMapping;
+    }
+
+    /********************************************************************
+    MapIndex
+        Maps the index if it is complete and matches the record file
+    Exceptions:
+        None
+    *********************************************************************/
+    bool RecordQuery::MapIndex( const std::string& indexFileName )
+    {
+        m_pHeader = NULL;
+
+        try
+        {
+            boost::interprocess::file_mapping file( indexFileName.c_str(), boost::interprocess::read_only );
+            m_pMapping->m_indexFile.swap( file );
+
+            boost::interprocess::mapped_region region( m_pMapping->m_indexFile, boost::interprocess::read_only );
+            m_pMapping->m_indexRegion.swap( region );
+        }
+        catch ( std::exception& )
+        {
+            return false;
+        }
+
+        const char*     pIndex      = static_cast<const char*>( m_pMapping->m_indexRegion.get_address() );
+        const size_t    indexSize   = m_pMapping->m_indexRegion.get_size();
+        if ( indexSize < sizeof(RecordIndexHeader) )
+        {
+            return false;
+        }
+
+        const RecordIndexHeader* pHeader = reinterpret_cast<const RecordIndexHeader*>( pIndex );
+        if ( pHeader->m_magic != RECORD_INDEX_MAGIC ||
+             pHeader->m_version != RECORD_INDEX_VERSION ||
+             pHeader->m_complete != 1 ||
+             pHeader->m_recordFileSize != m_recordFileSize ||
+             pHeader->m_frameTableOffset + pHeader->m_frameCount * sizeof(RecordFrameEntry) > indexSize ||
+             pHeader->m_trackTableOffset + pHeader->m_trackCount * sizeof(RecordTrackEntry) > indexSize )
+        {
+            return false;
+        }
+
+        m_pFrames = reinterpret_cast<const RecordFrameEntry*>( pIndex + pHeader->m_frameTableOffset );
+        m_pTracks = reinterpret_cast<const RecordTrackEntry*>( pIndex + pHeader->m_trackTableOffset );
+        m_pHeader = pHeader;
+        return true;
+    }
+
+    /********************************************************************
+    ReadFrame
+        Parses the lines of a frame and keeps the matching records
+    Exceptions:
+        None
+    *********************************************************************/
+    void RecordQuery::ReadFrame( const RecordFrameEntry&    frame,
+                                 const RecordFilter&        filter,
+                                 std::vector<BlobRecord>&   records ) const
+    {
+        if ( frame.m_offset >= m_recordFileSize )
+        {
+            return;
+        }
+
+        const char* pPosition   = m_pRecords + frame.m_offset;
+        const char* pEnd        = m_pRecords + m_recordFileSize;
+
+        BlobRecord record;
+        for ( boost::uint32_t i = 0; i < frame.m_recordCount && pPosition < pEnd; i++ )
+        {
+            if ( !ParseRecordLine( pPosition, pEnd, record ) )
+            {
+                continue;
+            }
+
+            if ( filter.m_hasId && record.m_id != filter.m_id )
+            {
+                continue;
+            }
+
+            if ( filter.m_hasBox )
+            {
+                const cv::Rect box = GetRecordBox( record );
+                if ( !IntersectsBox( box.x, box.y, box.x + box.width, box.y + box.height, filter.m_box ) )
+                {
+                    continue;
+                }
+            }
+
+            records.push_back( record );
+        }
+    }
+
+    /********************************************************************
+    Find
+        Narrows the frames with the track table, skips frames whose
+        boxes miss the query box, and parses only the remaining lines
+    Exceptions:
+        None
+    *********************************************************************/
+    void RecordQuery::Find( const RecordFilter&         filter,
+                            std::vector<BlobRecord>&    records ) const
+    {
+        ASSERT_TRUE( IsOpened() );
+
+        int firstFrame  = filter.m_firstFrame;
+        int lastFrame   = filter.m_lastFrame;
+
+        if ( filter.m_hasId )
+        {
+            const RecordTrackEntry* pTracksEnd = m_pTracks + m_pHeader->m_trackCount;
+            const RecordTrackEntry* pTrack = std::lower_bound( m_pTracks, pTracksEnd, filter.m_id, TrackBefore );
+            if ( pTrack == pTracksEnd || pTrack->m_id != filter.m_id )
+            {
+                return;
+            }
+
+            if ( filter.m_hasBox &&
+                 !IntersectsBox( pTrack->m_minX, pTrack->m_minY, pTrack->m_maxX, pTrack->m_maxY, filter.m_box ) )
+            {
+                return;
+            }
+
+            firstFrame  = std::max( firstFrame, (int)pTrack->m_firstFrame );
+            lastFrame   = std::min( lastFrame, (int)pTrack->m_lastFrame );
+        }
+
+        const RecordFrameEntry* pFramesEnd = m_pFrames + m_pHeader->m_frameCount;
+        for ( const RecordFrameEntry* pFrame = std::lower_bound( m_pFrames, pFramesEnd, firstFrame, FrameBefore );
+              pFrame != pFramesEnd && pFrame->m_frameNumber <= lastFrame;
+              ++pFrame )
+        {
+            if ( filter.m_hasBox &&
+                 !IntersectsBox( pFrame->m_minX, pFrame->m_minY, pFrame->m_maxX, pFrame->m_maxY, filter.m_box ) )
+            {
+                continue;
+            }
+
+            ReadFrame( *pFrame, filter, records );
+        }
+    }
+}
@@ -0,0 +1,226 @@
+#ifndef RECORD_INDEX_H
+#define RECORD_INDEX_H
+
+#include "OpenCvDefinitions.h"
+#include "CommonMacros.h"
+
+#include <boost/cstdint.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+#include <limits.h>
+#include <stdio.h>
+
+namespace Tracker
+{
+    /*
+    *   One line of a record file.
+    */
+    struct BlobRecord
+    {
+        int                 m_frameNumber;
+        int                 m_x;                // centre of the box
+        int                 m_y;
+        int                 m_width;
+        int                 m_height;
+        int                 m_id;
+        double              m_timestamp;
+    };
+
+    // Box of a record
+    cv::Rect    GetRecordBox( const BlobRecord& record );
+
+    /*
+    *   Sidecar index <record file>.idx of a record file whose lines are
+    *   in frame order. The header is followed by one RecordFrameEntry per
+    *   frame with records, in frame order, and one RecordTrackEntry per
+    *   track, in ID order.
+    */
+    struct RecordIndexHeader
+    {
+        boost::uint32_t     m_magic;            // 'BTRI'
+        boost::uint32_t     m_version;
+        boost::uint32_t     m_complete;         // set once the index matches the record file
+        boost::uint32_t     m_reserved;
+        boost::uint64_t     m_recordFileSize;
+        boost::uint64_t     m_frameCount;
+        boost::uint64_t     m_frameTableOffset;
+        boost::uint64_t     m_trackCount;
+        boost::uint64_t     m_trackTableOffset;
+    };
+
+    struct RecordFrameEntry
+    {
+        boost::int32_t      m_frameNumber;
+        boost::uint32_t     m_recordCount;
+        boost::uint64_t     m_offset;           // first line of the frame
+        boost::int32_t      m_minX;             // union of the boxes of the frame
+        boost::int32_t      m_minY;
+        boost::int32_t      m_maxX;
+        boost::int32_t      m_maxY;
+    };
+
+    struct RecordTrackEntry
+    {
+        boost::int32_t      m_id;
+        boost::int32_t      m_firstFrame;
+        boost::int32_t      m_lastFrame;
+        boost::uint32_t     m_recordCount;
+        boost::int32_t      m_minX;             // union of the boxes of the track
+        boost::int32_t      m_minY;
+        boost::int32_t      m_maxX;
+        boost::int32_t      m_maxY;
+    };
+
+    /*
+    *   Builds the index while the records are written. Frame entries are
+    *   streamed to the index file, track entries are kept until Close.
+    */
+    class RecordIndexBuilder
+    {
+    public:
+    // Constructor
+    explicit RecordIndexBuilder( const std::string& indexFileName );
+
+    // Destructor
+    ~RecordIndexBuilder( );
+
+    // Add a record written at the given offset of the record file
+    void Add( const BlobRecord&         record,
+              const boost::uint64_t     offset );
+
+    // Write the track table and mark the index complete
+    void Close( const boost::uint64_t recordFileSize );
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( RecordIndexBuilder );
+
+    // Write the entry of the current frame
+    void FlushFrame( );
+
+    FILE*                               m_pIndexFile;
+    RecordIndexHeader                   m_header;
+    RecordFrameEntry                    m_frame;
+    std::map<int, RecordTrackEntry>     m_tracks;
+    };
+
+    /*
+    *   Writes a record file and its index.
+    */
+    class RecordWriter
+    {
+    public:
+    // Constructor
+    explicit RecordWriter( const std::string& recordFileName );
+
+    // Constructor continuing a record file after its first keptBytes,
+    // the records written up to a checkpoint
+    RecordWriter( const std::string&        recordFileName,
+                  const boost::uint64_t     keptBytes );
+
+    // Destructor
+    ~RecordWriter( );
+
+    bool IsOpened( ) const  { return m_pRecordFile != NULL; }
+
+    // Append a record, records must come in frame order
+    void Write( const BlobRecord& record );
+
+    // Write the appended records to the file
+    void Flush( );
+
+    // Bytes of the record file written so far
+    boost::uint64_t GetOffset( ) const  { return m_offset; }
+
+    // Close the record file and complete the index
+    void Close( );
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( RecordWriter );
+
+    FILE*                           m_pRecordFile;
+    RecordIndexBuilder*             m_pIndexBuilder;
+    boost::uint64_t                 m_offset;
+    int                             m_lastFrame;
+    };
+
+    /*
+    *   Selects records by track, frame range and box; unset criteria
+    *   match every record.
+    */
+    struct RecordFilter
+    {
+        RecordFilter( )
+            : m_hasId( false ),
+            m_id( 0 ),
+            m_firstFrame( INT_MIN ),
+            m_lastFrame( INT_MAX ),
+            m_hasBox( false ),
+            m_box( )
+        {
+        }
+
+        bool                m_hasId;
+        int                 m_id;
+        int                 m_firstFrame;
+        int                 m_lastFrame;
+        bool                m_hasBox;
+        cv::Rect            m_box;              // records whose box intersects it
+    };
+
+    /*
+    *   Answers record queries from the memory-mapped record file and
+    *   index. A missing or outdated index is rebuilt first.
+    */
+    class RecordQuery
+    {
+    public:
+    // Constructor
+    explicit RecordQuery( const std::string& recordFileName );
+
+    // Destructor
+    ~RecordQuery( );
+
+    bool IsOpened( ) const  { return m_pHeader != NULL; }
+
+    // Find the records matching the filter, in frame order
+    void Find( const RecordFilter&          filter,
+               std::vector<BlobRecord>&     records ) const;
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( RecordQuery );
+
+    // Map the index, false when it does not match the record file
+    bool MapIndex( const std::string& indexFileName );
+
+    // Parse the records of one frame entry
+    void ReadFrame( const RecordFrameEntry&     frame,
+                    const RecordFilter&         filter,
+                    std::vector<BlobRecord>&    records ) const;
+
+    class Mapping;
+
+    Mapping*                        m_pMapping;
+    const char*                     m_pRecords;
+    boost::uint64_t                 m_recordFileSize;
+    const RecordIndexHeader*        m_pHeader;
+    const RecordFrameEntry*         m_pFrames;
+    const RecordTrackEntry*         m_pTracks;
+    };
+
+    // Name of the index of a record file
+    std::string GetRecordIndexName( const std::string& recordFileName );
+
+    // Index an existing record file
+    bool        BuildRecordIndex( const std::string& recordFileName );
+
+    // Parse one record line, advancing the position past it
+    bool        ParseRecordLine( const char*&   pPosition,
+                                 const char*    pEnd,
+                                 BlobRecord&    record );
+}
+#endif
@@ -0,0 +1,639 @@
+#include "Regression.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <math.h>
+
+// size and rate of the synthetic clips
+#define CLIP_WIDTH                  320
+#define CLIP_HEIGHT                 240
+#define CLIP_FRAME_RATE             25
+
+// defaults of the clip settings of a case
+#define DEFAULT_CLIP_FRAMES         150
+#define DEFAULT_CLIP_OBJECTS        3
+
+// the first object enters after the background is trained, the others follow
+#define CLIP_FIRST_ENTRY_FRAME      10
+#define CLIP_ENTRY_INTERVAL         20
+
+// boxes overlapping by this much can be matched
+#define MIN_TRACK_OVERLAP           0.5
+
+namespace Tracker
+{
+    /*
+    *   Linear congruential generator, so that a clip is the same on
+    *   every platform and run.
+    */
+    class ClipRandom
+    {
+    public:
+    explicit ClipRandom( const unsigned int seed )
+        : m_state( seed )
+    {
+    }
+
+    // Uniform integer in [low, high]
+    int Range( const int low, const int high )
+    {
+        m_state = m_state * 1103515245u + 12345u;
+        return low + (int)( ( m_state >> 16 ) % (unsigned int)( high - low + 1 ) );
+    }
+
+    private:
+
+    unsigned int                    m_state;
+    };
+
+    /*
+    *   A box moving over the clip at constant speed, bouncing off the
+    *   borders.
+    */
+    struct ClipObject
+    {
+        double              m_x;                // top left corner
+        double              m_y;
+        double              m_vx;               // pixels per frame
+        double              m_vy;
+        int                 m_width;
+        int                 m_height;
+        int                 m_entryFrame;
+        unsigned char       m_luma;
+        unsigned char       m_u;
+        unsigned char       m_v;
+    };
+
+    /********************************************************************
+    GetOverlap
+        Intersection over union of two boxes
+    Exceptions:
+        None
+    *********************************************************************/
+    static double GetOverlap( const cv::Rect& first, const cv::Rect& second )
+    {
+        const double intersection = ( first & second ).area();
+        const double unionArea    = first.area() + second.area() - intersection;
+        return unionArea > 0 ? intersection / unionArea : 0.0;
+    }
+
+    /********************************************************************
+    GetMota / GetPositionError
+        Summaries of the CLEAR-MOT counts
+    Exceptions:
+        None
+    *********************************************************************/
+    double TrackAccuracy::GetMota( ) const
+    {
+        if ( m_referenceBoxes == 0 )
+        {
+            return m_falsePositives == 0 ? 1.0 : 0.0;
+        }
+        return 1.0 - (double)( m_misses + m_falsePositives + m_idSwitches ) / m_referenceBoxes;
+    }
+
+    double TrackAccuracy::GetPositionError( ) const
+    {
+        return m_matches > 0 ? m_totalDistance / m_matches : 0.0;
+    }
+
+    /********************************************************************
+    CompareTracks
+        Matches the tracked boxes to the reference boxes frame by frame.
+        A match of the previous frame is kept while the boxes overlap,
+        the remaining boxes are matched greedily by overlap. A reference
+        track matched to another ID than before is an ID switch.
+    Exceptions:
+        None
+    *********************************************************************/
+    TrackAccuracy CompareTracks( const std::vector<BlobRecord>&   reference,
+                                 const std::vector<BlobRecord>&   tracked,
+                                 const double                     minOverlap )
+    {
+        typedef std::map< int, std::vector<const BlobRecord*> > FrameRecords;
+
+        FrameRecords        referenceFrames, trackedFrames;
+        std::set<int>       frames;
+
+        for ( unsigned int i = 0; i < reference.size(); i++ )
+        {
+            referenceFrames[reference[i].m_frameNumber].push_back( &reference[i] );
+            frames.insert( reference[i].m_frameNumber );
+        }
+        for ( unsigned int i = 0; i < tracked.size(); i++ )
+        {
+            trackedFrames[tracked[i].m_frameNumber].push_back( &tracked[i] );
+            frames.insert( tracked[i].m_frameNumber );
+        }
+
+        TrackAccuracy           accuracy;
+        std::map<int, int>      lastMatch;          // reference ID -> tracked ID
+
+        for ( std::set<int>::const_iterator frameIt = frames.begin(); frameIt != frames.end(); ++frameIt )
+        {
+            const std::vector<const BlobRecord*>& references = referenceFrames[*frameIt];
+            const std::vector<const BlobRecord*>& tracks     = trackedFrames[*frameIt];
+
+            std::vector<int>    referenceMatch( references.size(), -1 );
+            std::vector<bool>   trackMatched( tracks.size(), false );
+
+            // keep the correspondences of the previous frame
+            for ( unsigned int r = 0; r < references.size(); r++ )
+            {
+                std::map<int, int>::const_iterator lastIt = lastMatch.find( references[r]->m_id );
+                if ( lastIt == lastMatch.end() )
+                {
+                    continue;
+                }
+
+                for ( unsigned int t = 0; t < tracks.size(); t++ )
+                {
+                    if ( !trackMatched[t] && tracks[t]->m_id == lastIt->second &&
+                         GetOverlap( GetRecordBox( *references[r] ), GetRecordBox( *tracks[t] ) ) >= minOverlap )
+                    {
+                        referenceMatch[r]   = t;
+                        trackMatched[t]     = true;
+                        break;
+                    }
+                }
+            }
+
+            // match the others by decreasing overlap
+            std::vector< std::pair< double, std::pair<int, int> > > candidates;
+            for ( unsigned int r = 0; r < references.size(); r++ )
+            {
+                for ( unsigned int t = 0; t < tracks.size() && referenceMatch[r] < 0; t++ )
+                {
+                    const double overlap = trackMatched[t] ? 0.0 : GetOverlap( GetRecordBox( *references[r] ), GetRecordBox( *tracks[t] ) );
+                    if ( overlap >= minOverlap && overlap > 0 )
+                    {
+                        candidates.push_back( std::make_pair( overlap, std::make_pair( (int)r, (int)t ) ) );
+                    }
+                }
+            }
+            std::sort( candidates.rbegin(), candidates.rend() );
+
+            for ( unsigned int i = 0; i < candidates.size(); i++ )
+            {
+                const int r = candidates[i].second.first;
+                const int t = candidates[i].second.second;
+                if ( referenceMatch[r] < 0 && !trackMatched[t] )
+                {
+                    referenceMatch[r]   = t;
+                    trackMatched[t]     = true;
+                }
+            }
+
+            // count the frame
+            for ( unsigned int r = 0; r < references.size(); r++ )
+            {
+                accuracy.m_referenceBoxes++;
+
+                if ( referenceMatch[r] < 0 )
+                {
+                    accuracy.m_misses++;
+                    continue;
+                }
+
+                const BlobRecord& match = *tracks[referenceMatch[r]];
+
+                std::map<int, int>::iterator lastIt = lastMatch.find( references[r]->m_id );
+                if ( lastIt != lastMatch.end() && lastIt->second != match.m_id )
+                {
+                    accuracy.m_idSwitches++;
+                }
+                lastMatch[references[r]->m_id] = match.m_id;
+
+                const double dx = match.m_x - references[r]->m_x;
+                const double dy = match.m_y - references[r]->m_y;
+                accuracy.m_totalDistance += sqrt( dx * dx + dy * dy );
+                accuracy.m_matches++;
+            }
+
+            accuracy.m_falsePositives += (int)std::count( trackMatched.begin(), trackMatched.end(), false );
+        }
+
+        return accuracy;
+    }
+
+    /********************************************************************
+    ReadRecordFile
+        Reads all records of a record file
+    Exceptions:
+        None
+    *********************************************************************/
+    bool ReadRecordFile( const std::string&         recordFileName,
+                         std::vector<BlobRecord>&   records )
+    {
+        std::ifstream recordFile( recordFileName.c_str(), std::ios::binary );
+        if ( !recordFile.is_open() )
+        {
+            return false;
+        }
+
+        std::ostringstream content;
+        content << recordFile.rdbuf();
+        const std::string text = content.str();
+
+        const char* pPosition   = text.data();
+        const char* pEnd        = text.data() + text.size();
+
+        BlobRecord record;
+        while ( pPosition < pEnd )
+        {
+            if ( ParseRecordLine( pPosition, pEnd, record ) )
+            {
+                records.push_back( record );
+            }
+        }
+        return true;
+    }
+
+    /********************************************************************
+    Constructor for class RegressionSuite
+    *********************************************************************/
+    RegressionSuite::RegressionSuite( const std::string& suiteFileName )
+        : m_suiteFileName( suiteFileName ),
+        m_goldenDirectory( ),
+        m_outputDirectory( ),
+        m_minMota( 1.0 ),
+        m_maxPositionError( 0 ),
+        m_fpsTolerance( 0 ),
+        m_memoryTolerance( 0 ),
+        m_cases( )
+    {
+        const size_t separator = suiteFileName.find_last_of( "/\\" );
+        m_goldenDirectory = ( separator == std::string::npos ) ? std::string( "." ) : suiteFileName.substr( 0, separator );
+    }
+
+    /*************************************************************************
+    Initialize
+        Read the cases listed in the suite file
+    Exceptions
+        None
+    *************************************************************************/
+    void RegressionSuite::Initialize( const InputParameters& baseParams )
+    {
+        m_outputDirectory   = baseParams.m_outputVideoDirectory;
+        m_minMota           = baseParams.m_regressionMinMota;
+        m_maxPositionError  = baseParams.m_regressionMaxPositionError;
+        m_fpsTolerance      = baseParams.m_regressionFpsTolerance / 100.0;
+        m_memoryTolerance   = baseParams.m_regressionMemoryTolerance / 100.0;
+
+        std::ifstream suiteFile( m_suiteFileName.c_str() );
+        if ( !suiteFile.is_open() )
+        {
+            LOG_FILE( "Unable to open regression suite " + m_suiteFileName );
+            AbortError( __LINE__, __FILE__, "Unable to open regression suite" );
+        }
+
+        std::string line;
+        while ( std::getline( suiteFile, line ) )
+        {
+            // skip comments and blank lines
+            std::istringstream tokens( line );
+            std::string name;
+            if ( !( tokens >> name ) || name[0] == '#' )
+            {
+                continue;
+            }
+
+            RegressionCase regressionCase;
+            regressionCase.m_name       = name;
+            regressionCase.m_params     = baseParams;
+            regressionCase.m_frames     = DEFAULT_CLIP_FRAMES;
+            regressionCase.m_objects    = DEFAULT_CLIP_OBJECTS;
+            regressionCase.m_seed       = (unsigned int)m_cases.size() + 1;
+
+            // clip settings are written without spaces, config settings follow
+            std::streampos settingsStart = tokens.tellg();
+            std::string token;
+            while ( tokens >> token )
+            {
+                if ( sscanf( token.c_str(), "frames=%d", &regressionCase.m_frames ) != 1 &&
+                     sscanf( token.c_str(), "objects=%d", &regressionCase.m_objects ) != 1 &&
+                     sscanf( token.c_str(), "seed=%u", &regressionCase.m_seed ) != 1 )
+                {
+                    break;
+                }
+                settingsStart = tokens.tellg();
+            }
+
+            const std::string settings = ( settingsStart == std::streampos( -1 ) ) ? std::string() : line.substr( (size_t)settingsStart );
+            if ( ParseConfigOverride( settings.c_str(), &regressionCase.m_params ) != 0 ||
+                 regressionCase.m_frames < 2 || regressionCase.m_objects < 0 )
+            {
+                LOG_FILE( "Invalid settings for regression case " + name );
+                AbortError( __LINE__, __FILE__, "Invalid settings in regression suite" );
+            }
+
+            m_cases.push_back( regressionCase );
+        }
+
+        if ( m_cases.empty() )
+        {
+            AbortError( __LINE__, __FILE__, "No cases in regression suite" );
+        }
+    }
+
+    /*************************************************************************
+    WriteClip
+        Write the Y4M clip of a case: a textured static background with
+        sensor noise and boxes of distinct colors entering one after the
+        other. The boxes are also written as the true tracks.
+    Exceptions
+        None
+    *************************************************************************/
+    void RegressionSuite::WriteClip( const RegressionCase&  regressionCase,
+                                     const std::string&     clipFileName,
+                                     const std::string&     truthFileName ) const
+    {
+        ClipRandom random( regressionCase.m_seed );
+
+        std::vector<ClipObject> objects( regressionCase.m_objects );
+        for ( unsigned int i = 0; i < objects.size(); i++ )
+        {
+            ClipObject& object = objects[i];
+            object.m_width      = random.Range( 16, 40 );
+            object.m_height     = random.Range( 16, 40 );
+            object.m_x          = random.Range( 0, CLIP_WIDTH - object.m_width );
+            object.m_y          = random.Range( 0, CLIP_HEIGHT - object.m_height );
+            object.m_vx         = random.Range( 10, 30 ) / 10.0 * ( random.Range( 0, 1 ) ? 1 : -1 );
+            object.m_vy         = random.Range( 10, 30 ) / 10.0 * ( random.Range( 0, 1 ) ? 1 : -1 );
+            object.m_entryFrame = CLIP_FIRST_ENTRY_FRAME + CLIP_ENTRY_INTERVAL * i;
+            object.m_luma       = (unsigned char)random.Range( 160, 235 );
+            object.m_u          = (unsigned char)random.Range( 40, 216 );
+            object.m_v          = (unsigned char)random.Range( 40, 216 );
+        }
+
+        FILE* pClip = fopen( clipFileName.c_str(), "wb" );
+        if ( pClip == NULL )
+        {
+            LOG_FILE( "Unable to write regression clip " + clipFileName );
+            AbortError( __LINE__, __FILE__, "Unable to write regression clip" );
+        }
+        fprintf( pClip, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", CLIP_WIDTH, CLIP_HEIGHT, CLIP_FRAME_RATE );
+
+        RecordWriter truthWriter( truthFileName );
+        if ( !truthWriter.IsOpened() )
+        {
+            LOG_FILE( "Unable to write true tracks " + truthFileName );
+            AbortError( __LINE__, __FILE__, "Unable to write true tracks" );
+        }
+
+        std::vector<unsigned char> lumaPlane( CLIP_WIDTH * CLIP_HEIGHT );
+        std::vector<unsigned char> uPlane( CLIP_WIDTH * CLIP_HEIGHT / 4 );
+        std::vector<unsigned char> vPlane( CLIP_WIDTH * CLIP_HEIGHT / 4 );
+
+        for ( int frame = 0; frame < regressionCase.m_frames; frame++ )
+        {
+            for ( int y = 0; y < CLIP_HEIGHT; y++ )
+            {
+                for ( int x = 0; x < CLIP_WIDTH; x++ )
+                {
+                    lumaPlane[y * CLIP_WIDTH + x] = (unsigned char)( 60 + ( ( x / 8 + y / 8 ) % 8 ) * 6 + random.Range( -2, 2 ) );
+                }
+            }
+            std::fill( uPlane.begin(), uPlane.end(), (unsigned char)128 );
+            std::fill( vPlane.begin(), vPlane.end(), (unsigned char)128 );
+
+            for ( unsigned int i = 0; i < objects.size(); i++ )
+            {
+                ClipObject& object = objects[i];
+                if ( frame < object.m_entryFrame )
+                {
+                    continue;
+                }
+
+                const int left  = cvRound( object.m_x );
+                const int top   = cvRound( object.m_y );
+                for ( int y = top; y < top + object.m_height; y++ )
+                {
+                    for ( int x = left; x < left + object.m_width; x++ )
+                    {
+                        lumaPlane[y * CLIP_WIDTH + x] = object.m_luma;
+                        uPlane[( y / 2 ) * ( CLIP_WIDTH / 2 ) + x / 2] = object.m_u;
+                        vPlane[( y / 2 ) * ( CLIP_WIDTH / 2 ) + x / 2] = object.m_v;
+                    }
+                }
+
+                // the first frame only trains the tracker, its frame numbers start after it
+                if ( frame > 0 )
+                {
+                    BlobRecord record;
+                    record.m_frameNumber    = frame;
+                    record.m_x              = left + object.m_width / 2;
+                    record.m_y              = top + object.m_height / 2;
+                    record.m_width          = object.m_width;
+                    record.m_height         = object.m_height;
+                    record.m_id             = (int)i;
+                    record.m_timestamp      = (double)frame / CLIP_FRAME_RATE;
+                    truthWriter.Write( record );
+                }
+
+                // move on, bouncing off the borders
+                object.m_x += object.m_vx;
+                object.m_y += object.m_vy;
+                if ( object.m_x < 0 || object.m_x > CLIP_WIDTH - object.m_width )
+                {
+                    object.m_vx = -object.m_vx;
+                    object.m_x  = std::min( std::max( object.m_x, 0.0 ), (double)( CLIP_WIDTH - object.m_width ) );
+                }
+                if ( object.m_y < 0 || object.m_y > CLIP_HEIGHT - object.m_height )
+                {
+                    object.m_vy = -object.m_vy;
+                    object.m_y  = std::min( std::max( object.m_y, 0.0 ), (double)( CLIP_HEIGHT - object.m_height ) );
+                }
+            }
+
+            fputs( "FRAME\n", pClip );
+            fwrite( &lumaPlane[0], lumaPlane.size(), 1, pClip );
+            fwrite( &uPlane[0], uPlane.size(), 1, pClip );
+            fwrite( &vPlane[0], vPlane.size(), 1, pClip );
+        }
+
+        truthWriter.Close();
+        fclose( pClip );
+    }
+
+    /*************************************************************************
+    RunCase
+        Track the clip of a case and measure its frame rate and memory.
+        The memory is the peak growth of the process resident set over
+        the case, sampled after every frame, so it is measured rather
+        than taken from the estimates of the camera
+    Exceptions
+        None
+    *************************************************************************/
+    void RegressionSuite::RunCase( const RegressionCase& regressionCase,
+                                   CaseResult&           result ) const
+    {
+        const std::string clipFileName = m_outputDirectory + "/" + regressionCase.m_name + "_clip.y4m";
+        result.m_truthFileName  = m_outputDirectory + "/" + regressionCase.m_name + "_truth.txt";
+        result.m_recordFileName = m_outputDirectory + "/" + regressionCase.m_name + "_record.txt";
+
+        WriteClip( regressionCase, clipFileName, result.m_truthFileName );
+
+        // nothing may vary with the machine load but the frame rate
+        InputParameters params = regressionCase.m_params;
+        params.m_displayIntermediateResult  = 0;
+        params.m_saveIntermediateResult     = 0;
+        params.m_realTimeMode               = 0;
+        params.m_memoryBudgetMB             = 0;
+        params.m_resume                     = 0;
+
+        CameraPtr pCamera( new Camera( m_outputDirectory, "y4m:" + clipFileName ) );
+        pCamera->ApplySettings( params );
+        pCamera->SetOutputName( regressionCase.m_name );
+        pCamera->Initialize( params.m_fgDetectionParams,
+                             params.m_blobDetectionParams,
+                             params.m_blobTrackerParams,
+                             params.m_blobAnalysisParams,
+                             params.m_blobPostProcessingParams );
+
+        const size_t startResidentBytes = GetProcessResidentBytes( );
+        size_t       peakResidentBytes  = startResidentBytes;
+
+        const int64 startTicks = cv::getTickCount();
+
+        pCamera->BeginProcessing( 0, -1 );
+        while ( pCamera->ProcessNextFrame( ) )
+        {
+            pCamera->WaitForFrameDue( );
+            peakResidentBytes = std::max( peakResidentBytes, GetProcessResidentBytes() );
+        }
+        pCamera->EndProcessing( );
+
+        const double seconds = ( cv::getTickCount() - startTicks ) / cv::getTickFrequency();
+
+        result.m_fps                = seconds > 0 ? pCamera->GetStats().m_framesProcessed / seconds : 0.0;
+        result.m_peakResidentBytes  = peakResidentBytes - startResidentBytes;
+
+        // the record file is complete once the camera is gone
+        pCamera.reset();
+    }
+
+    /*************************************************************************
+    CheckCase
+        Compare the tracks with the golden records and the frame rate and
+        resident memory growth with the baseline
+    Exceptions
+        None
+    *************************************************************************/
+    bool RegressionSuite::CheckCase( const RegressionCase&  regressionCase,
+                                     const CaseResult&      result ) const
+    {
+        const std::string goldenFileName    = m_goldenDirectory + "/" + regressionCase.m_name + "_golden_record.txt";
+        const std::string baselineFileName  = m_goldenDirectory + "/" + regressionCase.m_name + "_baseline.txt";
+
+        std::vector<BlobRecord> golden, tracked, truth;
+        double baselineFps = 0;
+        unsigned long baselineMemory = 0;
+
+        FILE* pBaseline = fopen( baselineFileName.c_str(), "r" );
+        const bool hasBaseline = pBaseline != NULL &&
+                                 fscanf( pBaseline, " fps %lf peak_resident_bytes %lu", &baselineFps, &baselineMemory ) == 2;
+        if ( pBaseline != NULL )
+        {
+            fclose( pBaseline );
+        }
+
+        if ( !ReadRecordFile( goldenFileName, golden ) || !hasBaseline )
+        {
+            LOG( regressionCase.m_name << ": FAIL, no golden files, record them with -r " << m_suiteFileName << " update" );
+            return false;
+        }
+
+        ReadRecordFile( result.m_recordFileName, tracked );
+        ReadRecordFile( result.m_truthFileName, truth );
+
+        const TrackAccuracy accuracy        = CompareTracks( golden, tracked, MIN_TRACK_OVERLAP );
+        const TrackAccuracy truthAccuracy   = CompareTracks( truth, tracked, MIN_TRACK_OVERLAP );
+
+        const bool accurate     = accuracy.GetMota() >= m_minMota && accuracy.GetPositionError() <= m_maxPositionError;
+        const bool fast         = result.m_fps >= baselineFps * ( 1.0 - m_fpsTolerance );
+        const bool small        = result.m_peakResidentBytes <= baselineMemory * ( 1.0 + m_memoryTolerance );
+
+        LOG( regressionCase.m_name << ": " << ( accurate && fast && small ? "PASS" : "FAIL" ) <<
+             " MOTA " << accuracy.GetMota() << ( accurate ? "" : " (accuracy)" ) <<
+             ", ID switches " << accuracy.m_idSwitches << ", position error " << accuracy.GetPositionError() <<
+             " px, fps " << result.m_fps << " / " << baselineFps << ( fast ? "" : " (slower)" ) <<
+             ", resident growth " << result.m_peakResidentBytes / 1024 << " / " << baselineMemory / 1024 << " KB" << ( small ? "" : " (larger)" ) <<
+             ", MOTA on the true tracks " << truthAccuracy.GetMota() );
+
+        return accurate && fast && small;
+    }
+
+    /*************************************************************************
+    UpdateCase
+        Record the tracks, frame rate and resident memory growth of a run
+        as golden
+    Exceptions
+        None
+    *************************************************************************/
+    void RegressionSuite::UpdateCase( const RegressionCase& regressionCase,
+                                      const CaseResult&     result ) const
+    {
+        const std::string goldenFileName    = m_goldenDirectory + "/" + regressionCase.m_name + "_golden_record.txt";
+        const std::string baselineFileName  = m_goldenDirectory + "/" + regressionCase.m_name + "_baseline.txt";
+
+        std::ifstream recordFile( result.m_recordFileName.c_str(), std::ios::binary );
+        std::ofstream goldenFile( goldenFileName.c_str(), std::ios::binary );
+        if ( !recordFile.is_open() || !goldenFile.is_open() || !( goldenFile << recordFile.rdbuf() ) )
+        {
+            LOG_FILE( "Unable to write golden records " + goldenFileName );
+            AbortError( __LINE__, __FILE__, "Unable to write golden records" );
+        }
+
+        FILE* pBaseline = fopen( baselineFileName.c_str(), "w" );
+        if ( pBaseline == NULL )
+        {
+            LOG_FILE( "Unable to write baseline " + baselineFileName );
+            AbortError( __LINE__, __FILE__, "Unable to write baseline" );
+        }
+        fprintf( pBaseline, "fps %f\npeak_resident_bytes %lu\n", result.m_fps, (unsigned long)result.m_peakResidentBytes );
+        fclose( pBaseline );
+
+        std::vector<BlobRecord> tracked, truth;
+        ReadRecordFile( result.m_recordFileName, tracked );
+        ReadRecordFile( result.m_truthFileName, truth );
+
+        LOG( regressionCase.m_name << ": recorded, " << tracked.size() << " records, fps " << result.m_fps <<
+             ", resident growth " << result.m_peakResidentBytes / 1024 << " KB, MOTA on the true tracks " <<
+             CompareTracks( truth, tracked, MIN_TRACK_OVERLAP ).GetMota() );
+    }
+
+    /*************************************************************************
+    Run
+        Run every case and check it, or record it in update mode
+    Exceptions
+        None
+    *************************************************************************/
+    int RegressionSuite::Run( const bool update )
+    {
+        int failures = 0;
+        for ( unsigned int i = 0; i < m_cases.size(); i++ )
+        {
+            CaseResult result;
+            RunCase( m_cases[i], result );
+
+            if ( update )
+            {
+                UpdateCase( m_cases[i], result );
+            }
+            else if ( !CheckCase( m_cases[i], result ) )
+            {
+                failures++;
+            }
+        }
+
+        if ( !update )
+        {
+            LOG( m_cases.size() - failures << " of " << m_cases.size() << " regression cases passed" );
+        }
+        return failures;
+    }
+}
@@ -0,0 +1,129 @@
+#ifndef REGRESSION_H
+#define REGRESSION_H
+
+#include "Camera.h"
+#include "RecordIndex.h"
+
+#include <string>
+#include <vector>
+
+namespace Tracker
+{
+    /*
+    *   CLEAR-MOT counts of tracks compared with reference tracks.
+    */
+    struct TrackAccuracy
+    {
+        TrackAccuracy( )
+            : m_referenceBoxes( 0 ),
+            m_matches( 0 ),
+            m_misses( 0 ),
+            m_falsePositives( 0 ),
+            m_idSwitches( 0 ),
+            m_totalDistance( 0 )
+        {
+        }
+
+        // 1 - ( misses + false positives + ID switches ) / reference boxes
+        double GetMota( ) const;
+
+        // Mean distance of the matched box centres in pixels
+        double GetPositionError( ) const;
+
+        int                 m_referenceBoxes;
+        int                 m_matches;
+        int                 m_misses;
+        int                 m_falsePositives;
+        int                 m_idSwitches;
+        double              m_totalDistance;
+    };
+
+    // Match the tracks frame by frame, boxes overlapping by minOverlap
+    // ( intersection over union ) or more can match
+    TrackAccuracy   CompareTracks( const std::vector<BlobRecord>&  reference,
+                                   const std::vector<BlobRecord>&  tracked,
+                                   const double                    minOverlap );
+
+    // Read all records of a record file
+    bool            ReadRecordFile( const std::string&          recordFileName,
+                                    std::vector<BlobRecord>&    records );
+
+    /*
+    *   One case of a regression suite: a module combination run on a
+    *   synthetic clip.
+    */
+    struct RegressionCase
+    {
+        std::string         m_name;
+        InputParameters     m_params;
+        int                 m_frames;           // clip length
+        int                 m_objects;          // moving objects in the clip
+        unsigned int        m_seed;             // of the clip generator
+    };
+
+    /*
+    *   Golden-output regression suite. Each case tracks a deterministic
+    *   synthetic clip and is checked against the records, frame rate and
+    *   resident memory growth recorded by an earlier run in update mode.
+    *
+    *   Each line of the suite file is a case name, optional clip settings
+    *   and config settings, e.g.
+    *       ccmspf      frames=200 objects=3 Blob_Tracker_Module = "CCMSPF"
+    *       ms_mog      FG_Detection_Module = "FG_1" Blob_Tracker_Module = "MS"
+    *   The golden files <case>_golden_record.txt and <case>_baseline.txt
+    *   are kept next to the suite file.
+    */
+    class RegressionSuite
+    {
+    public:
+    // Constructor
+    explicit RegressionSuite( const std::string& suiteFileName );
+
+    // Read the cases on top of the base configuration
+    void Initialize( const InputParameters& baseParams );
+
+    // Run all cases, recording the golden files in update mode;
+    // returns the number of failed cases
+    int  Run( const bool update );
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( RegressionSuite );
+
+    // Measurements of one run of a case
+    struct CaseResult
+    {
+        double              m_fps;
+        size_t              m_peakResidentBytes;    // process growth over the case
+        std::string         m_recordFileName;
+        std::string         m_truthFileName;
+    };
+
+    // Write the synthetic clip of a case and its true tracks
+    void WriteClip( const RegressionCase&  regressionCase,
+                    const std::string&     clipFileName,
+                    const std::string&     truthFileName ) const;
+
+    // Track the clip of a case
+    void RunCase( const RegressionCase& regressionCase,
+                  CaseResult&           result ) const;
+
+    // Compare a run with the golden files, true when within the gates
+    bool CheckCase( const RegressionCase&  regressionCase,
+                    const CaseResult&      result ) const;
+
+    // Record a run as the golden files
+    void UpdateCase( const RegressionCase& regressionCase,
+                     const CaseResult&     result ) const;
+
+    std::string                     m_suiteFileName;
+    std::string                     m_goldenDirectory;
+    std::string                     m_outputDirectory;
+    double                          m_minMota;
+    double                          m_maxPositionError;
+    double                          m_fpsTolerance;         // fraction below the baseline
+    double                          m_memoryTolerance;      // fraction above the baseline
+    std::vector<RegressionCase>     m_cases;
+    };
+}
+#endif
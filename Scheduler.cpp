@@ -0,0 +1,506 @@
+#include "Scheduler.h"
+
+#include <boost/bind.hpp>
+
+#include <limits>
+
+namespace Tracker
+{
+    /********************************************************************
+    Constructor for class CameraScheduler
+    *********************************************************************/
+    CameraScheduler::CameraScheduler( const int workerThreads )
+        : m_workerThreads( std::max( 1, workerThreads ) ),
+        m_tasks( ),
+        m_unfinishedTasks( 0 ),
+        m_pSource( NULL ),
+        m_sourceExhausted( false ),
+        m_maxActiveCameras( 0 ),
+        m_startedCameras( 0 ),
+        m_runStartTicks( 0 ),
+        m_virtualClock( 0 ),
+        m_startSeconds( 0 ),
+        m_frameSeconds( 0 )
+    {
+    }
+
+    /********************************************************************
+    Destructor for class CameraScheduler
+    *********************************************************************/
+    CameraScheduler::~CameraScheduler( )
+    {
+    }
+
+    /********************************************************************
+    AddCamera
+        Adds a camera before the scheduler runs
+    Exceptions:
+        None
+    *********************************************************************/
+    void CameraScheduler::AddCamera( const CameraPtr&    pCamera,
+                                     const int           startFrameIndex,
+                                     const int           endFrameIndex )
+    {
+        AddTask( pCamera, startFrameIndex, endFrameIndex );
+    }
+
+    /********************************************************************
+    SetCameraSource
+        Takes further cameras from the source while running
+    Exceptions:
+        None
+    *********************************************************************/
+    void CameraScheduler::SetCameraSource( CameraSource*     pSource,
+                                           const int         maxActiveCameras )
+    {
+        m_pSource           = pSource;
+        m_sourceExhausted   = false;
+        m_maxActiveCameras  = std::max( 1, maxActiveCameras );
+    }
+
+    /********************************************************************
+    AddTask
+        Adds a camera with the weight and frame rate cap of its settings
+    Exceptions:
+        None
+    *********************************************************************/
+    void CameraScheduler::AddTask( const CameraPtr&   pCamera,
+                                   const int          startFrameIndex,
+                                   const int          endFrameIndex )
+    {
+        ASSERT_TRUE( pCamera != NULL );
+
+        CameraTask task;
+        task.m_pCamera          = pCamera;
+        task.m_startFrameIndex  = startFrameIndex;
+        task.m_endFrameIndex    = endFrameIndex;
+        task.m_started          = false;
+        task.m_weight           = std::max( 1, pCamera->GetScheduleWeight() );
+        task.m_minIntervalTicks = pCamera->GetMaxFrameRate() > 0 ? (int64)( cv::getTickFrequency() / pCamera->GetMaxFrameRate() ) : 0;
+        task.m_virtualTime      = 0;
+        task.m_dueTicks         = 0;
+        task.m_capped           = false;
+        task.m_running          = false;
+        task.m_finished         = false;
+        task.m_frames           = 0;
+        task.m_busySeconds      = 0;
+
+        m_tasks.push_back( task );
+        m_unfinishedTasks++;
+    }
+
+    /********************************************************************
+    FeedTasks
+        Adds cameras of the source until the active limit is reached or
+        the source is exhausted
+    Exceptions:
+        None
+    *********************************************************************/
+    void CameraScheduler::FeedTasks( )
+    {
+        while ( m_pSource != NULL && !m_sourceExhausted && m_unfinishedTasks < m_maxActiveCameras )
+        {
+            CameraPtr   pCamera;
+            int         startFrameIndex;
+            int         endFrameIndex;
+
+            if ( !m_pSource->NextCamera( pCamera, startFrameIndex, endFrameIndex ) )
+            {
+                m_sourceExhausted = true;
+                break;
+            }
+
+            AddTask( pCamera, startFrameIndex, endFrameIndex );
+        }
+    }
+
+    /********************************************************************
+    Run
+        Starts the workers and waits until every camera is done
+    Exceptions:
+        None
+    *********************************************************************/
+    void CameraScheduler::Run( )
+    {
+        if ( m_pSource != NULL )
+        {
+            LOG( "Scheduling " << m_tasks.size() << " cameras and those of the camera source, " <<
+                 m_maxActiveCameras << " at a time, on " << m_workerThreads << " workers" );
+        }
+        else
+        {
+            LOG( "Scheduling " << m_tasks.size() << " cameras on " << m_workerThreads << " workers" );
+        }
+
+        m_runStartTicks = cv::getTickCount();
+
+        try
+        {
+            boost::thread_group workers;
+            for ( int i = 0; i < m_workerThreads; i++ )
+            {
+                workers.create_thread( boost::bind( &CameraScheduler::WorkerLoop, this ) );
+            }
+            workers.join_all();
+        }
+        EXCEPTION_CATCH_AND_ABORT( "Failed to run the camera scheduler" );
+
+        LOG_FILE( "Started " << m_startedCameras << " cameras in " << m_startSeconds << " worker seconds" );
+    }
+
+    /********************************************************************
+    TakeTask
+        Waits for a camera to start or a ready camera and marks it running
+    Exceptions:
+        None
+    *********************************************************************/
+    CameraScheduler::CameraTask* CameraScheduler::TakeTask( )
+    {
+        boost::mutex::scoped_lock lock( m_mutex );
+
+        for ( ;; )
+        {
+            FeedTasks( );
+
+            if ( m_unfinishedTasks == 0 )
+            {
+                return NULL;
+            }
+
+            const int64 nowTicks    = cv::getTickCount();
+            int64       nextDue     = std::numeric_limits<int64>::max();
+            CameraTask* pReadyTask  = NULL;
+            CameraTask* pStartTask  = NULL;
+
+            for ( std::list<CameraTask>::iterator it = m_tasks.begin(); it != m_tasks.end(); ++it )
+            {
+                CameraTask& task = *it;
+                if ( task.m_running || task.m_finished )
+                {
+                    continue;
+                }
+
+                if ( !task.m_started )
+                {
+                    if ( pStartTask == NULL )
+                    {
+                        pStartTask = &task;
+                    }
+                    continue;
+                }
+
+                if ( task.m_dueTicks > nowTicks )
+                {
+                    task.m_capped = true;
+                    nextDue = std::min( nextDue, task.m_dueTicks );
+                    continue;
+                }
+
+                if ( pReadyTask == NULL || task.m_virtualTime < pReadyTask->m_virtualTime )
+                {
+                    pReadyTask = &task;
+                }
+            }
+
+            // start cameras without starving the started ones
+            if ( pStartTask != NULL && ( pReadyTask == NULL || m_startSeconds <= m_frameSeconds ) )
+            {
+                pStartTask->m_running = true;
+                return pStartTask;
+            }
+
+            if ( pReadyTask != NULL )
+            {
+                CameraTask& task = *pReadyTask;
+
+                // a capped camera does not bank the time it waited
+                if ( task.m_capped )
+                {
+                    task.m_virtualTime  = std::max( task.m_virtualTime, m_virtualClock );
+                    task.m_capped       = false;
+                }
+                m_virtualClock  = std::max( m_virtualClock, task.m_virtualTime );
+                task.m_running  = true;
+                return pReadyTask;
+            }
+
+            // wait for a running camera or the next capped one
+            if ( nextDue != std::numeric_limits<int64>::max() )
+            {
+                const double waitSeconds = ( nextDue - nowTicks ) / cv::getTickFrequency();
+                m_condition.timed_wait( lock, boost::posix_time::microseconds( (boost::int64_t)( waitSeconds * 1e6 ) + 1 ) );
+            }
+            else
+            {
+                m_condition.wait( lock );
+            }
+        }
+    }
+
+    /********************************************************************
+    ReleaseTask
+        Advances the virtual time of a camera by its frame time
+    Exceptions:
+        None
+    *********************************************************************/
+    void CameraScheduler::ReleaseTask( CameraTask&    task,
+                                       const int64    startTicks,
+                                       const bool     finished )
+    {
+        {
+            boost::mutex::scoped_lock lock( m_mutex );
+
+            const double busySeconds = ( cv::getTickCount() - startTicks ) / cv::getTickFrequency();
+
+            task.m_running       = false;
+            task.m_virtualTime  += busySeconds / task.m_weight;
+            task.m_busySeconds  += busySeconds;
+            m_frameSeconds      += busySeconds;
+
+            // a real-time camera handing back a frame early is due at its capture time
+            const int64 frameDueTicks = task.m_pCamera->GetFrameDueTicks();
+            task.m_dueTicks = frameDueTicks != 0 ? frameDueTicks : startTicks + task.m_minIntervalTicks;
+
+            if ( finished )
+            {
+                // stays running until FinishTask has dropped it
+                task.m_running  = true;
+                task.m_finished = true;
+            }
+            else if ( frameDueTicks == 0 )
+            {
+                task.m_frames++;
+            }
+        }
+        m_condition.notify_all();
+    }
+
+    /********************************************************************
+    FinishTask
+        Ends the processing of a finished camera on the worker, releases
+        the camera and drops the task, making room for the next camera
+        of the source
+    Exceptions:
+        None
+    *********************************************************************/
+    void CameraScheduler::FinishTask( CameraTask& task )
+    {
+        const double elapsedSeconds = ( cv::getTickCount() - m_runStartTicks ) / cv::getTickFrequency();
+
+        LOG_FILE( task.m_pCamera->GetOutputName() << ": weight " << task.m_weight << ", " << task.m_frames << " frames, " <<
+                  task.m_busySeconds << " s of " << elapsedSeconds * m_workerThreads << " worker seconds" );
+
+        task.m_pCamera->EndProcessing( );
+
+        {
+            boost::mutex::scoped_lock lock( m_mutex );
+
+            if ( m_pSource != NULL )
+            {
+                m_pSource->CameraFinished( task.m_pCamera );
+            }
+
+            for ( std::list<CameraTask>::iterator it = m_tasks.begin(); it != m_tasks.end(); ++it )
+            {
+                if ( &*it == &task )
+                {
+                    m_tasks.erase( it );
+                    break;
+                }
+            }
+            m_unfinishedTasks--;
+        }
+        m_condition.notify_all();
+    }
+
+    /********************************************************************
+    StartTask
+        Initializes a camera on the worker and begins its processing. It
+        joins at the current virtual time, so it does not take the workers
+        from the cameras started before it.
+    Exceptions:
+        None
+    *********************************************************************/
+    void CameraScheduler::StartTask( CameraTask& task )
+    {
+        const int64 startTicks  = cv::getTickCount();
+
+        if ( !task.m_pCamera->IsInitialized() )
+        {
+            task.m_pCamera->Initialize( );
+        }
+        task.m_pCamera->BeginProcessing( task.m_startFrameIndex, task.m_endFrameIndex );
+
+        {
+            boost::mutex::scoped_lock lock( m_mutex );
+
+            task.m_started       = true;
+            task.m_running       = false;
+            task.m_virtualTime   = m_virtualClock;
+            m_startSeconds      += ( cv::getTickCount() - startTicks ) / cv::getTickFrequency();
+            m_startedCameras++;
+        }
+        m_condition.notify_all();
+    }
+
+    /********************************************************************
+    WorkerLoop
+        Processes one frame of the next camera at a time until all
+        cameras are done
+    Exceptions:
+        None
+    *********************************************************************/
+    void CameraScheduler::WorkerLoop( )
+    {
+        CoreSet currentCores;
+
+        for ( ;; )
+        {
+            CameraTask* pTask = TakeTask( );
+            if ( pTask == NULL )
+            {
+                return;
+            }
+
+            // follow the camera to its cores
+            const CoreSet& cores = pTask->m_pCamera->GetCoreSet();
+            if ( cores != currentCores )
+            {
+                SetThreadAffinity( cores );
+                currentCores = cores;
+            }
+
+            if ( !pTask->m_started )
+            {
+                StartTask( *pTask );
+                continue;
+            }
+
+            const int64 startTicks = cv::getTickCount();
+            const bool  processed  = pTask->m_pCamera->ProcessNextFrame( );
+
+            ReleaseTask( *pTask, startTicks, !processed );
+
+            if ( !processed )
+            {
+                FinishTask( *pTask );
+            }
+        }
+    }
+
+    /********************************************************************
+    Constructor for class CameraInitializer
+    *********************************************************************/
+    CameraInitializer::CameraInitializer( const int threads )
+        : m_threads( threads > 0 ? threads : std::max( 1, (int)boost::thread::hardware_concurrency() ) ),
+        m_cameras( ),
+        m_nextCamera( 0 ),
+        m_waitIndex( 0 ),
+        m_initialized( )
+    {
+    }
+
+    /********************************************************************
+    Destructor for class CameraInitializer
+    *********************************************************************/
+    CameraInitializer::~CameraInitializer( )
+    {
+        try
+        {
+            {
+                boost::mutex::scoped_lock lock( m_mutex );
+                m_nextCamera = (unsigned int)m_cameras.size();
+            }
+            m_condition.notify_all();
+            m_initializers.join_all();
+        }
+        EXCEPTION_CATCH_AND_LOG( "Failed to stop the camera initializers" );
+    }
+
+    /********************************************************************
+    Start
+        Starts the initializer threads, no more than there are cameras
+    Exceptions:
+        None
+    *********************************************************************/
+    void CameraInitializer::Start( const std::vector<CameraPtr>& cameras )
+    {
+        m_cameras       = cameras;
+        m_nextCamera    = 0;
+        m_waitIndex     = 0;
+        m_initialized.assign( cameras.size(), false );
+
+        try
+        {
+            for ( int i = 0; i < std::min( m_threads, (int)cameras.size() ); i++ )
+            {
+                m_initializers.create_thread( boost::bind( &CameraInitializer::InitializerLoop, this ) );
+            }
+        }
+        EXCEPTION_CATCH_AND_ABORT( "Failed to start the camera initializers" );
+    }
+
+    /********************************************************************
+    WaitFor
+        Blocks until the camera at the index is initialized, and lets
+        the initializers open the cameras up to the thread count past it
+    Exceptions:
+        None
+    *********************************************************************/
+    void CameraInitializer::WaitFor( const unsigned int index )
+    {
+        ASSERT_TRUE( index < m_initialized.size() );
+
+        boost::mutex::scoped_lock lock( m_mutex );
+        if ( index > m_waitIndex )
+        {
+            m_waitIndex = index;
+            m_condition.notify_all();
+        }
+        while ( !m_initialized[index] )
+        {
+            m_condition.wait( lock );
+        }
+    }
+
+    /********************************************************************
+    InitializerLoop
+        Initializes the cameras in list order, so that the camera
+        processed first is ready first. No more than the thread count
+        of cameras are opened past the one being waited for, so the
+        open videos and models stay bounded on long camera lists
+    Exceptions:
+        None
+    *********************************************************************/
+    void CameraInitializer::InitializerLoop( )
+    {
+        for ( ;; )
+        {
+            unsigned int index;
+            {
+                boost::mutex::scoped_lock lock( m_mutex );
+                while ( m_nextCamera < m_cameras.size() &&
+                        m_nextCamera >= m_waitIndex + (unsigned int)m_threads )
+                {
+                    m_condition.wait( lock );
+                }
+                if ( m_nextCamera >= m_cameras.size() )
+                {
+                    return;
+                }
+                index = m_nextCamera++;
+            }
+
+            if ( !m_cameras[index]->IsInitialized() )
+            {
+                m_cameras[index]->Initialize( );
+            }
+
+            {
+                boost::mutex::scoped_lock lock( m_mutex );
+                m_initialized[index] = true;
+            }
+            m_condition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,181 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "Camera.h"
+
+#include <boost/thread.hpp>
+
+#include <list>
+#include <vector>
+
+namespace Tracker
+{
+    /*
+    *   Cameras fed to the scheduler while it runs, so that long job lists
+    *   are not materialised up front. Calls are made under the lock of
+    *   the scheduler, one at a time.
+    */
+    class CameraSource
+    {
+    public:
+    // Destructor
+    virtual ~CameraSource( ) {}
+
+    // The next camera with applied settings and its frame range, false
+    // when none is left
+    virtual bool NextCamera( CameraPtr&     pCamera,
+                             int&           startFrameIndex,
+                             int&           endFrameIndex ) = 0;
+
+    // A camera of the source has ended its processing
+    virtual void CameraFinished( const CameraPtr& pCamera ) {}
+    };
+
+    /*
+    *   Runs the frames of many cameras on a fixed number of worker
+    *   threads. Each frame of a camera is one work item; the frames of
+    *   a camera run in order, one at a time.
+    *
+    *   Workers share the processing time between the cameras in
+    *   proportion to their weights: every camera has a virtual time that
+    *   advances by the processing time of its frames divided by its
+    *   weight, and a free worker takes the ready camera with the lowest
+    *   virtual time, so a ready camera never falls more than one frame
+    *   behind its share. A camera held back by its frame rate cap rejoins
+    *   at the current virtual time instead of catching up in a burst.
+    *   Reading a live stream blocks its worker until the frame arrives.
+    *
+    *   Cameras are opened by the workers too, so that the first cameras
+    *   process frames while the others still start. Starting a camera
+    *   is a work item of its own: workers start the next camera while
+    *   the time spent starting cameras does not exceed the time spent
+    *   processing frames, or when no started camera is ready. Cameras
+    *   of a CameraSource are taken as the running ones finish, keeping
+    *   a bounded number active.
+    */
+    class CameraScheduler
+    {
+    public:
+    // Constructor
+    explicit CameraScheduler( const int workerThreads );
+
+    // Destructor
+    ~CameraScheduler( );
+
+    // Add a camera with applied settings, it is initialized on a worker
+    // unless it already is
+    void AddCamera( const CameraPtr&    pCamera,
+                    const int           startFrameIndex,
+                    const int           endFrameIndex );
+
+    // Take further cameras from the source while it runs, keeping at
+    // most maxActiveCameras cameras added and unfinished
+    void SetCameraSource( CameraSource*     pSource,
+                          const int         maxActiveCameras );
+
+    // Process all cameras to their end
+    void Run( );
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( CameraScheduler );
+
+    struct CameraTask
+    {
+        CameraPtr           m_pCamera;
+        int                 m_startFrameIndex;
+        int                 m_endFrameIndex;
+        bool                m_started;              // initialized and begun
+        double              m_weight;
+        int64               m_minIntervalTicks;     // from the frame rate cap, 0 for none
+        double              m_virtualTime;
+        int64               m_dueTicks;             // earliest start of the next frame
+        bool                m_capped;               // waited for m_dueTicks
+        bool                m_running;
+        bool                m_finished;
+        int                 m_frames;
+        double              m_busySeconds;
+    };
+
+    // Add a task of a camera, under the lock once running
+    void    AddTask( const CameraPtr&   pCamera,
+                     const int          startFrameIndex,
+                     const int          endFrameIndex );
+
+    // Add the cameras of the source up to the active limit, under the lock
+    void    FeedTasks( );
+
+    // Take the next camera to start, or the ready task with the lowest
+    // virtual time, NULL when all are done
+    CameraTask* TakeTask( );
+
+    // Initialize a camera and prepare it for processing
+    void    StartTask( CameraTask& task );
+
+    // Account the frame of a task and release it
+    void    ReleaseTask( CameraTask&    task,
+                         const int64    startTicks,
+                         const bool     finished );
+
+    // End the processing of a finished camera and drop its task
+    void    FinishTask( CameraTask& task );
+
+    // Process frames until all cameras are done
+    void    WorkerLoop( );
+
+    int                             m_workerThreads;
+    std::list<CameraTask>           m_tasks;                // the workers keep references into it
+    int                             m_unfinishedTasks;
+    CameraSource*                   m_pSource;
+    bool                            m_sourceExhausted;
+    int                             m_maxActiveCameras;
+    int                             m_startedCameras;
+    int64                           m_runStartTicks;
+    double                          m_virtualClock;
+    double                          m_startSeconds;         // spent starting cameras
+    double                          m_frameSeconds;         // spent processing frames
+
+    boost::mutex                    m_mutex;
+    boost::condition_variable       m_condition;
+    };
+
+    /*
+    *   Initializes cameras on background threads, in list order, so that
+    *   the first camera can be processed while the others still open
+    *   their videos. At most the thread count of cameras are opened
+    *   ahead of the one being waited for.
+    */
+    class CameraInitializer
+    {
+    public:
+    // Constructor, 0 threads for one per core
+    explicit CameraInitializer( const int threads );
+
+    // Destructor, waits for the started initializations
+    ~CameraInitializer( );
+
+    // Start initializing the cameras
+    void Start( const std::vector<CameraPtr>& cameras );
+
+    // Wait until the camera at the index is initialized
+    void WaitFor( const unsigned int index );
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( CameraInitializer );
+
+    // Initialize the next camera until none is left
+    void    InitializerLoop( );
+
+    int                             m_threads;
+    std::vector<CameraPtr>          m_cameras;
+    unsigned int                    m_nextCamera;
+    unsigned int                    m_waitIndex;            // camera the processing waits for
+    std::vector<bool>               m_initialized;
+
+    boost::mutex                    m_mutex;
+    boost::condition_variable       m_condition;
+    boost::thread_group             m_initializers;
+    };
+}
+#endif
@@ -0,0 +1,572 @@
+#include "Segments.h"
+#include "FrameCache.h"
+
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <set>
+#include <sstream>
+
+// intersection over union above which two boxes of an overlap frame show the same blob
+#define SEGMENT_MATCH_OVERLAP       0.5
+
+// overlap frames in which two tracks must coincide to be stitched
+#define SEGMENT_MATCH_FRAMES        3
+
+// compared frames per scan chunk at least, shorter videos get fewer chunks
+#define SCAN_MIN_CHUNK_SAMPLES      100
+
+// scan steps from which the scan seeks to the compared frames instead of
+// decoding all frames between them, about the keyframe interval of archives
+#define SCAN_SEEK_STEP              50
+
+namespace Tracker
+{
+    /********************************************************************
+    BoxOverlap
+        Intersection over union of the boxes of two records
+    Exceptions:
+        None
+    *********************************************************************/
+    static double BoxOverlap( const BlobRecord& first, const BlobRecord& second )
+    {
+        const cv::Rect firstBox     = GetRecordBox( first );
+        const cv::Rect secondBox    = GetRecordBox( second );
+
+        const double intersection = ( firstBox & secondBox ).area();
+        const double unionArea    = firstBox.area() + secondBox.area() - intersection;
+
+        return unionArea > 0 ? intersection / unionArea : 0.0;
+    }
+
+    /********************************************************************
+    Constructor for class SegmentedVideo
+    *********************************************************************/
+    SegmentedVideo::SegmentedVideo( const std::string&    sourceDirectoryStr,
+                                    const std::string&    videoFileNameStr )
+        : m_videoSourceDirectory( sourceDirectoryStr ),
+        m_videoFileName( videoFileNameStr ),
+        m_outputName( GetSourceOutputName( videoFileNameStr ) ),
+        m_videoOutputDirectory( ),
+        m_rawFrameFormat( ),
+        m_decoderSettings( ),
+        m_segmentParams( ),
+        m_frameCache( false ),
+        m_frameCacheDownScale( false ),
+        m_segments( )
+    {
+    }
+
+    /********************************************************************
+    Destructor for class SegmentedVideo
+    *********************************************************************/
+    SegmentedVideo::~SegmentedVideo( )
+    {
+        try
+        {
+            for ( unsigned int i = 0; i < m_segments.size(); i++ )
+            {
+                m_segments[i].m_pCamera.reset();
+
+                if ( m_segments[i].m_pFrameSource )
+                {
+                    m_segments[i].m_pFrameSource->Release();
+                }
+            }
+        }
+        EXCEPTION_CATCH_AND_LOG( "Failed to release the video segments" );
+    }
+
+    /*************************************************************************
+    OpenFrameSource
+        Open a frame source of the video. A cache is only used once it is
+        complete, since the segments cannot write it in frame order.
+    Exceptions
+        None
+    *************************************************************************/
+    FrameSourcePtr SegmentedVideo::OpenFrameSource( ) const
+    {
+        const std::string sourceFileName = m_videoSourceDirectory + '/' + m_videoFileName;
+        const std::string cacheFileName  = m_videoOutputDirectory + '/' + m_outputName + ".framecache";
+
+        if ( m_frameCache && IsFrameCacheValid( cacheFileName, sourceFileName, m_frameCacheDownScale ) )
+        {
+            return CreateCachedFrameSource( sourceFileName, cacheFileName, m_frameCacheDownScale, m_decoderSettings );
+        }
+
+        return CreateFrameSource( m_videoSourceDirectory, m_videoFileName, m_rawFrameFormat, m_decoderSettings );
+    }
+
+    /*************************************************************************
+    Initialize
+        Split the frames to process into segments. In the two-pass mode
+        the segments are the active intervals, each with the warm-up
+        frames before it.
+    Exceptions
+        None
+    *************************************************************************/
+    void SegmentedVideo::Initialize( const InputParameters&    params,
+                                     const int                 startFrameIndex,
+                                     const int                 endFrameIndex )
+    {
+        LOG_FILE( "Initialize segments of video " + m_videoSourceDirectory + '/' + m_videoFileName );
+
+        if ( IsStreamSource( m_videoFileName ) )
+        {
+            AbortError( __LINE__, __FILE__, "Segmented processing needs a video file" );
+        }
+
+        m_videoOutputDirectory  = params.m_outputVideoDirectory;
+        m_frameCache            = params.m_frameCache == 1;
+        m_frameCacheDownScale   = params.m_frameCacheDownScale == 1 && params.m_downScaleImage == 1;
+
+        m_decoderSettings.m_ffmpeg      = MY_STRICMP( params.m_videoDecoder, "FFmpeg" ) == 0;
+        m_decoderSettings.m_threads     = params.m_decoderThreads;
+        m_decoderSettings.m_threadType  = params.m_decoderThreadType;
+        m_decoderSettings.m_downScale   = params.m_decoderDownScale == 1 && params.m_downScaleImage == 1;
+
+        m_segmentParams = params;
+        m_segmentParams.m_displayIntermediateResult = 0;
+
+        // the records of a segment are stitched after all segments ran
+        m_segmentParams.m_checkpointInterval        = 0;
+        m_segmentParams.m_resume                    = 0;
+
+        FrameSourcePtr pSource = OpenFrameSource( );
+        if ( !pSource->IsOpened() )
+        {
+            LOG_FILE( "Unable to open input video file " + m_videoSourceDirectory + '/' + m_videoFileName );
+            AbortError( __LINE__, __FILE__, "Unable to open input video file" );
+        }
+
+        const int frameCount = pSource->GetFrameCount();
+        pSource->Release();
+        if ( frameCount <= 0 )
+        {
+            AbortError( __LINE__, __FILE__, "Unable to get the frame count of the video" );
+        }
+
+        // frame 0 only initializes the modules, as in Camera::Process
+        const int start = std::max( 1, startFrameIndex );
+        const int end   = ( endFrameIndex > 0 ) ? std::min( endFrameIndex + 1, frameCount ) : frameCount;
+        ASSERT_TRUE( end > start );
+
+        if ( params.m_twoPass == 1 )
+        {
+            std::vector< std::pair<int,int> > intervals;
+            ScanActivity( params, start, end, intervals );
+
+            for ( unsigned int i = 0; i < intervals.size(); i++ )
+            {
+                AddSegment( std::max( 1, intervals[i].first - params.m_segmentWarmupFrames ), intervals[i].first, intervals[i].second );
+            }
+            return;
+        }
+
+        const int segmentCount = std::min( params.m_segmentCount, end - start );
+
+        for ( int i = 0; i < segmentCount; i++ )
+        {
+            const int segmentStart  = start + (int)( (double)( end - start ) * i / segmentCount );
+            const int segmentEnd    = start + (int)( (double)( end - start ) * ( i + 1 ) / segmentCount );
+
+            AddSegment( ( i == 0 ) ? segmentStart : std::max( 1, segmentStart - params.m_segmentWarmupFrames ), segmentStart, segmentEnd );
+        }
+    }
+
+    /*************************************************************************
+    AddSegment
+        Add a segment to process, named after its index
+    Exceptions
+        None
+    *************************************************************************/
+    void SegmentedVideo::AddSegment( const int warmupStart,
+                                     const int start,
+                                     const int end )
+    {
+        VideoSegment segment;
+        segment.m_warmupStart   = warmupStart;
+        segment.m_start         = start;
+        segment.m_end           = end;
+
+        std::ostringstream outputName;
+        outputName << m_outputName << "_seg" << m_segments.size();
+        segment.m_outputName = outputName.str();
+
+        m_segments.push_back( segment );
+    }
+
+    /*************************************************************************
+    ScanActivity
+        Scan the video for activity in parallel chunks, and merge the
+        active frames into intervals. Intervals closer than the warm-up
+        are merged, since the warm-up of the later one would cover the
+        gap anyway.
+    Exceptions
+        None
+    *************************************************************************/
+    void SegmentedVideo::ScanActivity( const InputParameters&                    params,
+                                       const int                                 start,
+                                       const int                                 end,
+                                       std::vector< std::pair<int,int> >&        intervals ) const
+    {
+        const int64 startTicks = cv::getTickCount();
+
+        ActivityGateSettings gateSettings;
+        gateSettings.m_pixelThreshold       = params.m_activityGateThreshold;
+        gateSettings.m_minChangedPercent    = params.m_activityGateMinChanged;
+        gateSettings.m_refreshInterval      = INT_MAX;
+
+        const int scanStep      = std::max( 1, params.m_twoPassScanStep );
+        const int chunkCount    = std::max( 1, std::min( (int)boost::thread::hardware_concurrency(),
+                                                         ( end - start ) / ( scanStep * SCAN_MIN_CHUNK_SAMPLES ) ) );
+
+        std::vector< std::vector<int> > chunkActiveFrames( chunkCount );
+
+        #pragma omp parallel for schedule( dynamic )
+        for ( int i = 0; i < chunkCount; i++ )
+        {
+            const int chunkStart    = start + (int)( (double)( end - start ) * i / chunkCount );
+            const int chunkEnd      = start + (int)( (double)( end - start ) * ( i + 1 ) / chunkCount );
+
+            ScanChunk( gateSettings, scanStep, chunkStart, chunkEnd, chunkActiveFrames[i] );
+        }
+
+        // the chunks are in frame order, and so are their active frames
+        for ( int i = 0; i < chunkCount; i++ )
+        {
+            const std::vector<int>& activeFrames = chunkActiveFrames[i];
+            for ( unsigned int j = 0; j < activeFrames.size(); j++ )
+            {
+                // the change happened since the previous compared frame
+                const int intervalStart = std::max( start, activeFrames[j] - scanStep );
+                const int intervalEnd   = std::min( end, activeFrames[j] + 1 + params.m_twoPassPostRoll );
+
+                if ( !intervals.empty() && intervalStart <= intervals.back().second + params.m_segmentWarmupFrames )
+                {
+                    intervals.back().second = std::max( intervals.back().second, intervalEnd );
+                }
+                else
+                {
+                    intervals.push_back( std::make_pair( intervalStart, intervalEnd ) );
+                }
+            }
+        }
+
+        int activeFrameCount = 0;
+        for ( unsigned int i = 0; i < intervals.size(); i++ )
+        {
+            activeFrameCount += intervals[i].second - intervals[i].first;
+        }
+
+        LOG_FILE( "Scanned " << end - start << " frames of " << m_videoFileName << " in " << chunkCount << " chunks in " <<
+            ( cv::getTickCount() - startTicks ) / cv::getTickFrequency() << " s: " << intervals.size() <<
+            " active intervals, " << activeFrameCount << " frames" );
+    }
+
+    /*************************************************************************
+    ScanChunk
+        Compare every scanStep-th frame of the chunk with the previous
+        compared frame. The frame a step before the chunk only primes the
+        gate, so that chunks do not start active. Grabbing a frame decodes
+        it, so short steps decode every frame of the chunk; from
+        SCAN_SEEK_STEP on the scan seeks to each compared frame, which
+        decodes from the keyframe before it.
+    Exceptions
+        None
+    *************************************************************************/
+    void SegmentedVideo::ScanChunk( const ActivityGateSettings&     gateSettings,
+                                    const int                       scanStep,
+                                    const int                       chunkStart,
+                                    const int                       chunkEnd,
+                                    std::vector<int>&               activeFrames ) const
+    {
+        FrameSourcePtr pSource = OpenFrameSource( );
+
+        const int primeFrame = std::max( 0, chunkStart - scanStep );
+        if ( !pSource->IsOpened() || !pSource->Seek( primeFrame ) )
+        {
+            LOG_FILE( "Unable to seek to the scan chunk at frame " << chunkStart );
+            AbortError( __LINE__, __FILE__, "Unable to seek to the scan chunk" );
+        }
+
+        ActivityGate gate( gateSettings );
+        cv::Mat frame;
+
+        const bool  seekFrames  = scanStep >= SCAN_SEEK_STEP;
+        int         position    = primeFrame;       // frame the next Grab delivers
+
+        for ( int frameNum = primeFrame; frameNum < chunkEnd; frameNum = ( frameNum < chunkStart ) ? chunkStart : frameNum + scanStep )
+        {
+            if ( seekFrames && position != frameNum )
+            {
+                if ( !pSource->Seek( frameNum ) )
+                {
+                    LOG_FILE( "Unable to seek to scanned frame " << frameNum );
+                    AbortError( __LINE__, __FILE__, "Unable to seek to a scanned frame" );
+                }
+                position = frameNum;
+            }
+
+            // skip to the compared frame
+            bool grabbed = true;
+            while ( position <= frameNum && ( grabbed = pSource->Grab() ) )
+            {
+                position++;
+            }
+            if ( !grabbed )
+            {
+                break;
+            }
+
+            pSource->Retrieve( frame );
+            if ( gate.IsActive( frame, true ) && frameNum >= chunkStart )
+            {
+                activeFrames.push_back( frameNum );
+            }
+        }
+
+        pSource->Release();
+    }
+
+    /*************************************************************************
+    ProcessSegment
+        Initialize a camera on the frame before the warm-up, process the
+        warm-up and the output window of the segment, and close the
+        camera and its record file
+    Exceptions
+        None
+    *************************************************************************/
+    void SegmentedVideo::ProcessSegment( VideoSegment& segment )
+    {
+        segment.m_pFrameSource = OpenFrameSource( );
+
+        // the frame before the warm-up initializes the modules
+        if ( !segment.m_pFrameSource->IsOpened() ||
+             !segment.m_pFrameSource->Seek( segment.m_warmupStart - 1 ) ||
+             !segment.m_pFrameSource->Grab() ||
+             !segment.m_pFrameSource->Retrieve( segment.m_frame ) )
+        {
+            LOG_FILE( "Unable to seek to the segment " + segment.m_outputName );
+            AbortError( __LINE__, __FILE__, "Unable to seek to the segment" );
+        }
+
+        segment.m_pCamera = CameraPtr( new Camera( m_videoSourceDirectory, m_videoFileName ) );
+        segment.m_pCamera->ApplySettings( m_segmentParams );
+        segment.m_pCamera->SetOutputName( segment.m_outputName );
+        segment.m_pCamera->Initialize( segment.m_frame,
+                                       segment.m_pFrameSource->GetScale(),
+                                       m_segmentParams.m_fgDetectionParams,
+                                       m_segmentParams.m_blobDetectionParams,
+                                       m_segmentParams.m_blobTrackerParams,
+                                       m_segmentParams.m_blobAnalysisParams,
+                                       m_segmentParams.m_blobPostProcessingParams );
+
+        for ( int frameNum = segment.m_warmupStart;
+              frameNum < segment.m_end && segment.m_pFrameSource->Grab();
+              frameNum++ )
+        {
+            segment.m_pFrameSource->Retrieve( segment.m_frame );
+            segment.m_pCamera->ProcessFrame( segment.m_frame, frameNum, segment.m_pFrameSource->GetTimestamp() );
+        }
+
+        // close the segment record file
+        segment.m_pCamera.reset();
+        segment.m_pFrameSource->Release();
+        segment.m_pFrameSource.reset();
+        segment.m_frame.release();
+    }
+
+    /*************************************************************************
+    Process
+        Process the segments in parallel, then stitch their records
+    Exceptions
+        None
+    *************************************************************************/
+    void SegmentedVideo::Process( )
+    {
+        LOG_CONSOLE( "Start processing " << m_segments.size() << " segments of " + m_videoFileName );
+
+        const int segmentCount = (int)m_segments.size();
+
+        #pragma omp parallel for schedule( dynamic )
+        for ( int i = 0; i < segmentCount; i++ )
+        {
+            ProcessSegment( m_segments[i] );
+        }
+
+        StitchRecords( );
+
+        LOG( "End of processing " + m_videoFileName );
+    }
+
+    /*************************************************************************
+    ReadRecords
+        Read the records of a segment record file
+    Exceptions
+        None
+    *************************************************************************/
+    void SegmentedVideo::ReadRecords( const std::string&        fileName,
+                                      std::vector<BlobRecord>&  records ) const
+    {
+        std::ifstream recordFile( fileName.c_str() );
+        if ( !recordFile.is_open() )
+        {
+            LOG_FILE( "Unable to open record file " + fileName );
+            AbortError( __LINE__, __FILE__, "Unable to open segment record file" );
+        }
+
+        BlobRecord record;
+        while ( recordFile >> record.m_frameNumber >> record.m_x >> record.m_y >>
+                record.m_width >> record.m_height >> record.m_id >> record.m_timestamp )
+        {
+            records.push_back( record );
+        }
+    }
+
+    /*************************************************************************
+    MatchTracks
+        Map the IDs of a segment to the global IDs of the previous segment.
+        Pairs of tracks are voted for in every overlap frame in which their
+        boxes coincide, and the pairs with the most votes are taken first.
+    Exceptions
+        None
+    *************************************************************************/
+    void SegmentedVideo::MatchTracks( const std::vector<BlobRecord>&    previousRecords,
+                                      const std::map<int,int>&          previousIds,
+                                      const std::vector<BlobRecord>&    records,
+                                      const int                         overlapStart,
+                                      const int                         overlapEnd,
+                                      std::map<int,int>&                ids ) const
+    {
+        std::multimap<int, const BlobRecord*> previousByFrame;
+        for ( unsigned int i = 0; i < previousRecords.size(); i++ )
+        {
+            const BlobRecord& record = previousRecords[i];
+            if ( record.m_frameNumber >= overlapStart &&
+                 record.m_frameNumber < overlapEnd &&
+                 previousIds.find( record.m_id ) != previousIds.end() )
+            {
+                previousByFrame.insert( std::make_pair( record.m_frameNumber, &record ) );
+            }
+        }
+
+        std::map< std::pair<int,int>, int > votes;
+        for ( unsigned int i = 0; i < records.size(); i++ )
+        {
+            const BlobRecord& record = records[i];
+            if ( record.m_frameNumber < overlapStart || record.m_frameNumber >= overlapEnd )
+            {
+                continue;
+            }
+
+            typedef std::multimap<int, const BlobRecord*>::const_iterator RecordIterator;
+            std::pair<RecordIterator, RecordIterator> range = previousByFrame.equal_range( record.m_frameNumber );
+            for ( RecordIterator it = range.first; it != range.second; ++it )
+            {
+                if ( BoxOverlap( record, *it->second ) >= SEGMENT_MATCH_OVERLAP )
+                {
+                    votes[ std::make_pair( record.m_id, it->second->m_id ) ]++;
+                }
+            }
+        }
+
+        std::vector< std::pair< int, std::pair<int,int> > > candidates;
+        for ( std::map< std::pair<int,int>, int >::const_iterator it = votes.begin(); it != votes.end(); ++it )
+        {
+            candidates.push_back( std::make_pair( it->second, it->first ) );
+        }
+        std::sort( candidates.rbegin(), candidates.rend() );
+
+        const int minimumVotes = std::min( SEGMENT_MATCH_FRAMES, std::max( 1, overlapEnd - overlapStart ) );
+
+        std::set<int> matchedPreviousIds;
+        for ( unsigned int i = 0; i < candidates.size() && candidates[i].first >= minimumVotes; i++ )
+        {
+            const int id            = candidates[i].second.first;
+            const int previousId    = candidates[i].second.second;
+
+            if ( ids.find( id ) == ids.end() &&
+                 matchedPreviousIds.find( previousId ) == matchedPreviousIds.end() )
+            {
+                ids[id] = previousIds.find( previousId )->second;
+                matchedPreviousIds.insert( previousId );
+            }
+        }
+    }
+
+    /*************************************************************************
+    StitchRecords
+        Merge the output windows of the segment records into one record
+        file. Tracks continued across a boundary keep the ID they had in
+        the previous segment, other tracks get new IDs.
+    Exceptions
+        None
+    *************************************************************************/
+    void SegmentedVideo::StitchRecords( )
+    {
+        const std::string recordFileName = m_videoOutputDirectory + "/" + m_outputName + "_record.txt";
+
+        RecordWriter recordWriter( recordFileName );
+        if ( !recordWriter.IsOpened() )
+        {
+            LOG_FILE( "Unable to open record file " + recordFileName );
+            AbortError( __LINE__, __FILE__, "Unable to open record file" );
+        }
+
+        std::vector<BlobRecord> previousRecords;
+        std::map<int,int>       previousIds;
+        int                     nextId = 0;
+
+        for ( unsigned int i = 0; i < m_segments.size(); i++ )
+        {
+            const VideoSegment& segment = m_segments[i];
+            const std::string segmentFileName = m_videoOutputDirectory + "/" + segment.m_outputName + "_record.txt";
+
+            std::vector<BlobRecord> records;
+            ReadRecords( segmentFileName, records );
+
+            std::map<int,int> ids;
+            if ( i > 0 )
+            {
+                MatchTracks( previousRecords, previousIds, records, segment.m_warmupStart, segment.m_start, ids );
+            }
+
+            const int stitchedTracks = (int)ids.size();
+
+            for ( unsigned int j = 0; j < records.size(); j++ )
+            {
+                const BlobRecord& record = records[j];
+                if ( record.m_frameNumber < segment.m_start || record.m_frameNumber >= segment.m_end )
+                {
+                    continue;
+                }
+
+                std::map<int,int>::iterator idIt = ids.find( record.m_id );
+                if ( idIt == ids.end() )
+                {
+                    idIt = ids.insert( std::make_pair( record.m_id, nextId++ ) ).first;
+                }
+
+                BlobRecord stitchedRecord = record;
+                stitchedRecord.m_id = idIt->second;
+                recordWriter.Write( stitchedRecord );
+            }
+
+            if ( i > 0 )
+            {
+                LOG_FILE( "Segment " << segment.m_outputName << ": " << stitchedTracks << " tracks continued" );
+            }
+
+            previousRecords.swap( records );
+            previousIds.swap( ids );
+
+            std::remove( segmentFileName.c_str() );
+            std::remove( GetRecordIndexName( segmentFileName ).c_str() );
+        }
+
+        recordWriter.Close();
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef SEGMENTS_H
+#define SEGMENTS_H
+
+#include "Camera.h"
+#include "FrameSource.h"
+#include "RecordIndex.h"
+#include "ActivityGate.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Tracker
+{
+    /*
+    *   One time segment of a video. Frames from warmupStart to start
+    *   only train the models and overlap the previous segment; frames
+    *   from start up to end form the output window of the segment. The
+    *   frame source and camera only exist while it is processed.
+    */
+    struct VideoSegment
+    {
+        int                 m_warmupStart;
+        int                 m_start;
+        int                 m_end;
+        std::string         m_outputName;
+        FrameSourcePtr      m_pFrameSource;
+        cv::Mat             m_frame;
+        CameraPtr           m_pCamera;
+    };
+
+    /*
+    *   Processes the time segments of one long video in parallel and
+    *   stitches their records into one record file. Tracks are matched
+    *   across a segment boundary by their overlap in the warm-up frames,
+    *   which both neighbouring segments have processed. In the two-pass
+    *   mode the segments are the active intervals found by a scan of
+    *   the video instead of equal splits.
+    */
+    class SegmentedVideo
+    {
+    public:
+    // Constructor
+    SegmentedVideo( const std::string&     sourceDirectoryStr,
+                    const std::string&     videoFileNameStr );
+
+    // Destructor
+    ~SegmentedVideo( );
+
+    // Split the video, or scan it for its active intervals in the
+    // two-pass mode, into the segments to process
+    void Initialize( const InputParameters&    params,
+                     const int                 startFrameIndex,
+                     const int                 endFrameIndex );
+
+    // Process the segments in parallel and stitch the records
+    void Process( );
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( SegmentedVideo );
+
+    // Open a frame source of the video
+    FrameSourcePtr OpenFrameSource( ) const;
+
+    // Add a segment to process
+    void AddSegment( const int warmupStart,
+                     const int start,
+                     const int end );
+
+    // Find the intervals with activity by scanning the video in parallel
+    void ScanActivity( const InputParameters&                    params,
+                       const int                                 start,
+                       const int                                 end,
+                       std::vector< std::pair<int,int> >&        intervals ) const;
+
+    // Find the frames with activity in one chunk of the video
+    void ScanChunk( const ActivityGateSettings&     gateSettings,
+                    const int                       scanStep,
+                    const int                       chunkStart,
+                    const int                       chunkEnd,
+                    std::vector<int>&               activeFrames ) const;
+
+    // Initialize the camera of a segment and process its frames
+    void ProcessSegment( VideoSegment& segment );
+
+    // Merge the segment records into one record file with global IDs
+    void StitchRecords( );
+
+    // Read the records of a segment
+    void ReadRecords( const std::string&        fileName,
+                      std::vector<BlobRecord>&  records ) const;
+
+    // Map the IDs of a segment to the global IDs of the previous segment
+    void MatchTracks( const std::vector<BlobRecord>&    previousRecords,
+                      const std::map<int,int>&          previousIds,
+                      const std::vector<BlobRecord>&    records,
+                      const int                         overlapStart,
+                      const int                         overlapEnd,
+                      std::map<int,int>&                ids ) const;
+
+    std::string                     m_videoSourceDirectory;
+    std::string                     m_videoFileName;
+    std::string                     m_outputName;
+    std::string                     m_videoOutputDirectory;
+    RawFrameFormat                  m_rawFrameFormat;
+    DecoderSettings                 m_decoderSettings;
+    InputParameters                 m_segmentParams;
+    bool                            m_frameCache;
+    bool                            m_frameCacheDownScale;
+    std::vector<VideoSegment>       m_segments;
+    };
+}
+#endif
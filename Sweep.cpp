@@ -0,0 +1,299 @@
+#include "Sweep.h"
+
+#include <sstream>
+#include <string.h>
+
+namespace Tracker
+{
+    /********************************************************************
+    Constructor for class ParameterSweep
+    *********************************************************************/
+    ParameterSweep::ParameterSweep( const std::string&    sourceDirectoryStr,
+                                    const std::string&    videoFileNameStr )
+        : m_videoSourceDirectory( sourceDirectoryStr ),
+        m_videoFileName( videoFileNameStr ),
+        m_pFrameSource( ),
+        m_frame( ),
+        m_variants( ),
+        m_cameraPtrList( )
+    {
+    }
+
+    /********************************************************************
+    Destructor for class ParameterSweep
+    *********************************************************************/
+    ParameterSweep::~ParameterSweep( )
+    {
+        try
+        {
+            // release the cameras before the frames they point to
+            m_cameraPtrList.clear();
+
+            if ( m_pFrameSource != NULL )
+            {
+                m_pFrameSource->Release();
+            }
+        }
+        EXCEPTION_CATCH_AND_LOG( "Failed to release the parameter sweep" );
+    }
+
+    /*************************************************************************
+    ExpandGroups
+        Expand the {a|b} groups of a line into one string per combination
+    Exceptions
+        None
+    *************************************************************************/
+    void ParameterSweep::ExpandGroups( const std::string&           line,
+                                       std::vector<std::string>&    expanded )
+    {
+        const size_t groupStart = line.find( '{' );
+        if ( groupStart == std::string::npos )
+        {
+            expanded.push_back( line );
+            return;
+        }
+
+        const size_t groupEnd = line.find( '}', groupStart );
+        if ( groupEnd == std::string::npos )
+        {
+            LOG_FILE( "Unterminated { in sweep line " + line );
+            AbortError( __LINE__, __FILE__, "Unterminated { in sweep file" );
+        }
+
+        const std::string   prefix  = line.substr( 0, groupStart );
+        const std::string   suffix  = line.substr( groupEnd + 1 );
+        std::string         choices = line.substr( groupStart + 1, groupEnd - groupStart - 1 );
+
+        size_t choiceStart = 0;
+        for ( ;; )
+        {
+            const size_t choiceEnd = choices.find( '|', choiceStart );
+            ExpandGroups( prefix + choices.substr( choiceStart, choiceEnd - choiceStart ) + suffix, expanded );
+
+            if ( choiceEnd == std::string::npos )
+            {
+                break;
+            }
+            choiceStart = choiceEnd + 1;
+        }
+    }
+
+    /*************************************************************************
+    KeepInputSettings
+        All variants share the frames of one source, which the base
+        configuration opens and scales. A variant with other input settings
+        would scale its records for frames it does not get, so they are
+        reset to the base ones with a warning.
+    Exceptions
+        None
+    *************************************************************************/
+    void ParameterSweep::KeepInputSettings( const InputParameters&  baseParams,
+                                            SweepVariant&           variant )
+    {
+        InputParameters& params = variant.m_params;
+
+        if ( params.m_downScaleImage != baseParams.m_downScaleImage ||
+             params.m_frameCache != baseParams.m_frameCache ||
+             params.m_frameCacheDownScale != baseParams.m_frameCacheDownScale ||
+             params.m_decoderDownScale != baseParams.m_decoderDownScale ||
+             params.m_rawFrameWidth != baseParams.m_rawFrameWidth ||
+             params.m_rawFrameHeight != baseParams.m_rawFrameHeight ||
+             strcmp( params.m_rawFrameFormat, baseParams.m_rawFrameFormat ) != 0 )
+        {
+            LOG_WARNING( "Sweep variant " << variant.m_name << " keeps the input settings of the config file" );
+
+            params.m_downScaleImage         = baseParams.m_downScaleImage;
+            params.m_frameCache             = baseParams.m_frameCache;
+            params.m_frameCacheDownScale    = baseParams.m_frameCacheDownScale;
+            params.m_decoderDownScale       = baseParams.m_decoderDownScale;
+            params.m_rawFrameWidth          = baseParams.m_rawFrameWidth;
+            params.m_rawFrameHeight         = baseParams.m_rawFrameHeight;
+            strcpy( params.m_rawFrameFormat, baseParams.m_rawFrameFormat );
+        }
+    }
+
+    /*************************************************************************
+    ReadVariants
+        Read the variants listed in the sweep file
+    Exceptions
+        None
+    *************************************************************************/
+    void ParameterSweep::ReadVariants( const InputParameters&  baseParams,
+                                       const std::string&      sweepFileName )
+    {
+        std::ifstream sweepFile( sweepFileName.c_str() );
+        if ( !sweepFile.is_open() )
+        {
+            LOG_FILE( "Unable to open sweep file " + sweepFileName );
+            AbortError( __LINE__, __FILE__, "Unable to open sweep file" );
+        }
+
+        std::string line;
+        while ( std::getline( sweepFile, line ) )
+        {
+            // skip comments and blank lines
+            const size_t nameStart = line.find_first_not_of( " \t\r" );
+            if ( nameStart == std::string::npos || line[nameStart] == '#' )
+            {
+                continue;
+            }
+
+            const size_t nameEnd = line.find_first_of( " \t\r", nameStart );
+            const std::string name = line.substr( nameStart, nameEnd - nameStart );
+            const std::string settings = ( nameEnd == std::string::npos ) ? std::string() : line.substr( nameEnd );
+
+            std::vector<std::string> expandedSettings;
+            ExpandGroups( settings, expandedSettings );
+
+            for ( unsigned int i = 0; i < expandedSettings.size(); i++ )
+            {
+                SweepVariant variant;
+                variant.m_params = baseParams;
+
+                if ( expandedSettings.size() == 1 )
+                {
+                    variant.m_name = name;
+                }
+                else
+                {
+                    std::ostringstream variantName;
+                    variantName << name << '_' << i;
+                    variant.m_name = variantName.str();
+                }
+
+                if ( ParseConfigOverride( expandedSettings[i].c_str(), &variant.m_params ) != 0 )
+                {
+                    LOG_FILE( "Invalid settings for sweep variant " + variant.m_name );
+                    AbortError( __LINE__, __FILE__, "Invalid settings in sweep file" );
+                }
+
+                KeepInputSettings( baseParams, variant );
+                m_variants.push_back( variant );
+            }
+        }
+
+        if ( m_variants.empty() )
+        {
+            AbortError( __LINE__, __FILE__, "No variants in sweep file" );
+        }
+    }
+
+    /*************************************************************************
+    Initialize
+        Open the video once and initialize one camera per variant on its
+        first frame. Only the base configuration decides how the video is
+        read, the variants keep its input settings.
+    Exceptions
+        None
+    *************************************************************************/
+    void ParameterSweep::Initialize( const InputParameters&    baseParams,
+                                     const std::string&        sweepFileName )
+    {
+        LOG_FILE( "Initialize sweep " + sweepFileName + " on video " + m_videoSourceDirectory + '/' + m_videoFileName );
+
+        ReadVariants( baseParams, sweepFileName );
+
+        RawFrameFormat rawFrameFormat;
+        rawFrameFormat.m_width  = baseParams.m_rawFrameWidth;
+        rawFrameFormat.m_height = baseParams.m_rawFrameHeight;
+        if ( baseParams.m_rawFrameFormat[0] != '\0' )
+        {
+            rawFrameFormat.m_format = baseParams.m_rawFrameFormat;
+        }
+
+        DecoderSettings decoderSettings;
+        decoderSettings.m_ffmpeg        = MY_STRICMP( baseParams.m_videoDecoder, "FFmpeg" ) == 0;
+        decoderSettings.m_threads       = baseParams.m_decoderThreads;
+        decoderSettings.m_threadType    = baseParams.m_decoderThreadType;
+        decoderSettings.m_downScale     = baseParams.m_decoderDownScale == 1 && baseParams.m_downScaleImage == 1;
+
+        const std::string outputName = GetSourceOutputName( m_videoFileName );
+
+        // open input video or stream
+        if ( baseParams.m_frameCache == 1 && !IsStreamSource( m_videoFileName ) )
+        {
+            m_pFrameSource = CreateCachedFrameSource( m_videoSourceDirectory + '/' + m_videoFileName,
+                                                      std::string( baseParams.m_outputVideoDirectory ) + '/' + outputName + ".framecache",
+                                                      baseParams.m_frameCacheDownScale == 1 && baseParams.m_downScaleImage == 1,
+                                                      decoderSettings );
+        }
+        else
+        {
+            m_pFrameSource = CreateFrameSource( m_videoSourceDirectory, m_videoFileName, rawFrameFormat, decoderSettings );
+        }
+        if ( !m_pFrameSource->IsOpened() )
+        {
+            LOG_FILE( "Unable to open input video file " + m_videoSourceDirectory + '/' + m_videoFileName );
+            AbortError( __LINE__, __FILE__, "Unable to open input video file" );
+        }
+
+        // read first frame and discard it
+        if ( !m_pFrameSource->Grab() || !m_pFrameSource->Retrieve( m_frame ) )
+        {
+            AbortError( __LINE__, __FILE__, "Unable to read the first frame" );
+        }
+
+        for ( unsigned int i = 0; i < m_variants.size(); i++ )
+        {
+            InputParameters& params = m_variants[i].m_params;
+
+            // overlays would be drawn into the shared frame
+            params.m_displayIntermediateResult  = 0;
+            params.m_saveIntermediateResult     = 0;
+
+            CameraPtr pCamera( new Camera( m_videoSourceDirectory, m_videoFileName ) );
+            pCamera->ApplySettings( params );
+            pCamera->SetOutputName( outputName + "_" + m_variants[i].m_name );
+            pCamera->Initialize( m_frame,
+                                 m_pFrameSource->GetScale(),
+                                 params.m_fgDetectionParams,
+                                 params.m_blobDetectionParams,
+                                 params.m_blobTrackerParams,
+                                 params.m_blobAnalysisParams,
+                                 params.m_blobPostProcessingParams );
+
+            m_cameraPtrList.push_back( pCamera );
+        }
+
+        LOG_CONSOLE( "Sweeping " << m_variants.size() << " variants" );
+    }
+
+    /*************************************************************************
+    Process
+        Decode each frame once and process it with all variants in parallel
+    Exceptions
+        None
+    *************************************************************************/
+    void ParameterSweep::Process( const int startFrameIndex, const int endFrameIndex )
+    {
+        ASSERT_TRUE( !m_cameraPtrList.empty() );
+
+        LOG_CONSOLE( "Start sweep of " + m_videoFileName );
+
+        const int numberOfCameras = (int)m_cameraPtrList.size();
+
+        int frameNum;
+        for ( frameNum = 1;
+              m_pFrameSource->Grab() &&
+              ( frameNum <= endFrameIndex || endFrameIndex < 0 );
+              frameNum++ )
+        {
+            if ( frameNum >= startFrameIndex )
+            {
+                std::cout << "frameNum:  " << frameNum << '\r';
+
+                m_pFrameSource->Retrieve( m_frame );
+                const double timestamp = m_pFrameSource->GetTimestamp();
+
+                // the variants only read the shared frame
+                #pragma omp parallel for schedule( dynamic )
+                for ( int i = 0; i < numberOfCameras; i++ )
+                {
+                    m_cameraPtrList[i]->ProcessFrame( m_frame, frameNum, timestamp );
+                }
+            }
+        }
+
+        LOG( "End of sweep of " + m_videoFileName );
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "Camera.h"
+#include "FrameSource.h"
+
+#include <string>
+#include <vector>
+
+namespace Tracker
+{
+    /*
+    *   One parameter set of a sweep.
+    */
+    struct SweepVariant
+    {
+        std::string         m_name;
+        InputParameters     m_params;
+    };
+
+    /*
+    *   Runs several parameter variants over one video. Every frame is
+    *   decoded once and handed read-only to one tracker per variant;
+    *   the trackers run in parallel and write their own record files.
+    *
+    *   Each line of the sweep file is a variant name followed by config
+    *   settings, e.g.
+    *       cc      Blob_Tracker_Module = "CC"
+    *       alpha   FG_Detection_Params = "{fg:alpha1=0.1|fg:alpha1=0.2}"
+    *   A {a|b|...} group expands the line into one variant per choice,
+    *   named <name>_<index> in the order of the expansion.
+    */
+    class ParameterSweep
+    {
+    public:
+    // Constructor
+    ParameterSweep( const std::string&     sourceDirectoryStr,
+                    const std::string&     videoFileNameStr );
+
+    // Destructor
+    ~ParameterSweep( );
+
+    // Read the variants and initialize one camera per variant
+    void Initialize( const InputParameters&    baseParams,
+                     const std::string&        sweepFileName );
+
+    // Decode the video once and process every frame with all variants
+    void Process( const int startFrameIndex,
+                  const int endFrameIndex );
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( ParameterSweep );
+
+    // Read the variants listed in the sweep file
+    void ReadVariants( const InputParameters&  baseParams,
+                       const std::string&      sweepFileName );
+
+    // Expand the {a|b} groups of a line into settings strings
+    static void ExpandGroups( const std::string&        line,
+                              std::vector<std::string>& expanded );
+
+    // Reset the input settings a variant changed to the base ones
+    static void KeepInputSettings( const InputParameters&  baseParams,
+                                   SweepVariant&           variant );
+
+    std::string                     m_videoSourceDirectory;
+    std::string                     m_videoFileName;
+    FrameSourcePtr                  m_pFrameSource;
+    cv::Mat                         m_frame;
+    std::vector<SweepVariant>       m_variants;
+    std::vector<CameraPtr>          m_cameraPtrList;
+    };
+}
+#endif
@@ -0,0 +1,424 @@
+#include "TrackingEngine.h"
+#include "BackgroundSubtractorFG.h"
+
+// mean mask value inside a blob below which the blob has no foreground
+#define BLOB_FOREGROUND_THRESHOLD   ( 0.1 * 255 )
+
+// frames without foreground after which a blob is deleted
+#define BLOB_MAX_BAD_FRAMES         3
+
+// blobs this narrow are too small to check for foreground
+#define BLOB_MIN_CHECK_SIZE         4
+
+namespace Tracker
+{
+    /********************************************************************
+    LegacyTrackingEngine
+        Creates the auto tracker on the modules
+    Exceptions:
+        None
+    *********************************************************************/
+    LegacyTrackingEngine::LegacyTrackingEngine( const TrackingModules& modules )
+        : m_params( ),
+        m_pTracker( NULL ),
+        m_fgMask( )
+    {
+        m_params.FGTrainFrames  = modules.m_fgTrainFrames;
+        m_params.pBD            = modules.m_pBlobDetector;
+        m_params.pBT            = modules.m_pBlobTracker;
+        m_params.pBTA           = modules.m_pBlobTrackAnalysis;
+        m_params.pBTPP          = modules.m_pBlobProcessing;
+        m_params.pFG            = modules.m_pFGDetector;
+        m_params.UsePPData      = false;
+
+        m_pTracker = cvCreateBlobTrackerAuto1( &m_params );
+
+        ASSERT_TRUE( m_pTracker != NULL );
+    }
+
+    /********************************************************************
+    Default Destructor for class LegacyTrackingEngine
+    *********************************************************************/
+    LegacyTrackingEngine::~LegacyTrackingEngine( )
+    {
+        if ( m_pTracker != NULL )
+        {
+            cvReleaseBlobTrackerAuto( &m_pTracker );
+        }
+    }
+
+    /********************************************************************
+    Process
+        Runs the auto tracker on a header of the frame
+    Exceptions:
+        None
+    *********************************************************************/
+    void LegacyTrackingEngine::Process( const cv::Mat& frame )
+    {
+        IplImage frameIpl = frame;
+        m_pTracker->Process( &frameIpl, NULL );
+
+        IplImage* pMask = m_pTracker->GetFGMask();
+        m_fgMask = ( pMask != NULL ) ? cv::Mat( pMask ) : cv::Mat();
+    }
+
+    /********************************************************************
+    SubtractorFGStage
+        Calls the subtractor detectors without going through the vtable;
+        the engine is only chosen for detectors the stage accepts
+    Exceptions:
+        None
+    *********************************************************************/
+    bool SubtractorFGStage::Accepts( CvFGDetector* pDetector )
+    {
+        return dynamic_cast<BackgroundSubtractorFGDetector*>( pDetector ) != NULL;
+    }
+
+    void SubtractorFGStage::Process( CvFGDetector* pDetector, IplImage* pFrame )
+    {
+        static_cast<BackgroundSubtractorFGDetector*>( pDetector )->BackgroundSubtractorFGDetector::Process( pFrame );
+    }
+
+    IplImage* SubtractorFGStage::GetMask( CvFGDetector* pDetector )
+    {
+        return static_cast<BackgroundSubtractorFGDetector*>( pDetector )->BackgroundSubtractorFGDetector::GetMask( );
+    }
+
+    /********************************************************************
+    NativeTrackingEngine
+        Keeps the modules, the blob lists are empty until the first frame
+    Exceptions:
+        None
+    *********************************************************************/
+    template <class FGStage, class PostProcessingStage, class AnalysisStage>
+    NativeTrackingEngine<FGStage, PostProcessingStage, AnalysisStage>::NativeTrackingEngine( const TrackingModules& modules )
+        : m_modules( modules ),
+        m_blobs( sizeof(TrackedBlob) ),
+        m_newBlobs( ),
+        m_fgMask( ),
+        m_frameCount( 0 ),
+        m_nextBlobId( 0 )
+    {
+        ASSERT_TRUE( m_modules.m_pFGDetector != NULL );
+        ASSERT_TRUE( m_modules.m_pBlobDetector != NULL );
+        ASSERT_TRUE( m_modules.m_pBlobTracker != NULL );
+
+        // a fixed stage must match the module it was chosen for
+        ASSERT_TRUE( FGStage::Accepts( m_modules.m_pFGDetector ) );
+        ASSERT_TRUE( PostProcessingStage::IsPresent( m_modules.m_pBlobProcessing ) == ( m_modules.m_pBlobProcessing != NULL ) );
+        ASSERT_TRUE( AnalysisStage::IsPresent( m_modules.m_pBlobTrackAnalysis ) == ( m_modules.m_pBlobTrackAnalysis != NULL ) );
+    }
+
+    /********************************************************************
+    Default Destructor for class NativeTrackingEngine
+    *********************************************************************/
+    template <class FGStage, class PostProcessingStage, class AnalysisStage>
+    NativeTrackingEngine<FGStage, PostProcessingStage, AnalysisStage>::~NativeTrackingEngine( )
+    {
+    }
+
+    /********************************************************************
+    Process
+        Runs the stages of the auto tracker in its order: foreground,
+        tracking, post processing, deletion of lost blobs, tracker update,
+        detection of new blobs and trajectory analysis
+    Exceptions:
+        None
+    *********************************************************************/
+    template <class FGStage, class PostProcessingStage, class AnalysisStage>
+    void NativeTrackingEngine<FGStage, PostProcessingStage, AnalysisStage>::Process( const cv::Mat& frame )
+    {
+        m_frameCount++;
+
+        IplImage frameIpl = frame;
+
+        FGStage::Process( m_modules.m_pFGDetector, &frameIpl );
+
+        IplImage* pMask = FGStage::GetMask( m_modules.m_pFGDetector );
+        m_fgMask = ( pMask != NULL ) ? cv::Mat( pMask ) : cv::Mat();
+
+        UpdateBlobs( &frameIpl, pMask );
+
+        if ( PostProcessingStage::IsPresent( m_modules.m_pBlobProcessing ) )
+        {
+            PostProcessBlobs( );
+        }
+
+        if ( pMask != NULL )
+        {
+            DeleteLostBlobs( );
+        }
+
+        m_modules.m_pBlobTracker->Update( &frameIpl, pMask );
+
+        if ( pMask != NULL && m_frameCount > m_modules.m_fgTrainFrames )
+        {
+            DetectNewBlobs( &frameIpl, pMask );
+        }
+
+        if ( AnalysisStage::IsPresent( m_modules.m_pBlobTrackAnalysis ) )
+        {
+            for ( int i = m_blobs.GetBlobNum(); i > 0; i-- )
+            {
+                m_modules.m_pBlobTrackAnalysis->AddBlob( m_blobs.GetBlob( i-1 ) );
+            }
+            m_modules.m_pBlobTrackAnalysis->Process( &frameIpl, pMask );
+        }
+    }
+
+    /********************************************************************
+    GetState
+        State of the blob from the trajectory analysis, 0 without one
+    Exceptions:
+        None
+    *********************************************************************/
+    template <class FGStage, class PostProcessingStage, class AnalysisStage>
+    float NativeTrackingEngine<FGStage, PostProcessingStage, AnalysisStage>::GetState( const int blobId )
+    {
+        return AnalysisStage::IsPresent( m_modules.m_pBlobTrackAnalysis ) ? m_modules.m_pBlobTrackAnalysis->GetState( blobId ) : 0;
+    }
+
+    /********************************************************************
+    UpdateBlobs
+        Tracks the blobs into the frame and copies the results into the
+        blob list
+    Exceptions:
+        None
+    *********************************************************************/
+    template <class FGStage, class PostProcessingStage, class AnalysisStage>
+    void NativeTrackingEngine<FGStage, PostProcessingStage, AnalysisStage>::UpdateBlobs( IplImage* pFrame, IplImage* pMask )
+    {
+        CvBlobTracker* pTracker = m_modules.m_pBlobTracker;
+
+        pTracker->Process( pFrame, pMask );
+
+        for ( int i = m_blobs.GetBlobNum(); i > 0; i-- )
+        {
+            CvBlob* pBlob = m_blobs.GetBlob( i-1 );
+
+            const int blobId = CV_BLOB_ID( pBlob );
+            pTracker->ProcessBlob( pTracker->GetBlobIndexByID( blobId ), pBlob, pFrame, pMask );
+            pBlob->ID = blobId;
+        }
+    }
+
+    /********************************************************************
+    PostProcessBlobs
+        Replaces the tracked blobs with their smoothed versions; the
+        tracker keeps its own estimates
+    Exceptions:
+        None
+    *********************************************************************/
+    template <class FGStage, class PostProcessingStage, class AnalysisStage>
+    void NativeTrackingEngine<FGStage, PostProcessingStage, AnalysisStage>::PostProcessBlobs( )
+    {
+        CvBlobTrackPostProc* pPostProcessing = m_modules.m_pBlobProcessing;
+
+        for ( int i = m_blobs.GetBlobNum(); i > 0; i-- )
+        {
+            pPostProcessing->AddBlob( m_blobs.GetBlob( i-1 ) );
+        }
+        pPostProcessing->Process( );
+
+        for ( int i = m_blobs.GetBlobNum(); i > 0; i-- )
+        {
+            CvBlob* pBlob = m_blobs.GetBlob( i-1 );
+            CvBlob* pProcessedBlob = pPostProcessing->GetBlobByID( CV_BLOB_ID( pBlob ) );
+
+            if ( pProcessedBlob != NULL )
+            {
+                *pBlob = *pProcessedBlob;
+            }
+        }
+    }
+
+    /********************************************************************
+    DeleteLostBlobs
+        Counts the frames each blob has too little foreground under it
+        and deletes the blobs that have been lost for too long
+    Exceptions:
+        None
+    *********************************************************************/
+    template <class FGStage, class PostProcessingStage, class AnalysisStage>
+    void NativeTrackingEngine<FGStage, PostProcessingStage, AnalysisStage>::DeleteLostBlobs( )
+    {
+        const int width     = m_fgMask.cols;
+        const int height    = m_fgMask.rows;
+
+        for ( int i = m_blobs.GetBlobNum(); i > 0; i-- )
+        {
+            TrackedBlob* pBlob = (TrackedBlob*)m_blobs.GetBlob( i-1 );
+
+            // clip the blob to the mask, leaving a border as the auto tracker does
+            CvRect region = CV_BLOB_RECT( &pBlob->m_blob );
+            if ( region.x < 0 ) { region.width += region.x; region.x = 0; }
+            if ( region.y < 0 ) { region.height += region.y; region.y = 0; }
+            if ( region.x + region.width >= width ) { region.width = width - region.x - 1; }
+            if ( region.y + region.height >= height ) { region.height = height - region.y - 1; }
+
+            const double area = CV_BLOB_WX( &pBlob->m_blob ) * CV_BLOB_WY( &pBlob->m_blob );
+
+            bool good = false;
+            if ( region.width > BLOB_MIN_CHECK_SIZE && region.height > BLOB_MIN_CHECK_SIZE &&
+                 region.x < width && region.y < height && area > 0 )
+            {
+                const cv::Mat blobMask( m_fgMask, cv::Rect( region.x, region.y, region.width, region.height ) );
+                good = cv::sum( blobMask )[0] / area > BLOB_FOREGROUND_THRESHOLD;
+            }
+            else
+            {
+                pBlob->m_badFrames += 2;
+            }
+
+            pBlob->m_badFrames = good ? 0 : pBlob->m_badFrames + 1;
+        }
+
+        for ( int i = m_blobs.GetBlobNum(); i > 0; i-- )
+        {
+            const TrackedBlob* pBlob = (const TrackedBlob*)m_blobs.GetBlob( i-1 );
+
+            if ( pBlob->m_badFrames > BLOB_MAX_BAD_FRAMES )
+            {
+                const int blobId = CV_BLOB_ID( &pBlob->m_blob );
+                m_modules.m_pBlobTracker->DelBlobByID( blobId );
+                m_blobs.DelBlobByID( blobId );
+            }
+        }
+    }
+
+    /********************************************************************
+    DetectNewBlobs
+        Adds the blobs found by the detector to the tracker and the list
+    Exceptions:
+        None
+    *********************************************************************/
+    template <class FGStage, class PostProcessingStage, class AnalysisStage>
+    void NativeTrackingEngine<FGStage, PostProcessingStage, AnalysisStage>::DetectNewBlobs( IplImage* pFrame, IplImage* pMask )
+    {
+        m_newBlobs.Clear( );
+
+        if ( !m_modules.m_pBlobDetector->DetectNewBlob( pFrame, pMask, &m_newBlobs, &m_blobs ) )
+        {
+            return;
+        }
+
+        for ( int i = 0; i < m_newBlobs.GetBlobNum(); i++ )
+        {
+            CvBlob* pNewBlob = m_newBlobs.GetBlob( i );
+
+            if ( pNewBlob == NULL || pNewBlob->w < CV_BLOB_MINW || pNewBlob->h < CV_BLOB_MINH )
+            {
+                continue;
+            }
+
+            pNewBlob->ID = m_nextBlobId;
+
+            CvBlob* pTrackedBlob = m_modules.m_pBlobTracker->AddBlob( pNewBlob, pFrame, pMask );
+            if ( pTrackedBlob != NULL )
+            {
+                TrackedBlob blob;
+                blob.m_blob         = *pTrackedBlob;
+                blob.m_badFrames    = 0;
+                m_blobs.AddBlob( &blob.m_blob );
+                m_nextBlobId++;
+            }
+        }
+    }
+
+    /********************************************************************
+    CreateEngine
+        Engine constructor for the table of specialised engines
+    Exceptions:
+        None
+    *********************************************************************/
+    template <class Engine>
+    static TrackingEngine* CreateEngine( const TrackingModules& modules )
+    {
+        return new Engine( modules );
+    }
+
+    /********************************************************************
+    AcceptsDetector
+        Check of the detector for the table of specialised engines
+    Exceptions:
+        None
+    *********************************************************************/
+    template <class FGStage>
+    static bool AcceptsDetector( CvFGDetector* pDetector )
+    {
+        return FGStage::Accepts( pDetector );
+    }
+
+    // engine instantiated for one combination of modules
+    struct SpecialisedEngine
+    {
+        const char*     m_fgDetectorName;
+        const char*     m_blobDetectorName;
+        const char*     m_blobTrackerName;
+        const char*     m_blobProcessingName;
+        const char*     m_blobTrackAnalysisName;
+        bool            (*m_accepts)( CvFGDetector* pDetector );
+        TrackingEngine* (*m_create)( const TrackingModules& modules );
+    };
+
+    // The common module combinations with a subtractor detector, which is
+    // called directly while absent stages are compiled out. The legacy
+    // detectors are internal to OpenCV and stay behind their interfaces,
+    // so they gain nothing over the dynamic engine and are not listed.
+    static const SpecialisedEngine g_specialisedEngines[] =
+    {
+        { "FG_MOG2",    "BD_CC",    "CC",       "Kalman",   "None",     AcceptsDetector<SubtractorFGStage>, CreateEngine< NativeTrackingEngine<SubtractorFGStage, PresentStage, AbsentStage> > },
+        { "FG_MOG2",    "BD_CC",    "CC",       "None",     "None",     AcceptsDetector<SubtractorFGStage>, CreateEngine< NativeTrackingEngine<SubtractorFGStage, AbsentStage, AbsentStage> > },
+        { "FG_MOG2",    "BD_CC",    "CCMSPF",   "Kalman",   "HistPVS",  AcceptsDetector<SubtractorFGStage>, CreateEngine< NativeTrackingEngine<SubtractorFGStage, PresentStage, PresentStage> > },
+        { NULL,         NULL,       NULL,       NULL,       NULL,       NULL,                               NULL }
+    };
+
+    /********************************************************************
+    CreateTrackingEngine
+        Creates the engine of the given name on the modules. Native takes
+        the engine specialised for the modules if there is one and the
+        dynamic engine otherwise.
+    Exceptions:
+        None
+    *********************************************************************/
+    TrackingEngine* CreateTrackingEngine( const std::string&        engineName,
+                                          const TrackingModules&    modules )
+    {
+        if ( engineName == "Legacy" )
+        {
+            LOG_FILE( "Tracking engine: Legacy" );
+            return new LegacyTrackingEngine( modules );
+        }
+
+        if ( engineName == "Native" )
+        {
+            for ( const SpecialisedEngine* pEngine = g_specialisedEngines; pEngine->m_create != NULL; ++pEngine )
+            {
+                if ( modules.m_fgDetectorName == pEngine->m_fgDetectorName &&
+                     modules.m_blobDetectorName == pEngine->m_blobDetectorName &&
+                     modules.m_blobTrackerName == pEngine->m_blobTrackerName &&
+                     modules.m_blobProcessingName == pEngine->m_blobProcessingName &&
+                     modules.m_blobTrackAnalysisName == pEngine->m_blobTrackAnalysisName )
+                {
+                    // a detector of another type runs through its interface
+                    if ( !(*pEngine->m_accepts)( modules.m_pFGDetector ) )
+                    {
+                        break;
+                    }
+
+                    LOG_FILE( "Tracking engine: Native, specialised for " << modules.m_fgDetectorName << "+" <<
+                        modules.m_blobDetectorName << "+" << modules.m_blobTrackerName << "+" <<
+                        modules.m_blobProcessingName << "+" << modules.m_blobTrackAnalysisName );
+                    return (*pEngine->m_create)( modules );
+                }
+            }
+        }
+        else
+        {
+            ASSERT_TRUE( engineName == "Dynamic" );
+        }
+
+        LOG_FILE( "Tracking engine: Native, dynamic" );
+        return new DynamicTrackingEngine( modules );
+    }
+}
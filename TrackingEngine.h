@@ -0,0 +1,201 @@
+#ifndef TRACKING_ENGINE_H
+#define TRACKING_ENGINE_H
+
+#include "OpenCvDefinitions.h"
+#include "CommonMacros.h"
+
+#include <string>
+
+namespace Tracker
+{
+    /*
+    *   Detection, tracking and analysis modules run by an engine. The
+    *   engine only borrows them; their owner releases them after the
+    *   engine is deleted. The analysis and post processing modules are
+    *   optional.
+    */
+    struct TrackingModules
+    {
+        TrackingModules( )
+            : m_pFGDetector( NULL ),
+            m_pBlobDetector( NULL ),
+            m_pBlobTracker( NULL ),
+            m_pBlobProcessing( NULL ),
+            m_pBlobTrackAnalysis( NULL ),
+            m_fgTrainFrames( 0 ),
+            m_fgDetectorName( ),
+            m_blobDetectorName( ),
+            m_blobTrackerName( ),
+            m_blobProcessingName( ),
+            m_blobTrackAnalysisName( )
+        {
+        }
+
+        CvFGDetector*               m_pFGDetector;
+        CvBlobDetector*             m_pBlobDetector;
+        CvBlobTracker*              m_pBlobTracker;
+        CvBlobTrackPostProc*        m_pBlobProcessing;
+        CvBlobTrackAnalysis*        m_pBlobTrackAnalysis;
+        int                         m_fgTrainFrames;        // frames before new blobs are detected
+
+        // module names of the tables, "None" for an absent module
+        std::string                 m_fgDetectorName;
+        std::string                 m_blobDetectorName;
+        std::string                 m_blobTrackerName;
+        std::string                 m_blobProcessingName;
+        std::string                 m_blobTrackAnalysisName;
+    };
+
+    /*
+    *   Runs the modules on each frame and keeps the tracked blobs. The
+    *   frame is only read during Process. The mask and the blobs stay
+    *   valid until the next Process; the mask must not be written to.
+    */
+    class TrackingEngine
+    {
+    public:
+    // Destructor
+    virtual ~TrackingEngine( ) {}
+
+    // Process the next frame
+    virtual void            Process( const cv::Mat& frame ) = 0;
+
+    // Foreground mask of the last frame, empty before the first one
+    virtual const cv::Mat&  GetFGMask( ) const = 0;
+
+    // Tracked blobs
+    virtual int             GetBlobNum( ) = 0;
+    virtual CvBlob*         GetBlob( const int index ) = 0;
+
+    // State of a blob from the trajectory analysis, 0 for normal
+    virtual float           GetState( const int blobId ) = 0;
+    };
+
+    /*
+    *   Runs the legacy CvBlobTrackerAuto1 on headers of the frames.
+    */
+    class LegacyTrackingEngine : public TrackingEngine
+    {
+    public:
+    // Constructor
+    explicit LegacyTrackingEngine( const TrackingModules& modules );
+
+    // Destructor
+    virtual ~LegacyTrackingEngine( );
+
+    virtual void            Process( const cv::Mat& frame );
+    virtual const cv::Mat&  GetFGMask( ) const          { return m_fgMask; }
+    virtual int             GetBlobNum( )               { return m_pTracker->GetBlobNum(); }
+    virtual CvBlob*         GetBlob( const int index )  { return m_pTracker->GetBlob( index ); }
+    virtual float           GetState( const int blobId ) { return m_pTracker->GetState( blobId ); }
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( LegacyTrackingEngine );
+
+    CvBlobTrackerAutoParam1         m_params;
+    CvBlobTrackerAuto*              m_pTracker;
+    cv::Mat                         m_fgMask;
+    };
+
+    /*
+    *   Stage policies of NativeTrackingEngine. The dynamic policies call
+    *   the modules through their interfaces and check at run time whether
+    *   an optional module is present. The others are fixed when the
+    *   engine is instantiated: a known module is called directly and an
+    *   absent stage is compiled out. Accepts tells whether a foreground
+    *   stage can run the detector, which a wrapper such as the motion
+    *   gate hides behind the name of the module.
+    */
+    struct DynamicFGStage
+    {
+        static bool         Accepts( CvFGDetector* )                                { return true; }
+        static void         Process( CvFGDetector* pDetector, IplImage* pFrame )    { pDetector->Process( pFrame ); }
+        static IplImage*    GetMask( CvFGDetector* pDetector )                      { return pDetector->GetMask(); }
+    };
+
+    struct SubtractorFGStage
+    {
+        static bool         Accepts( CvFGDetector* pDetector );
+        static void         Process( CvFGDetector* pDetector, IplImage* pFrame );
+        static IplImage*    GetMask( CvFGDetector* pDetector );
+    };
+
+    struct DynamicStage
+    {
+        static bool         IsPresent( const void* pModule )                        { return pModule != NULL; }
+    };
+
+    struct PresentStage
+    {
+        static bool         IsPresent( const void* )                                { return true; }
+    };
+
+    struct AbsentStage
+    {
+        static bool         IsPresent( const void* )                                { return false; }
+    };
+
+    /*
+    *   Runs the same stages as CvBlobTrackerAuto1 on cv::Mat frames. The
+    *   engine owns the blob lists and reads the mask of the detector in
+    *   place, the modules only see headers of the frame and mask, so no
+    *   image is allocated or copied per frame. The foreground, post
+    *   processing and analysis stages are set by the policies.
+    */
+    template <class FGStage, class PostProcessingStage, class AnalysisStage>
+    class NativeTrackingEngine : public TrackingEngine
+    {
+    public:
+    // Constructor
+    explicit NativeTrackingEngine( const TrackingModules& modules );
+
+    // Destructor
+    virtual ~NativeTrackingEngine( );
+
+    virtual void            Process( const cv::Mat& frame );
+    virtual const cv::Mat&  GetFGMask( ) const          { return m_fgMask; }
+    virtual int             GetBlobNum( )               { return m_blobs.GetBlobNum(); }
+    virtual CvBlob*         GetBlob( const int index )  { return m_blobs.GetBlob( index ); }
+    virtual float           GetState( const int blobId );
+
+    private:
+
+    DISALLOW_IMPLICIT_CONSTRUCTORS( NativeTrackingEngine );
+
+    // Tracked blob and its count of frames without foreground
+    struct TrackedBlob
+    {
+        CvBlob                      m_blob;
+        int                         m_badFrames;
+    };
+
+    // Copy the tracker results into the blob list
+    void    UpdateBlobs( IplImage* pFrame, IplImage* pMask );
+
+    // Smooth the blobs with the post processing module
+    void    PostProcessBlobs( );
+
+    // Drop the blobs that have lost their foreground
+    void    DeleteLostBlobs( );
+
+    // Start tracking the blobs found by the blob detector
+    void    DetectNewBlobs( IplImage* pFrame, IplImage* pMask );
+
+    TrackingModules                 m_modules;
+    CvBlobSeq                       m_blobs;
+    CvBlobSeq                       m_newBlobs;
+    cv::Mat                         m_fgMask;
+    int                             m_frameCount;
+    int                             m_nextBlobId;
+    };
+
+    // Engine calling every module through its interface
+    typedef NativeTrackingEngine<DynamicFGStage, DynamicStage, DynamicStage>   DynamicTrackingEngine;
+
+    // Create the engine of the given name: Native, Dynamic or Legacy.
+    // Native uses an engine specialised for the modules where one exists.
+    TrackingEngine* CreateTrackingEngine( const std::string&        engineName,
+                                          const TrackingModules&    modules );
+}
+#endif
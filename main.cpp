@@ -1,12 +1,47 @@
 #include "Config.h"
 #include "Camera.h"
+#include "Sweep.h"
+#include "Segments.h"
+#include "Profiles.h"
+#include "Scheduler.h"
+#include "Regression.h"
+#include "JobManifest.h"
+#include "Coordinator.h"
 
 //declare functions
 void InitializeInputOutputSettings( std::vector<Tracker::CameraPtr>& theVideoClipList );
+void RunParameterSweep( const int startFrameIndex, const int endFrameIndex );
+void RunSegmentedVideos( const int startFrameIndex, const int endFrameIndex );
+void RunJobManifest( const int startFrameIndex, const int endFrameIndex );
+int  RunRecordQuery( int argc, char* argv[] );
+int  RunRegressionSuite( int argc, char* argv[] );
+int  RunCoordinator( int argc, char* argv[], const int startFrameIndex, const int endFrameIndex );
+int  RunCoordinatorJob( int argc, char* argv[] );
+int  GetEndFrameIndex( );
 
 //main function
 int main( int argc, char* argv[] )
 {
+    // query a record file instead of tracking
+    if ( argc >= 3 && strcmp( argv[1], "-q" ) == 0 )
+    {
+        return RunRecordQuery( argc, argv );
+    }
+
+    // run the regression suite instead of tracking
+    if ( argc >= 3 && strcmp( argv[1], "-r" ) == 0 )
+    {
+        return RunRegressionSuite( argc, argv );
+    }
+
+    // run one job of a coordinator in this worker process
+    if ( argc >= 3 && strcmp( argv[1], "-j" ) == 0 )
+    {
+        return RunCoordinatorJob( argc, argv );
+    }
+
+    int exitCode = 0;
+
     try
     {
         // read configuration file
@@ -15,8 +50,50 @@ int main( int argc, char* argv[] )
 
         // create the log file
         std::string logFile( g_configInput.m_outputVideoDirectory );
-        g_logFile.open( ( logFile + "/" + g_configInput.m_logFileName ).c_str(),
-                       std::ios_base::out );
+        Tracker::Logger::Instance().Open( logFile + "/" + g_configInput.m_logFileName );
+        Tracker::Logger::Instance().SetLevel( g_configInput.m_logLevel );
+
+        const int endFrameIndex = GetEndFrameIndex( );
+
+        // hand the jobs to worker processes, so that a failing input only fails its job
+        if ( g_configInput.m_coordinatorWorkers > 0 )
+        {
+            exitCode = RunCoordinator( argc, argv, g_configInput.m_startFrameIndex, endFrameIndex );
+            Tracker::Logger::Instance().Close();
+            return exitCode;
+        }
+
+        // serve the live metrics
+        Tracker::Metrics::Instance().Start( g_configInput.m_metricsPort,
+                                            g_configInput.m_metricsFileName[0] != '\0' ? logFile + "/" + g_configInput.m_metricsFileName : "",
+                                            g_configInput.m_metricsIntervalMs );
+
+        // run the parameter variants of the sweep file instead of the cameras
+        if ( g_configInput.m_sweepFileName[0] != '\0' )
+        {
+            RunParameterSweep( g_configInput.m_startFrameIndex, endFrameIndex );
+            Tracker::Metrics::Instance().Stop();
+            Tracker::Logger::Instance().Close();
+            return 0;
+        }
+
+        // process time segments, or the active intervals, of each video in parallel
+        if ( g_configInput.m_segmentCount > 1 || g_configInput.m_twoPass == 1 )
+        {
+            RunSegmentedVideos( g_configInput.m_startFrameIndex, endFrameIndex );
+            Tracker::Metrics::Instance().Stop();
+            Tracker::Logger::Instance().Close();
+            return 0;
+        }
+
+        // process the jobs of the manifest as they are read
+        if ( g_configInput.m_jobManifest[0] != '\0' )
+        {
+            RunJobManifest( g_configInput.m_startFrameIndex, endFrameIndex );
+            Tracker::Metrics::Instance().Stop();
+            Tracker::Logger::Instance().Close();
+            return 0;
+        }
 
         // create and initialize the video list corresponding to each camera view
         std::vector<Tracker::CameraPtr> videoClipPtrList;
@@ -24,35 +101,62 @@ int main( int argc, char* argv[] )
         // initialize the video list with input configuration
         InitializeInputOutputSettings( videoClipPtrList );
 
-        // main processing 
-        for ( unsigned int i = 0; i < videoClipPtrList.size(); i++ )
+        // share the workers between all cameras
+        if ( g_configInput.m_schedulerThreads > 0 )
         {
-            ASSERT_TRUE( videoClipPtrList[i] != NULL );
-
-            int endFrameIndex;
-            if ( g_configInput.m_numberOfFramesToProcess > 0 )
+            Tracker::CameraScheduler scheduler( g_configInput.m_schedulerThreads );
+            for ( unsigned int i = 0; i < videoClipPtrList.size(); i++ )
             {
-                endFrameIndex = g_configInput.m_startFrameIndex + g_configInput.m_numberOfFramesToProcess;
+                ASSERT_TRUE( videoClipPtrList[i] != NULL );
+
+                // the workers open the cameras
+                scheduler.AddCamera( videoClipPtrList[i],
+                                     g_configInput.m_startFrameIndex,
+                                     endFrameIndex );
             }
-            else
+            scheduler.Run( );
+        }
+        else
+        {
+            // open the next cameras while the first ones are processed
+            Tracker::CameraInitializer initializer( 0 );
+            initializer.Start( videoClipPtrList );
+
+            // main processing 
+            for ( unsigned int i = 0; i < videoClipPtrList.size(); i++ )
             {
-                endFrameIndex = -1;
-            }
+                ASSERT_TRUE( videoClipPtrList[i] != NULL );
 
-            // Process Frames in individual camera views
-            videoClipPtrList[i]->Process( g_configInput.m_startFrameIndex,
-                                          endFrameIndex );
+                initializer.WaitFor( i );
+
+                // Process Frames in individual camera views
+                videoClipPtrList[i]->Process( g_configInput.m_startFrameIndex,
+                                              endFrameIndex );
+            }
         }
     }
     catch ( std::exception e)
     {
         LOG( e.what() );
+        exitCode = 1;
     }
 
-    // Close the log file
-    g_logFile.close();
+    // Write the final metrics and close the log file
+    Tracker::Metrics::Instance().Stop();
+    Tracker::Logger::Instance().Close();
 
-    return 0;
+    return exitCode;
+}
+
+// Last frame to process from the config, -1 for the end of the videos
+int GetEndFrameIndex( )
+{
+    if ( g_configInput.m_numberOfFramesToProcess > 0 )
+    {
+        return g_configInput.m_startFrameIndex + g_configInput.m_numberOfFramesToProcess;
+    }
+
+    return -1;
 }
 
 // Initializes the module using the input config file
@@ -80,37 +184,232 @@ void InitializeInputOutputSettings( std::vector<Tracker::CameraPtr>& cameraPtrLi
         pch = strtok( NULL, "," );        
     }
 
+    // read the pipeline profiles assigned to the cameras
+    Tracker::PipelineProfiles profiles( g_configInput );
+    profiles.Load( g_configInput.m_profileFileName, g_configInput.m_cameraProfiles );
+
     // set the values in each camera
     for( int i=0; i < numberOfVideos; i++ )
     {
-        cameraPtrList[i]->SetVideoOutputDirectory( g_configInput.m_outputVideoDirectory );
+        const int cameraId = cameraPtrList[i]->GetCameraId();
+        InputParameters settings = profiles.GetSettings( cameraId );
 
-        if( g_configInput.m_displayIntermediateResult == 1 )
+        // windows cannot be driven from the scheduler workers
+        if ( g_configInput.m_schedulerThreads > 0 )
         {
-            cameraPtrList[i]->EnableDisplayIntermediateResult();
+            settings.m_displayIntermediateResult = 0;
         }
 
-        if ( g_configInput.m_saveIntermediateResult == 1)
+        if ( !profiles.GetProfileName( cameraId ).empty() )
         {
-            cameraPtrList[i]->EnableSaveIntermediateResult( );
+            LOG_FILE( "Camera " << cameraId << " uses pipeline profile " << profiles.GetProfileName( cameraId ) );
         }
 
-        if ( g_configInput.m_downScaleImage == 1)
+        // the cameras are initialized when they start
+        cameraPtrList[i]->ApplySettings( settings );
+    }
+}
+
+// Runs the variants of the sweep file on each input video
+void RunParameterSweep( const int startFrameIndex, const int endFrameIndex )
+{
+    std::string inputVideoDirectory = g_configInput.m_inputVideoDirectory;
+    std::vector<std::string> videoNameList;
+
+     // strtok - string to token conversion
+    char* pch = strtok ( g_configInput.m_inputVideoListCStr, "," );
+    while ( pch != NULL )
+    {
+        videoNameList.push_back( pch );
+        pch = strtok( NULL, "," );
+    }
+
+    for ( unsigned int i = 0; i < videoNameList.size(); i++ )
+    {
+        Tracker::ParameterSweep sweep( inputVideoDirectory, videoNameList[i] );
+
+        sweep.Initialize( g_configInput, g_configInput.m_sweepFileName );
+        sweep.Process( startFrameIndex, endFrameIndex );
+    }
+}
+
+// Processes the time segments, or in the two-pass mode the active intervals,
+// of each input video in parallel
+void RunSegmentedVideos( const int startFrameIndex, const int endFrameIndex )
+{
+    std::string inputVideoDirectory = g_configInput.m_inputVideoDirectory;
+    std::vector<std::string> videoNameList;
+
+     // strtok - string to token conversion
+    char* pch = strtok ( g_configInput.m_inputVideoListCStr, "," );
+    while ( pch != NULL )
+    {
+        videoNameList.push_back( pch );
+        pch = strtok( NULL, "," );
+    }
+
+    for ( unsigned int i = 0; i < videoNameList.size(); i++ )
+    {
+        Tracker::SegmentedVideo segmentedVideo( inputVideoDirectory, videoNameList[i] );
+
+        segmentedVideo.Initialize( g_configInput, startFrameIndex, endFrameIndex );
+        segmentedVideo.Process( );
+    }
+}
+
+// Processes the jobs of the manifest, creating each camera only when it is
+// due, so that the number of jobs is not limited by the config strings
+void RunJobManifest( const int startFrameIndex, const int endFrameIndex )
+{
+    Tracker::JobManifest manifest( g_configInput.m_inputVideoDirectory, startFrameIndex, endFrameIndex );
+    manifest.Open( g_configInput.m_jobManifest );
+
+    // read the pipeline profiles the jobs and camera IDs refer to
+    Tracker::PipelineProfiles profiles( g_configInput );
+    profiles.Load( g_configInput.m_profileFileName, g_configInput.m_cameraProfiles );
+
+    Tracker::ManifestCameras cameras( manifest, profiles, g_configInput.m_schedulerThreads > 0 );
+
+    // share the workers between a bounded number of open jobs
+    if ( g_configInput.m_schedulerThreads > 0 )
+    {
+        const int maxActiveCameras = ( g_configInput.m_jobMaxActiveCameras > 0 ) ? g_configInput.m_jobMaxActiveCameras
+                                                                                  : 2 * g_configInput.m_schedulerThreads;
+
+        Tracker::CameraScheduler scheduler( g_configInput.m_schedulerThreads );
+        scheduler.SetCameraSource( &cameras, maxActiveCameras );
+        scheduler.Run( );
+        return;
+    }
+
+    Tracker::CameraPtr pCamera;
+    int                jobStartFrameIndex;
+    int                jobEndFrameIndex;
+    while ( cameras.NextCamera( pCamera, jobStartFrameIndex, jobEndFrameIndex ) )
+    {
+        pCamera->Initialize( );
+        pCamera->Process( jobStartFrameIndex, jobEndFrameIndex );
+        cameras.CameraFinished( pCamera );
+
+        // close the camera before the next job opens
+        pCamera.reset();
+    }
+}
+
+// Runs the jobs of the manifest, or of the video list, in worker processes;
+// fails when a job has been quarantined
+int RunCoordinator( int argc, char* argv[], const int startFrameIndex, const int endFrameIndex )
+{
+    // the workers get the configuration of the coordinator
+    std::vector<std::string> workerArguments( argv + 1, argv + argc );
+
+    Tracker::JobCoordinator coordinator( argv[0], workerArguments );
+    coordinator.Initialize( g_configInput, startFrameIndex, endFrameIndex );
+
+    return coordinator.Run( ) > 0 ? 1 : 0;
+}
+
+// Runs one job of a coordinator, logging into the log file of the job
+//      -j <job line> -d config.cfg [-p ...]
+int RunCoordinatorJob( int argc, char* argv[] )
+{
+    // the remaining arguments configure the job
+    std::vector<char*> configArguments( 1, argv[0] );
+    for ( int i = 3; i < argc; i++ )
+    {
+        configArguments.push_back( argv[i] );
+    }
+
+    int result = Configure( (int)configArguments.size(), &configArguments[0] );
+    ASSERT_TRUE( result == 0 );
+
+    return Tracker::RunWorkerJob( argv[2], g_configInput, g_configInput.m_startFrameIndex, GetEndFrameIndex() );
+}
+
+// Prints the records of a record file selected by
+//      -q <record file> [id=<id>] [frames=<first>:<last>] [box=<x>,<y>,<width>,<height>]
+int RunRecordQuery( int argc, char* argv[] )
+{
+    Tracker::RecordFilter filter;
+    for ( int i = 3; i < argc; i++ )
+    {
+        if ( sscanf( argv[i], "id=%d", &filter.m_id ) == 1 )
+        {
+            filter.m_hasId = true;
+        }
+        else if ( sscanf( argv[i], "frames=%d:%d", &filter.m_firstFrame, &filter.m_lastFrame ) == 2 )
         {
-            cameraPtrList[i]->EnableOriginalImageDownScale( );
         }
+        else if ( sscanf( argv[i], "box=%d,%d,%d,%d", &filter.m_box.x, &filter.m_box.y, &filter.m_box.width, &filter.m_box.height ) == 4 )
+        {
+            filter.m_hasBox = true;
+        }
+        else
+        {
+            fprintf( stderr, "Unknown query term '%s'\n", argv[i] );
+            return 1;
+        }
+    }
 
-        cameraPtrList[i]->SetFGTrainFrame( g_configInput.m_numberFGTrainFrames );
-        cameraPtrList[i]->SetFgDetectionModule( g_configInput.m_fgDetectorMod );
-        cameraPtrList[i]->SetBlobDetectionModule( g_configInput.m_blobDetectorMod );
-        cameraPtrList[i]->SetBlobTrackerModule( g_configInput.m_blobTrackerMod );
-        cameraPtrList[i]->SetBlobAnalysisModule( g_configInput.m_blobAnalysisMod );
-        cameraPtrList[i]->SetBlobProcessingModule( g_configInput.m_blobProcessingMod );
+    const int64 startTicks = cv::getTickCount();
 
-        cameraPtrList[i]->Initialize(  g_configInput.m_fgDetectionParams,
-                                       g_configInput.m_blobDetectionParams,
-                                       g_configInput.m_blobTrackerParams,
-                                       g_configInput.m_blobAnalysisParams,
-                                       g_configInput.m_blobPostProcessingParams );
+    Tracker::RecordQuery query( argv[2] );
+    if ( !query.IsOpened() )
+    {
+        fprintf( stderr, "Unable to read record file %s\n", argv[2] );
+        return 1;
     }
-}
\ No newline at end of file
+
+    std::vector<Tracker::BlobRecord> records;
+    query.Find( filter, records );
+
+    const double elapsedMs = ( cv::getTickCount() - startTicks ) * 1000.0 / cv::getTickFrequency();
+
+    for ( unsigned int i = 0; i < records.size(); i++ )
+    {
+        const Tracker::BlobRecord& record = records[i];
+        printf( "%d %d %d %d %d %d\t%g\n",
+                record.m_frameNumber, record.m_x, record.m_y, record.m_width, record.m_height, record.m_id, record.m_timestamp );
+    }
+
+    fprintf( stderr, "%u records in %.1f ms\n", (unsigned int)records.size(), elapsedMs );
+    return 0;
+}
+
+// Runs a regression suite, recording its golden files in update mode
+//      -r <suite file> [update] -d config.cfg [-p ...]
+int RunRegressionSuite( int argc, char* argv[] )
+{
+    const bool update = argc >= 4 && strcmp( argv[3], "update" ) == 0;
+
+    // the remaining arguments configure the suite
+    std::vector<char*> configArguments( 1, argv[0] );
+    for ( int i = update ? 4 : 3; i < argc; i++ )
+    {
+        configArguments.push_back( argv[i] );
+    }
+
+    int failures = 0;
+    try
+    {
+        int result = Configure( (int)configArguments.size(), &configArguments[0] );
+        ASSERT_TRUE( result == 0 );
+
+        std::string logFile( g_configInput.m_outputVideoDirectory );
+        Tracker::Logger::Instance().Open( logFile + "/" + g_configInput.m_logFileName );
+        Tracker::Logger::Instance().SetLevel( g_configInput.m_logLevel );
+
+        Tracker::RegressionSuite suite( argv[2] );
+        suite.Initialize( g_configInput );
+        failures = suite.Run( update );
+    }
+    catch ( std::exception e )
+    {
+        LOG( e.what() );
+        failures = 1;
+    }
+
+    Tracker::Logger::Instance().Close();
+
+    return failures > 0 ? 1 : 0;
+}